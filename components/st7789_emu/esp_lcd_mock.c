@@ -0,0 +1,400 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_mock.h"
+#include "driver/gpio.h"
+
+#define ESP_LCD_MOCK_MAX_PANELS  8            // Максимум панелей (линий CS) на шине
+#define ESP_LCD_MOCK_MAX_BUSES   2            // Максимум шин i80 (для выключения отложенного режима)
+
+// Передача пикселей, поставленная в очередь интерфейса (отложенный режим): данные читаются при выполнении, как DMA
+typedef struct {
+    int cmd;
+    const void *data;
+    size_t size;
+} mock_trans_t;
+
+// Шина i80: ограничения, общие для всех устройств, и устройство, чью передачу шина выполняла последней
+struct esp_lcd_i80_bus_t {
+    size_t bus_width;
+    size_t max_transfer_bytes;
+    int num_devices;
+    esp_lcd_panel_io_handle_t devices[ESP_LCD_MOCK_MAX_PANELS];
+    esp_lcd_panel_io_handle_t cur_device;
+};
+
+// Интерфейс панели на шине: своя линия CS, частота, callback окончания передачи и очередь trans_queue_depth
+struct esp_lcd_panel_io_t {
+    esp_lcd_i80_bus_handle_t bus;
+    int cs_gpio_num;
+    bool swap_color_bytes;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void *user_ctx;
+    st7789_emu_t *emu;
+    mock_trans_t *queue;        // Кольцо передач глубиной queue_size
+    size_t queue_size, head, count;
+};
+
+static bool mock_deferred = false;
+static esp_lcd_i80_bus_handle_t mock_buses[ESP_LCD_MOCK_MAX_BUSES];
+
+// Панель ST7789: смещения и пин сброса, как в драйвере esp_lcd
+struct esp_lcd_panel_t {
+    esp_lcd_panel_io_handle_t io;
+    int reset_gpio_num;
+    int x_gap, y_gap;
+};
+
+// Эмуляторы привязаны к линии CS и переживают пересоздание интерфейса (например, при смене pclk)
+static struct {
+    int cs_gpio_num;
+    st7789_emu_t *emu;
+} mock_panels[ESP_LCD_MOCK_MAX_PANELS];
+static int mock_panel_count = 0;
+
+static st7789_emu_t *get_or_create_emu(int cs_gpio_num, uint32_t pclk_hz, size_t bus_width) {
+    for (int i = 0; i < mock_panel_count; i++) {
+        if (mock_panels[i].cs_gpio_num == cs_gpio_num) {
+            st7789_emu_set_pclk(mock_panels[i].emu, pclk_hz);
+            return mock_panels[i].emu;
+        }
+    }
+    if (mock_panel_count >= ESP_LCD_MOCK_MAX_PANELS) {
+        return NULL;
+    }
+    st7789_emu_config_t config = {
+        .pclk_hz = pclk_hz,
+        .bus_width = bus_width,
+        .trans_overhead_ns = ESP_LCD_MOCK_TRANS_OVERHEAD_NS,
+    };
+    st7789_emu_t *emu = st7789_emu_create(&config);
+    if (!emu) {
+        return NULL;
+    }
+    mock_panels[mock_panel_count].cs_gpio_num = cs_gpio_num;
+    mock_panels[mock_panel_count].emu = emu;
+    mock_panel_count++;
+    return emu;
+}
+
+// Выполняет передачу: пиксели уходят в эмулятор (с перестановкой байтов, если её делает LCD_CAM),
+// затем вызывается callback окончания, как из ISR драйвера i80
+static esp_err_t mock_execute(esp_lcd_panel_io_handle_t io, int cmd, const void *color, size_t color_size) {
+    if (!io->swap_color_bytes) {
+        st7789_emu_tx_color(io->emu, cmd, color, color_size);
+    } else {
+        // swap_color_bytes: контроллер LCD_CAM меняет местами байты каждой пары на выходе
+        const uint8_t *src = color;
+        uint8_t *swapped = malloc(color_size);
+        if (!swapped) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (size_t i = 0; i + 1 < color_size; i += 2) {
+            swapped[i] = src[i + 1];
+            swapped[i + 1] = src[i];
+        }
+        if (color_size & 1) {
+            swapped[color_size - 1] = src[color_size - 1];
+        }
+        st7789_emu_tx_color(io->emu, cmd, swapped, color_size);
+        free(swapped);
+    }
+    if (io->on_color_trans_done) {
+        io->on_color_trans_done(io, NULL, io->user_ctx);
+    }
+    return ESP_OK;
+}
+
+// Завершает следующую передачу шины так же, как ISR драйвера i80 выбирает её: сначала из очереди устройства,
+// чья передача шла последней, и только когда она пуста — из очередей остальных устройств
+static bool mock_complete_next(esp_lcd_i80_bus_handle_t bus) {
+    esp_lcd_panel_io_handle_t io = bus->cur_device;
+    if (!io || io->count == 0) {
+        io = NULL;
+        for (int i = 0; i < bus->num_devices && !io; i++) {
+            if (bus->devices[i]->count) {
+                io = bus->devices[i];
+            }
+        }
+        if (!io) {
+            return false;
+        }
+    }
+    mock_trans_t trans = io->queue[io->head];
+    io->head = (io->head + 1) % io->queue_size;
+    io->count--;
+    bus->cur_device = io;
+    // ISR драйвера начинает следующую передачу сразу по окончании этой: если очередь устройства опустела,
+    // шина уже перешла к устройству с ожидающими передачами, и новая передача этого устройства встанет за ними
+    if (io->count == 0) {
+        for (int i = 0; i < bus->num_devices; i++) {
+            if (bus->devices[i]->count) {
+                bus->cur_device = bus->devices[i];
+                break;
+            }
+        }
+    }
+    mock_execute(io, trans.cmd, trans.data, trans.size);
+    return true;
+}
+
+// Ожидание окончания всех передач интерфейса (шина тем временем выполняет и передачи других устройств)
+static void mock_wait_io(esp_lcd_panel_io_handle_t io) {
+    while (io->count) {
+        mock_complete_next(io->bus);
+    }
+}
+
+void esp_lcd_mock_set_deferred(bool deferred) {
+    mock_deferred = deferred;
+    if (!deferred) {
+        for (int b = 0; b < ESP_LCD_MOCK_MAX_BUSES; b++) {
+            while (mock_buses[b] && mock_complete_next(mock_buses[b])) {
+            }
+        }
+    }
+}
+
+size_t esp_lcd_mock_pump(esp_lcd_i80_bus_handle_t bus, size_t max_trans) {
+    size_t done = 0;
+    while (bus && done < max_trans && mock_complete_next(bus)) {
+        done++;
+    }
+    return done;
+}
+
+size_t esp_lcd_mock_pending(esp_lcd_panel_io_handle_t io) {
+    return io ? io->count : 0;
+}
+
+esp_err_t esp_lcd_new_i80_bus(const esp_lcd_i80_bus_config_t *bus_config, esp_lcd_i80_bus_handle_t *ret_bus) {
+    if (!bus_config || !ret_bus || (bus_config->bus_width != 8 && bus_config->bus_width != 16)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int slot = 0;
+    while (slot < ESP_LCD_MOCK_MAX_BUSES && mock_buses[slot]) {
+        slot++;
+    }
+    if (slot == ESP_LCD_MOCK_MAX_BUSES) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_lcd_i80_bus_handle_t bus = calloc(1, sizeof(struct esp_lcd_i80_bus_t));
+    if (!bus) {
+        return ESP_ERR_NO_MEM;
+    }
+    bus->bus_width = bus_config->bus_width;
+    bus->max_transfer_bytes = bus_config->max_transfer_bytes;
+    mock_buses[slot] = bus;
+    *ret_bus = bus;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_del_i80_bus(esp_lcd_i80_bus_handle_t bus) {
+    if (!bus) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (bus->num_devices > 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (int b = 0; b < ESP_LCD_MOCK_MAX_BUSES; b++) {
+        if (mock_buses[b] == bus) {
+            mock_buses[b] = NULL;
+        }
+    }
+    free(bus);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_io_i80(esp_lcd_i80_bus_handle_t bus, const esp_lcd_panel_io_i80_config_t *io_config,
+                                   esp_lcd_panel_io_handle_t *ret_io) {
+    if (!bus || !io_config || !ret_io || io_config->pclk_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (bus->num_devices >= ESP_LCD_MOCK_MAX_PANELS) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_lcd_panel_io_handle_t io = calloc(1, sizeof(struct esp_lcd_panel_io_t));
+    if (!io) {
+        return ESP_ERR_NO_MEM;
+    }
+    io->queue_size = io_config->trans_queue_depth ? io_config->trans_queue_depth : 1;
+    io->queue = calloc(io->queue_size, sizeof(mock_trans_t));
+    io->emu = get_or_create_emu(io_config->cs_gpio_num, io_config->pclk_hz, bus->bus_width);
+    if (!io->queue || !io->emu) {
+        free(io->queue);
+        free(io);
+        return ESP_ERR_NO_MEM;
+    }
+    io->bus = bus;
+    io->cs_gpio_num = io_config->cs_gpio_num;
+    io->swap_color_bytes = io_config->flags.swap_color_bytes;
+    io->on_color_trans_done = io_config->on_color_trans_done;
+    io->user_ctx = io_config->user_ctx;
+    bus->devices[bus->num_devices++] = io;
+    *ret_io = io;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io) {
+    if (!io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Как драйвер i80: интерфейс удаляется после окончания своих передач
+    mock_wait_io(io);
+    esp_lcd_i80_bus_handle_t bus = io->bus;
+    for (int i = 0; i < bus->num_devices; i++) {
+        if (bus->devices[i] == io) {
+            memmove(&bus->devices[i], &bus->devices[i + 1], (bus->num_devices - i - 1) * sizeof(bus->devices[0]));
+            break;
+        }
+    }
+    bus->num_devices--;
+    if (bus->cur_device == io) {
+        bus->cur_device = NULL;
+    }
+    free(io->queue);
+    free(io);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io,
+                                                    const esp_lcd_panel_io_callbacks_t *cbs, void *user_ctx) {
+    if (!io || !cbs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    io->on_color_trans_done = cbs->on_color_trans_done;
+    io->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size) {
+    if (!io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Как драйвер i80: команда ждёт окончания всех передач своего интерфейса (lcd_cmd -1 — только ожидание).
+    // В обычном режиме передачи выполняются синхронно, и очередь всегда пуста
+    mock_wait_io(io);
+    st7789_emu_tx_param(io->emu, lcd_cmd, param, param_size);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size) {
+    if (!io || (color_size && !color)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (color_size > io->bus->max_transfer_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (!mock_deferred) {
+        return mock_execute(io, lcd_cmd, color, color_size);
+    }
+
+    // Очередь интерфейса полна: как драйвер i80, постановка ждёт окончания одной из своих передач,
+    // а шина тем временем может выполнять и передачи других устройств
+    while (io->count >= io->queue_size) {
+        mock_complete_next(io->bus);
+    }
+    bool bus_idle = true;
+    for (int i = 0; i < io->bus->num_devices; i++) {
+        bus_idle &= io->bus->devices[i]->count == 0;
+    }
+    if (bus_idle) {
+        io->bus->cur_device = io; // Передача на свободной шине начинается сразу
+    }
+    io->queue[(io->head + io->count) % io->queue_size] = (mock_trans_t){.cmd = lcd_cmd, .data = color, .size = color_size};
+    io->count++;
+    return ESP_OK;
+}
+
+st7789_emu_t *esp_lcd_mock_get_emu(esp_lcd_panel_io_handle_t io) {
+    return io ? io->emu : NULL;
+}
+
+esp_err_t esp_lcd_new_panel_st7789(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                   esp_lcd_panel_handle_t *ret_panel) {
+    if (!io || !panel_dev_config || !ret_panel || panel_dev_config->bits_per_pixel != 16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_lcd_panel_handle_t panel = calloc(1, sizeof(struct esp_lcd_panel_t));
+    if (!panel) {
+        return ESP_ERR_NO_MEM;
+    }
+    panel->io = io;
+    panel->reset_gpio_num = panel_dev_config->reset_gpio_num;
+    *ret_panel = panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_wait_io(panel->io);
+    if (panel->reset_gpio_num >= 0) {
+        gpio_set_level(panel->reset_gpio_num, 0);
+        gpio_set_level(panel->reset_gpio_num, 1);
+        st7789_emu_hw_reset(panel->io->emu);
+    } else {
+        st7789_emu_tx_param(panel->io->emu, 0x01, NULL, 0); // SWRESET
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t colmod = 0x55;
+    const uint8_t madctl = 0x00;
+    mock_wait_io(panel->io);
+    st7789_emu_tx_param(panel->io->emu, 0x11, NULL, 0); // SLPOUT
+    st7789_emu_tx_param(panel->io->emu, 0x36, &madctl, 1);
+    st7789_emu_tx_param(panel->io->emu, 0x3A, &colmod, 1);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free(panel);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data) {
+    if (!panel || x_start >= x_end || y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    x_start += panel->x_gap;
+    x_end += panel->x_gap;
+    y_start += panel->y_gap;
+    y_end += panel->y_gap;
+    uint8_t caset[4] = {x_start >> 8, x_start & 0xFF, (x_end - 1) >> 8, (x_end - 1) & 0xFF};
+    uint8_t raset[4] = {y_start >> 8, y_start & 0xFF, (y_end - 1) >> 8, (y_end - 1) & 0xFF};
+    esp_lcd_panel_io_tx_param(panel->io, 0x2A, caset, sizeof(caset));
+    esp_lcd_panel_io_tx_param(panel->io, 0x2B, raset, sizeof(raset));
+    return esp_lcd_panel_io_tx_color(panel->io, 0x2C, color_data,
+                                     (size_t)(x_end - x_start) * (y_end - y_start) * sizeof(uint16_t));
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    panel->x_gap = x_gap;
+    panel->y_gap = y_gap;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off) {
+    if (!panel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_wait_io(panel->io);
+    st7789_emu_tx_param(panel->io->emu, on_off ? 0x29 : 0x28, NULL, 0);
+    return ESP_OK;
+}
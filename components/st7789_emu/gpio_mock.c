@@ -0,0 +1,85 @@
+#include <stdbool.h>
+#include "driver/gpio.h"
+
+static uint8_t gpio_levels[GPIO_MOCK_PIN_COUNT];
+static bool gpio_isr_service_installed = false;
+static struct {
+    gpio_isr_t handler;
+    void *arg;
+} gpio_isr_handlers[GPIO_MOCK_PIN_COUNT];
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    if (!config || (config->pin_bit_mask >> GPIO_MOCK_PIN_COUNT)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_MOCK_PIN_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[gpio_num] = 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num < 0 || gpio_num >= GPIO_MOCK_PIN_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_MOCK_PIN_COUNT) {
+        return 0;
+    }
+    return gpio_levels[gpio_num];
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    if (gpio_isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    gpio_isr_service_installed = true;
+    return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void) {
+    for (int i = 0; i < GPIO_MOCK_PIN_COUNT; i++) {
+        gpio_isr_handlers[i].handler = NULL;
+    }
+    gpio_isr_service_installed = false;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    if (gpio_num < 0 || gpio_num >= GPIO_MOCK_PIN_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!gpio_isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    gpio_isr_handlers[gpio_num].handler = isr_handler;
+    gpio_isr_handlers[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_MOCK_PIN_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_isr_handlers[gpio_num].handler = NULL;
+    return ESP_OK;
+}
+
+void gpio_mock_trigger(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_MOCK_PIN_COUNT) {
+        return;
+    }
+    gpio_levels[gpio_num] = 1;
+    if (gpio_isr_handlers[gpio_num].handler) {
+        gpio_isr_handlers[gpio_num].handler(gpio_isr_handlers[gpio_num].arg);
+    }
+    gpio_levels[gpio_num] = 0;
+}
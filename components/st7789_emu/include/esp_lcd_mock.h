@@ -0,0 +1,44 @@
+#pragma once
+
+// Хост-сборка: доступ к эмулятору ST7789, подключённому к интерфейсу i80
+
+#include "esp_lcd_panel_io.h"
+#include "st7789_emu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_LCD_MOCK_TRANS_OVERHEAD_NS 2000   // Накладные расходы драйвера i80 на одну транзакцию
+
+/**
+ * Возвращает эмулятор панели, подключённый к интерфейсу (один эмулятор на линию CS).
+ */
+st7789_emu_t *esp_lcd_mock_get_emu(esp_lcd_panel_io_handle_t io);
+
+/**
+ * Режим отложенного окончания передач. Выключен: tx_color сразу передаёт пиксели эмулятору и вызывает
+ * callback окончания до возврата. Включён: tx_color только ставит передачу в очередь интерфейса глубиной
+ * trans_queue_depth, а данные читаются из буфера и callback вызывается позже, как после DMA: когда очередь
+ * полна, при tx_param (в том числе lcd_cmd -1) или в esp_lcd_mock_pump. Следующая передача выбирается,
+ * как в драйвере i80: из очереди устройства, чья передача шла последней, затем из остальных; выбор делается
+ * в момент окончания передачи, поэтому передача, поставленная после того, как очередь устройства опустела,
+ * ждёт очередей других устройств.
+ * Выключение режима завершает все ожидающие передачи.
+ */
+void esp_lcd_mock_set_deferred(bool deferred);
+
+/**
+ * Выполняет до max_trans ожидающих передач шины (DMA успел их передать, пока CPU ждал).
+ * @return Количество выполненных передач
+ */
+size_t esp_lcd_mock_pump(esp_lcd_i80_bus_handle_t bus, size_t max_trans);
+
+/**
+ * Количество передач в очереди интерфейса: поставлены, но ещё не выполнены.
+ */
+size_t esp_lcd_mock_pending(esp_lcd_panel_io_handle_t io);
+
+#ifdef __cplusplus
+}
+#endif
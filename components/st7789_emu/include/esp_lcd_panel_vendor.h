@@ -0,0 +1,26 @@
+#pragma once
+
+// Хост-сборка: создание панели ST7789 поверх эмулятора
+
+#include "esp_lcd_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int reset_gpio_num;
+    esp_lcd_color_space_t color_space;
+    uint32_t bits_per_pixel;
+    struct {
+        unsigned int reset_active_high: 1;
+    } flags;
+    void *vendor_config;
+} esp_lcd_panel_dev_config_t;
+
+esp_err_t esp_lcd_new_panel_st7789(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                   esp_lcd_panel_handle_t *ret_panel);
+
+#ifdef __cplusplus
+}
+#endif
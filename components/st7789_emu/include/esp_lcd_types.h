@@ -0,0 +1,30 @@
+#pragma once
+
+// Хост-сборка: подмножество типов esp_lcd, необходимое main/main.c
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
+typedef struct esp_lcd_i80_bus_t *esp_lcd_i80_bus_handle_t;
+
+typedef enum {
+    LCD_CLK_SRC_PLL160M,
+    LCD_CLK_SRC_DEFAULT = LCD_CLK_SRC_PLL160M,
+} lcd_clock_source_t;
+
+typedef enum {
+    ESP_LCD_COLOR_SPACE_RGB,
+    ESP_LCD_COLOR_SPACE_BGR,
+} esp_lcd_color_space_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Геометрия контроллера ST7789 и видимой области панели T-Display-S3
+#define ST7789_EMU_RAM_W        240           // Ширина памяти контроллера (столбцы)
+#define ST7789_EMU_RAM_H        320           // Высота памяти контроллера (строки)
+#define ST7789_EMU_GLASS_W      170           // Ширина видимой области панели
+#define ST7789_EMU_GLASS_H      320           // Высота видимой области панели
+#define ST7789_EMU_GLASS_X0     35            // Первый столбец памяти, попадающий на стекло
+
+// Биты регистра MADCTL (0x36)
+#define ST7789_EMU_MADCTL_MY    0x80          // Инверсия порядка строк
+#define ST7789_EMU_MADCTL_MX    0x40          // Инверсия порядка столбцов
+#define ST7789_EMU_MADCTL_MV    0x20          // Обмен строк и столбцов
+
+#define ST7789_EMU_OSC_HZ       10000000      // Генератор развёртки (частота кадров из PORCTRL и FRCTRL2)
+
+// Биты второго параметра RAMCTRL (0xB0)
+#define ST7789_EMU_RAMCTRL_ENDIAN 0x08        // Пиксель RGB565 передаётся младшим байтом вперёд
+
+typedef struct st7789_emu_t st7789_emu_t;
+
+// Параметры шины, от которых зависит расчёт времени передачи
+typedef struct {
+    uint32_t pclk_hz;            // Частота WR (один такт на байт при 8-битной шине)
+    uint32_t bus_width;          // Ширина шины в битах (8 или 16)
+    uint32_t trans_overhead_ns;  // Накладные расходы на одну транзакцию (подготовка DMA, прерывание)
+} st7789_emu_config_t;
+
+// Счётчики трафика, принятого эмулятором
+typedef struct {
+    uint64_t cmd_tx;             // Командных транзакций (tx_param)
+    uint64_t color_tx;           // Транзакций с пиксельными данными (tx_color)
+    uint64_t cmd_bytes;          // Байт команд и параметров
+    uint64_t color_bytes;        // Байт пиксельных данных
+    uint64_t pixels;             // Записанных пикселей
+    uint64_t offscreen_pixels;   // Пикселей, записанных вне стекла (ошибка смещений)
+    uint64_t bus_time_ns;        // Расчётное время занятости шины
+    uint32_t data_crc;           // CRC32 записанных пикселей (значения RGB565 в порядке little-endian, как в буфере CPU)
+} st7789_emu_stats_t;
+
+// Режим отображения, декодированный из команд панели
+typedef struct {
+    bool partial;                // PTLON (до NORON)
+    bool idle;                   // IDMON: 8 цветов
+    bool scroll;                 // Режим прокрутки (VSCSAD)
+    int active_lines;            // Показываемых строк развёртки (полоса PTLAR при частичном показе)
+    uint32_t frame_mhz;          // Частота кадров развёртки (мГц) по PORCTRL (0xB2) и FRCTRL2 (0xC6)
+} st7789_emu_display_mode_t;
+
+/**
+ * Создаёт эмулятор панели ST7789 в состоянии после аппаратного сброса.
+ * @param config Параметры шины
+ * @return Эмулятор или NULL при нехватке памяти
+ */
+st7789_emu_t *st7789_emu_create(const st7789_emu_config_t *config);
+
+/**
+ * Удаляет эмулятор.
+ */
+void st7789_emu_delete(st7789_emu_t *emu);
+
+/**
+ * Аппаратный сброс: регистры возвращаются к значениям по умолчанию, память панели не меняется.
+ */
+void st7789_emu_hw_reset(st7789_emu_t *emu);
+
+/**
+ * Меняет частоту шины (пересоздание интерфейса i80 с другим pclk_hz).
+ */
+void st7789_emu_set_pclk(st7789_emu_t *emu, uint32_t pclk_hz);
+
+/**
+ * Принимает командную транзакцию: команду и её параметры.
+ * @param cmd Код команды, -1 — без команды
+ */
+void st7789_emu_tx_param(st7789_emu_t *emu, int cmd, const uint8_t *params, size_t len);
+
+/**
+ * Принимает транзакцию с пиксельными данными в порядке байт на шине.
+ * @param cmd Код команды (0x2C RAMWR, 0x3C RAMWRC), -1 — продолжение записи
+ */
+void st7789_emu_tx_color(st7789_emu_t *emu, int cmd, const uint8_t *data, size_t len);
+
+/**
+ * Возвращает пиксель RGB565 памяти панели в физических координатах стекла (без учёта прокрутки).
+ */
+uint16_t st7789_emu_get_pixel(const st7789_emu_t *emu, int x, int y);
+
+/**
+ * Возвращает пиксель, который видно на стекле: в режиме прокрутки (VSCSAD) строки области
+ * VSCRDEF показывают память со сдвигом, до NORON/PTLON; при частичном показе строки вне PTLAR чёрные,
+ * в режиме IDMON от каждого канала остаётся старший бит. В обычном режиме совпадает с st7789_emu_get_pixel.
+ */
+uint16_t st7789_emu_get_display_pixel(const st7789_emu_t *emu, int x, int y);
+
+/**
+ * Возвращает режим отображения: частичный показ (PTLAR/PTLON), 8 цветов (IDMON), частоту кадров.
+ */
+void st7789_emu_get_display_mode(const st7789_emu_t *emu, st7789_emu_display_mode_t *mode);
+
+/**
+ * Возвращает видимую область панели: ST7789_EMU_GLASS_W x ST7789_EMU_GLASS_H пикселей RGB565, построчно.
+ */
+const uint16_t *st7789_emu_framebuffer(const st7789_emu_t *emu);
+
+/**
+ * Записывает видимую область в обход шины и счётчиков: проверки возвращают так стекло
+ * к снимку, сделанному через st7789_emu_framebuffer.
+ */
+void st7789_emu_set_glass(st7789_emu_t *emu, const uint16_t *pixels);
+
+/**
+ * Возвращает последние параметры команды (для проверки регистров, например MADCTL).
+ * @return Длина параметров
+ */
+size_t st7789_emu_get_reg(const st7789_emu_t *emu, uint8_t cmd, uint8_t *params, size_t max_len);
+
+void st7789_emu_get_stats(const st7789_emu_t *emu, st7789_emu_stats_t *stats);
+void st7789_emu_reset_stats(st7789_emu_t *emu);
+
+#ifdef __cplusplus
+}
+#endif
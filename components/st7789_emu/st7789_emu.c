@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <string.h>
+#include "st7789_emu.h"
+
+#define ST7789_EMU_MAX_PARAMS   16            // Максимальная длина сохраняемых параметров команды
+
+// Программная модель ST7789: декодирует команды адресации, MADCTL и RAMWR
+// и хранит видимую область памяти панели
+struct st7789_emu_t {
+    st7789_emu_config_t config;
+    uint8_t regs[256][ST7789_EMU_MAX_PARAMS]; // Последние параметры каждой команды
+    uint8_t reg_len[256];                     // Длина последних параметров
+    uint8_t madctl;                           // MADCTL (0x36)
+    uint16_t col_start, col_end;              // CASET (0x2A)
+    uint16_t row_start, row_end;              // RASET (0x2B)
+    uint16_t col, row;                        // Текущий указатель записи
+    uint8_t pending_byte;                     // Старший байт пикселя, ожидающий младшего
+    bool has_pending_byte;
+    bool sleeping;                            // SLPIN/SLPOUT
+    bool display_on;                          // DISPOFF/DISPON
+    uint16_t scroll_tfa, scroll_vsa, scroll_bfa; // VSCRDEF (0x33): неподвижные строки сверху, область прокрутки, снизу
+    uint16_t scroll_vsp;                      // VSCSAD (0x37): строка памяти у верхнего края области прокрутки
+    bool scroll_mode;                         // Режим прокрутки (VSCSAD), выход — NORON/PTLON
+    uint16_t partial_start, partial_end;      // PTLAR (0x30): строки памяти частичного показа
+    bool partial_mode;                        // PTLON/NORON
+    bool idle_mode;                           // IDMON/IDMOFF: 8 цветов
+    uint16_t fb[ST7789_EMU_GLASS_W * ST7789_EMU_GLASS_H];
+    st7789_emu_stats_t stats;
+};
+
+/**
+ * Время передачи байт по шине с учётом накладных расходов на транзакцию.
+ */
+static uint64_t bus_time_ns(const st7789_emu_t *emu, size_t bytes) {
+    uint32_t bytes_per_cycle = emu->config.bus_width / 8;
+    uint64_t cycles = (bytes + bytes_per_cycle - 1) / bytes_per_cycle;
+    return emu->config.trans_overhead_ns + cycles * 1000000000ULL / emu->config.pclk_hz;
+}
+
+/**
+ * Продолжает CRC32 (полином 0xEDB88320, как esp_rom_crc32_le) на один байт.
+ */
+static uint32_t crc32_byte(uint32_t crc, uint8_t byte) {
+    crc = ~crc ^ byte;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+    }
+    return ~crc;
+}
+
+/**
+ * Записывает пиксель по текущему указателю и продвигает указатель внутри окна CASET/RASET.
+ * Адреса столбца и строки переводятся в физические координаты по MADCTL:
+ * MV меняет оси местами, затем MX и MY инвертируют столбцы и строки памяти.
+ */
+static void write_pixel(st7789_emu_t *emu, uint16_t color) {
+    int x = emu->col;
+    int y = emu->row;
+    if (emu->madctl & ST7789_EMU_MADCTL_MV) {
+        int t = x;
+        x = y;
+        y = t;
+    }
+    if (emu->madctl & ST7789_EMU_MADCTL_MX) {
+        x = ST7789_EMU_RAM_W - 1 - x;
+    }
+    if (emu->madctl & ST7789_EMU_MADCTL_MY) {
+        y = ST7789_EMU_RAM_H - 1 - y;
+    }
+
+    int gx = x - ST7789_EMU_GLASS_X0;
+    if (gx >= 0 && gx < ST7789_EMU_GLASS_W && y >= 0 && y < ST7789_EMU_GLASS_H) {
+        emu->fb[y * ST7789_EMU_GLASS_W + gx] = color;
+    } else {
+        emu->stats.offscreen_pixels++;
+    }
+    emu->stats.pixels++;
+    emu->stats.data_crc = crc32_byte(crc32_byte(emu->stats.data_crc, color & 0xFF), color >> 8);
+
+    // Указатель идёт по столбцам окна, затем переходит на следующую строку и по кругу
+    if (emu->col >= emu->col_end) {
+        emu->col = emu->col_start;
+        emu->row = (emu->row >= emu->row_end) ? emu->row_start : emu->row + 1;
+    } else {
+        emu->col++;
+    }
+}
+
+static uint16_t be16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+st7789_emu_t *st7789_emu_create(const st7789_emu_config_t *config) {
+    st7789_emu_t *emu = calloc(1, sizeof(st7789_emu_t));
+    if (!emu) {
+        return NULL;
+    }
+    emu->config = *config;
+    if (emu->config.bus_width == 0) {
+        emu->config.bus_width = 8;
+    }
+    st7789_emu_hw_reset(emu);
+    return emu;
+}
+
+void st7789_emu_delete(st7789_emu_t *emu) {
+    free(emu);
+}
+
+void st7789_emu_hw_reset(st7789_emu_t *emu) {
+    memset(emu->regs, 0, sizeof(emu->regs));
+    memset(emu->reg_len, 0, sizeof(emu->reg_len));
+    emu->madctl = 0;
+    emu->col_start = 0;
+    emu->col_end = ST7789_EMU_RAM_W - 1;
+    emu->row_start = 0;
+    emu->row_end = ST7789_EMU_RAM_H - 1;
+    emu->col = 0;
+    emu->row = 0;
+    emu->has_pending_byte = false;
+    emu->sleeping = true;
+    emu->display_on = false;
+    emu->scroll_tfa = 0;
+    emu->scroll_vsa = ST7789_EMU_RAM_H;
+    emu->scroll_bfa = 0;
+    emu->scroll_vsp = 0;
+    emu->scroll_mode = false;
+    emu->partial_start = 0;
+    emu->partial_end = ST7789_EMU_RAM_H - 1;
+    emu->partial_mode = false;
+    emu->idle_mode = false;
+}
+
+void st7789_emu_set_pclk(st7789_emu_t *emu, uint32_t pclk_hz) {
+    emu->config.pclk_hz = pclk_hz;
+}
+
+void st7789_emu_tx_param(st7789_emu_t *emu, int cmd, const uint8_t *params, size_t len) {
+    if (cmd < 0 && len == 0) {
+        return; // Ожидание окончания передач: на шину ничего не выходит
+    }
+    emu->stats.cmd_tx++;
+    emu->stats.cmd_bytes += (cmd >= 0 ? 1 : 0) + len;
+    emu->stats.bus_time_ns += bus_time_ns(emu, (cmd >= 0 ? 1 : 0) + len);
+    if (cmd < 0) {
+        return;
+    }
+
+    emu->has_pending_byte = false;
+    size_t n = len < ST7789_EMU_MAX_PARAMS ? len : ST7789_EMU_MAX_PARAMS;
+    if (params && n) {
+        memcpy(emu->regs[cmd], params, n);
+    }
+    emu->reg_len[cmd] = n;
+
+    switch (cmd) {
+        case 0x01: // SWRESET
+            st7789_emu_hw_reset(emu);
+            break;
+        case 0x10: // SLPIN
+            emu->sleeping = true;
+            break;
+        case 0x11: // SLPOUT
+            emu->sleeping = false;
+            break;
+        case 0x12: // PTLON: частичный показ, прокрутка выключается
+            emu->scroll_mode = false;
+            emu->partial_mode = true;
+            break;
+        case 0x13: // NORON: обычный режим, прокрутка и частичный показ выключаются
+            emu->scroll_mode = false;
+            emu->partial_mode = false;
+            break;
+        case 0x28: // DISPOFF
+            emu->display_on = false;
+            break;
+        case 0x29: // DISPON
+            emu->display_on = true;
+            break;
+        case 0x2A: // CASET
+            if (len >= 4) {
+                emu->col_start = be16(&params[0]);
+                emu->col_end = be16(&params[2]);
+            }
+            break;
+        case 0x2B: // RASET
+            if (len >= 4) {
+                emu->row_start = be16(&params[0]);
+                emu->row_end = be16(&params[2]);
+            }
+            break;
+        case 0x2C: // RAMWR без данных: только сброс указателя
+            emu->col = emu->col_start;
+            emu->row = emu->row_start;
+            break;
+        case 0x30: // PTLAR
+            if (len >= 4) {
+                emu->partial_start = be16(&params[0]);
+                emu->partial_end = be16(&params[2]);
+            }
+            break;
+        case 0x38: // IDMOFF
+            emu->idle_mode = false;
+            break;
+        case 0x39: // IDMON
+            emu->idle_mode = true;
+            break;
+        case 0x33: // VSCRDEF: сумма трёх областей должна равняться числу строк памяти
+            if (len >= 6 && be16(&params[0]) + be16(&params[2]) + be16(&params[4]) == ST7789_EMU_RAM_H) {
+                emu->scroll_tfa = be16(&params[0]);
+                emu->scroll_vsa = be16(&params[2]);
+                emu->scroll_bfa = be16(&params[4]);
+            }
+            break;
+        case 0x36: // MADCTL
+            if (len >= 1) {
+                emu->madctl = params[0];
+            }
+            break;
+        case 0x37: // VSCSAD: адрес отсчитывается в строках памяти, MADCTL на него не влияет
+            if (len >= 2) {
+                emu->scroll_vsp = be16(&params[0]);
+                emu->scroll_mode = true;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void st7789_emu_tx_color(st7789_emu_t *emu, int cmd, const uint8_t *data, size_t len) {
+    if (cmd >= 0 && cmd != 0x2C && cmd != 0x3C) {
+        // Данные после другой команды считаются её параметрами
+        st7789_emu_tx_param(emu, cmd, data, len);
+        return;
+    }
+
+    emu->stats.color_tx++;
+    emu->stats.cmd_bytes += cmd >= 0 ? 1 : 0;
+    emu->stats.color_bytes += len;
+    emu->stats.bus_time_ns += bus_time_ns(emu, (cmd >= 0 ? 1 : 0) + len);
+
+    if (cmd == 0x2C) {
+        // RAMWR: запись с начала окна
+        emu->col = emu->col_start;
+        emu->row = emu->row_start;
+        emu->has_pending_byte = false;
+    }
+
+    // Пиксель RGB565 передаётся старшим байтом вперёд, с RAMCTRL ENDIAN — младшим
+    bool little_endian = emu->reg_len[0xB0] >= 2 && (emu->regs[0xB0][1] & ST7789_EMU_RAMCTRL_ENDIAN);
+    for (size_t i = 0; i < len; i++) {
+        if (!emu->has_pending_byte) {
+            emu->pending_byte = data[i];
+            emu->has_pending_byte = true;
+        } else {
+            write_pixel(emu, little_endian ? (uint16_t)((data[i] << 8) | emu->pending_byte)
+                                           : (uint16_t)((emu->pending_byte << 8) | data[i]));
+            emu->has_pending_byte = false;
+        }
+    }
+}
+
+uint16_t st7789_emu_get_pixel(const st7789_emu_t *emu, int x, int y) {
+    if (x < 0 || x >= ST7789_EMU_GLASS_W || y < 0 || y >= ST7789_EMU_GLASS_H) {
+        return 0;
+    }
+    return emu->fb[y * ST7789_EMU_GLASS_W + x];
+}
+
+uint16_t st7789_emu_get_display_pixel(const st7789_emu_t *emu, int x, int y) {
+    // Вне полосы частичного показа стекло чёрное (область без отображения)
+    if (emu->partial_mode && (y < emu->partial_start || y > emu->partial_end)) {
+        return 0;
+    }
+    // Строки области прокрутки показывают память начиная с VSCSAD и по кругу внутри области
+    if (emu->scroll_mode && y >= emu->scroll_tfa && y < emu->scroll_tfa + emu->scroll_vsa) {
+        y = emu->scroll_vsp + (y - emu->scroll_tfa);
+        if (y >= emu->scroll_tfa + emu->scroll_vsa) {
+            y -= emu->scroll_vsa;
+        }
+    }
+    uint16_t color = st7789_emu_get_pixel(emu, x, y);
+    if (emu->idle_mode) {
+        // 8 цветов: каждый канал либо выключен, либо максимален по своему старшему биту
+        color = ((color & 0x8000) ? 0xF800 : 0) | ((color & 0x0400) ? 0x07E0 : 0) | ((color & 0x0010) ? 0x001F : 0);
+    }
+    return color;
+}
+
+void st7789_emu_get_display_mode(const st7789_emu_t *emu, st7789_emu_display_mode_t *mode) {
+    // Частота кадров: 10 МГц / ((320 + FPA + BPA) * (250 + RTNA * 16)); без команд — значения после сброса
+    uint32_t bpa = emu->reg_len[0xB2] >= 2 ? emu->regs[0xB2][0] & 0x7F : 0x0C;
+    uint32_t fpa = emu->reg_len[0xB2] >= 2 ? emu->regs[0xB2][1] & 0x7F : 0x0C;
+    uint32_t rtna = emu->reg_len[0xC6] >= 1 ? emu->regs[0xC6][0] & 0x1F : 0x0F;
+    mode->frame_mhz = (uint32_t)(ST7789_EMU_OSC_HZ * 1000ULL / ((ST7789_EMU_RAM_H + fpa + bpa) * (250 + rtna * 16)));
+    mode->partial = emu->partial_mode;
+    mode->idle = emu->idle_mode;
+    mode->scroll = emu->scroll_mode;
+    mode->active_lines = emu->partial_mode ? (emu->partial_end >= emu->partial_start ? emu->partial_end - emu->partial_start + 1 : 0)
+                                           : ST7789_EMU_GLASS_H;
+}
+
+const uint16_t *st7789_emu_framebuffer(const st7789_emu_t *emu) {
+    return emu->fb;
+}
+
+void st7789_emu_set_glass(st7789_emu_t *emu, const uint16_t *pixels) {
+    memcpy(emu->fb, pixels, sizeof(emu->fb));
+}
+
+size_t st7789_emu_get_reg(const st7789_emu_t *emu, uint8_t cmd, uint8_t *params, size_t max_len) {
+    size_t n = emu->reg_len[cmd] < max_len ? emu->reg_len[cmd] : max_len;
+    memcpy(params, emu->regs[cmd], n);
+    return n;
+}
+
+void st7789_emu_get_stats(const st7789_emu_t *emu, st7789_emu_stats_t *stats) {
+    *stats = emu->stats;
+}
+
+void st7789_emu_reset_stats(st7789_emu_t *emu) {
+    memset(&emu->stats, 0, sizeof(emu->stats));
+}
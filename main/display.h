@@ -0,0 +1,612 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "lcd_perf.h"
+#include "lcd_trace.h"
+#include "lcd_panel.h"
+
+/**
+ * Вывод LVGL на панели драйвера lcd_panel.h (main.c): буферы и задача рендеринга, синхронизация с TE,
+ * объединение областей, консоль, режимы питания, заставка и замеры. Настройки, типы и состояние
+ * объявлены здесь, чтобы хост-проверки (host_checks.c) обращались к ним из своей единицы трансляции.
+ */
+
+// Вторая панель ST7789 на той же шине i80 (Kconfig): своя линия CS, ориентация и дисплей LVGL;
+// данные, DC, WR, RD и подсветка общие, сброс — командой SWRESET через свою линию CS
+#if CONFIG_DISPLAY_SECOND_PANEL
+#define LCD_PANEL2_ENABLE   1
+#define LCD_PANEL2_PIN_CS   CONFIG_DISPLAY_SECOND_PANEL_CS // Пин Chip Select второй панели
+#else
+#define LCD_PANEL2_ENABLE   0
+#define LCD_PANEL2_PIN_CS   (-1)
+#endif
+#define LCD_PANEL2_ORIENTATION DISPLAY_ORIENTATION_0 // Ориентация второй панели (портрет 170x320)
+#define LVGL_PANEL2_BUFFER_LINES 20           // Строк (по LCD_V_RES пикселей) в каждом из двух буферов LVGL второй панели
+
+// Старт панели: время от входа в app_main до первого кадра на подсвеченном экране
+#define LCD_FAST_BOOT       1                 // 1 — подсветка только после первого кадра в памяти панели, ожидание Sleep Out
+                                              // параллельно с init_lvgl, без лога каждой команды и без очистки 108 КБ в init_display
+                                              // Влияние: 0 — подсветка сразу, паузы 100 + 100 + 120 мс и очистка до LVGL; мусор из памяти панели виден.
+#define SPLASH_ENABLE       1                 // 1 — в init_display вывести образ из раздела SPLASH_PARTITION (tools/png2splash.py)
+                                              // Влияние: при LCD_FAST_BOOT заставка становится первым кадром, и подсветка включается сразу после неё.
+#define SPLASH_PARTITION    "splash"          // Имя раздела с образом заставки в partitions.csv
+#if LCD_FAST_BOOT
+#define LCD_BOOT_LOGI(...)  ESP_LOGD(TAG, __VA_ARGS__) // Шаги старта: каждая строка лога — несколько мс UART на 115200
+#else
+#define LCD_BOOT_LOGI(...)  ESP_LOGI(TAG, __VA_ARGS__)
+#endif
+
+// Конфигурация буфера LVGL для рендеринга
+#define LVGL_BUFFER_LINES   CONFIG_DISPLAY_LVGL_BUF_LINES // Количество строк (по LCD_H_RES пикселей) в буфере LVGL (Kconfig, по умолчанию 40)
+                                              // Влияние: меньшее значение (например, 10) снижает потребление памяти,
+                                              // но увеличивает количество операций рендеринга, что может замедлить вывод.
+                                              // Большое значение (например, 170) увеличивает память, но ускоряет рендеринг.
+#if CONFIG_DISPLAY_LVGL_BUF_PSRAM
+#define LVGL_BUFFER_PLACEMENT LVGL_BUF_PSRAM  // Размещение буферов LVGL (Kconfig): PSRAM
+#elif CONFIG_DISPLAY_LVGL_BUF_FULL_FRAME
+#define LVGL_BUFFER_PLACEMENT LVGL_BUF_FULL_FRAME // Размещение буферов LVGL (Kconfig): на весь экран
+#else
+#define LVGL_BUFFER_PLACEMENT LVGL_BUF_INTERNAL_DMA // Размещение буферов LVGL (Kconfig): внутренняя DMA-память
+#endif
+#define LVGL_FULL_FRAME_INTERNAL_HEADROOM (64 * 1024) // Сколько внутренней памяти должно остаться после полнокадровых буферов
+                                              // Влияние: если меньше, полнокадровые буферы уходят в PSRAM.
+#define LVGL_BUFFER_BENCHMARK 0               // 1 — перед демонстрацией прогнать lv_demo_benchmark на нескольких раскладках буферов
+#define LVGL_FLUSH_ASYNC    1                 // Асинхронный вывод: lv_disp_flush_ready вызывается из ISR завершения DMA
+                                              // Влияние: при 0 lvgl_flush_cb ждёт окончания передачи, и второй буфер
+                                              // LVGL простаивает; при 1 рендеринг во второй буфер идёт параллельно с передачей первого.
+#define LVGL_STATS_PERIOD_MS 5000             // Период вывода статистики кадров в лог (мс)
+#define LCD_PERF            1                 // 1 — замеры этапов вывода (lcd_perf.h) и строка "Perf" в статистике; дёшевы и для релиза
+#define LCD_TRACE           0                 // 1 — двоичная трасса событий вывода в USB-Serial-JTAG (lcd_trace.h, tools/trace2perfetto.py)
+#define LCD_TRACE_PACKET_EVENTS 32            // Событий в пакете трассы (16 байт каждое)
+#define LCD_TRACE_PACKET_BYTES (sizeof(lcd_trace_header_t) + LCD_TRACE_PACKET_EVENTS * sizeof(lcd_trace_event_t) + sizeof(uint32_t))
+#define LCD_TRACE_PERIOD_MS 10                // Период выгрузки кольца трассы (мс)
+#define LCD_TRACE_HEAP_MS   100               // Период события кучи в трассе (мс)
+#define LCD_TRACE_TX_BUFFER 4096              // Буфер передачи драйвера USB-Serial-JTAG (байт)
+#define LCD_TRACE_TASK_STACK 3072             // Стек задачи выгрузки трассы (байт)
+#define LCD_TRACE_TASK_PRIORITY 1             // Ниже задачи рендеринга: выгрузка не должна сдвигать кадры
+#define LCD_TRACE_FILE      "lcd_trace.bin"   // Хост: трасса пишется в этот файл вместо USB
+#define LVGL_TASK_STACK     6144              // Стек задачи рендеринга LVGL (байт)
+#define LVGL_TASK_PRIORITY  4                 // Приоритет задачи рендеринга (выше app_main)
+#if CONFIG_FREERTOS_NUMBER_OF_CORES > 1
+#define LVGL_TASK_CORE      1                 // Задача рендеринга на втором ядре; ядро 0 остаётся системным задачам и app_main
+#else
+#define LVGL_TASK_CORE      tskNO_AFFINITY    // Одноядерная сборка (в том числе хост)
+#endif
+#define LVGL_TASK_MAX_SLEEP_MS 500            // Максимальный сон задачи рендеринга, когда у LVGL нет готовых таймеров
+#define LVGL_UI_QUEUE_LEN   8                 // Глубина очереди обновлений интерфейса от других задач
+#define LVGL_FLUSH_WAIT_MS  100               // Максимальное ожидание окончания DMA в lvgl_wait_cb (страховка от потерянного прерывания)
+#define EDGE_STRIP_WIDTH    30                // Ширина цветных полос тестового кадра (пиксели)
+#define RGB565_BENCHMARK    0                 // 1 — при старте сверить ядра rgb565 с эталоном и вывести микробенчмарк
+                                              // Влияние: на хосте выполняется всегда (векторных инструкций там нет, сравнивается C).
+
+// Объединение областей перерисовки LVGL перед lvgl_flush_cb
+#define LVGL_COALESCE       1                 // 1 — объединять и делить области кадра по модели стоимости шины
+                                              // Влияние: меньше окон CASET/RASET/RAMWR на кадр; лишние пиксели передаются,
+                                              // только если это дешевле накладных расходов отдельного flush при текущей pclk.
+#define LVGL_COALESCE_FLUSH_OVERHEAD_US 25    // Накладные расходы одного flush помимо пикселей: команды окна, постановка DMA, прерывание (мкс)
+#define LVGL_COALESCE_CMD_BYTES 11            // Байт команд окна на flush: CASET и RASET по 5, RAMWR 1
+#define LVGL_STRESS_CHECK   0                 // 1 — после теста ориентаций запустить lv_demo_stress и сравнить вывод с объединением и без
+                                              // Влияние: демо остаётся на экране; на хосте проверка выполняется всегда.
+#define LVGL_STRESS_WINDOW_MS 2000            // Окно замера одного режима (мс)
+#define LVGL_STRESS_ROUNDS  3                 // Чередований режимов (с объединением и без)
+
+// Время LVGL берётся напрямую из esp_timer_get_time() (LV_TICK_CUSTOM), отдельная задача тиков не нужна
+#if !CONFIG_LV_TICK_CUSTOM
+#error "LVGL time is taken from esp_timer: enable CONFIG_LV_TICK_CUSTOM (see sdkconfig.defaults)"
+#endif
+#define LVGL_TICK_TEST      0                 // 1 — при старте замерить точность анимации и время простоя, освобождённое без задачи тиков
+                                              // Влияние: замер занимает около 3 секунд; на хосте выполняется всегда.
+#define LVGL_TICK_TEST_ANIM_MS 1000           // Длительность тестовой анимации (мс)
+#define LVGL_TICK_TEST_WINDOW_MS 1000         // Окно замера простоя с прежней задачей тиков и без неё (мс)
+#define LVGL_TICK_TEST_MAX_ERROR_MS 2         // Допустимое отклонение значения анимации и тика LVGL от esp_timer (мс)
+#define LVGL_LEGACY_TICK_MS 10                // Период прежней задачи тиков (lv_tick_inc(10) каждые 10 мс), воспроизводимой для сравнения
+
+// Синхронизация вывода с сигналом TE (tearing effect) панели
+#define LCD_PIN_TE          -1                // Пин TE панели; на T-Display-S3 не разведён (-1).
+                                              // На хосте при -1 импульсы TE имитирует таймер с периодом LCD_TE_PERIOD_US.
+#if LCD_PIN_TE >= 0 || CONFIG_IDF_TARGET_LINUX
+#define LCD_TE_SYNC         1                 // 1 — крупные кадры LVGL начинают RAMWR только после импульса TE
+                                              // Влияние: без синхронизации запись памяти обгоняет развёртку или отстаёт от неё,
+                                              // и на анимации виден горизонтальный разрыв кадра.
+#else
+#define LCD_TE_SYNC         0                 // Без вывода TE синхронизироваться не с чем: таймер не связан с развёрткой панели по фазе,
+                                              // и ожидание его импульса только задерживало бы кадр, не убирая разрыв.
+#endif
+#if LCD_TE_SYNC && LCD_PIN_TE < 0 && !CONFIG_IDF_TARGET_LINUX
+#error "LCD_TE_SYNC needs the panel TE line in LCD_PIN_TE: a timer is not in phase with the panel scan"
+#endif
+#define LCD_TE_PERIOD_US    16667             // Период кадра панели при FRCTRL2=0x0F (60 Гц)
+#define LCD_TE_SYNC_MIN_PIXELS (LCD_H_RES * LCD_V_RES / 4) // Кадр LVGL не меньше этой площади ждёт TE; мелкие обновления выводятся сразу
+#define LCD_TE_RACE_BEAM    0                 // 1 — в ориентациях 0°/180° (и 90°/270° при программном повороте) полосы кадра выводятся вслед за строкой развёртки, без ожидания TE
+                                              // Влияние: кадр начинает выводиться раньше, но если шина медленнее развёртки,
+                                              // развёртка догонит запись (счётчик beam late).
+#define LCD_TE_TIMEOUT_MS   50                // Нет импульса TE дольше этого времени — кадр выводится без синхронизации
+
+// Поворот в 90°/270° (Kconfig): MADCTL переставляет оси в контроллере, либо панель остаётся в порядке развёртки 0°,
+// а draw_area поворачивает пиксели области на CPU (rgb565_rotate90) перед DMA
+#if CONFIG_DISPLAY_ROTATION_SOFTWARE
+#define LCD_ROTATION_MODE   LCD_ROTATION_SOFTWARE // Включается в init_lvgl вместе с буфером поворота
+#else
+#define LCD_ROTATION_MODE   LCD_ROTATION_MADCTL
+#endif
+#define LCD_ROTATION_BENCHMARK 0              // 1 — сравнить оба способа поворота на разных высотах буфера LVGL (на хосте всегда)
+#define LCD_ROTATION_BENCH_LINES {10, 20, 40, 80, 160} // Высоты буфера LVGL в замере; полнокадровые буферы проверяются отдельно
+#define LCD_ROTATION_BENCH_FRAMES 5           // Полных кадров на способ и высоту буфера
+
+// Текстовая консоль с аппаратной прокруткой (console_start/console_print)
+#define CONSOLE_FONT        (&lv_font_montserrat_14) // Шрифт консоли (глифы LVGL, рисуются без рендерера LVGL)
+#define CONSOLE_LINE_HEIGHT 16                // Высота строки консоли (пиксели); равна line_height шрифта
+#if LCD_V_RES % CONSOLE_LINE_HEIGHT != 0
+#error "CONSOLE_LINE_HEIGHT must divide LCD_V_RES, otherwise the scroll ring does not close"
+#endif
+#define CONSOLE_MAX_ROWS    (LCD_V_RES / CONSOLE_LINE_HEIGHT) // Строк консоли на экране в 0°/180°
+#define CONSOLE_MAX_COLS    63                // Максимальная длина хранимой строки (символов)
+#define CONSOLE_FG_COLOR    0x07E0            // Цвет текста консоли (зелёный)
+#define CONSOLE_BG_COLOR    0x0000            // Фон консоли
+#define CONSOLE_DEMO        0                 // 1 — после теста ориентаций вывести хвост лога консолью в каждой ориентации
+#define CONSOLE_DEMO_LINES  48                // Строк лога в демонстрации на ориентацию
+
+// Режимы пониженного потребления панели (lcd_set_power_mode): частичный показ, 8 цветов, частота кадров.
+// Частота кадров ST7789: 10 МГц / ((320 + FPA + BPA) * (250 + RTNA * 16)), FPA/BPA из PORCTRL, RTNA из FRCTRL2.
+#define LCD_PANEL_OSC_HZ    10000000          // Генератор развёртки панели
+#define LCD_PORCH_LINES     (0x0C + 0x0C)     // BPA + FPA из PORCTRL (0xB2) в lcd_st7789v
+#define LCD_FRCTRL2_MIN_RATE 0x1F             // Наибольший RTNA: 39 Гц (FRSEN=0, FRCTRL2 действует и в partial/idle)
+// Оценка мощности панели без подсветки: порядок величин по даташиту ST7789V, а не измерение
+#define LCD_POWER_LOGIC_UW  3000              // Логика и преобразователи напряжения, от режима не зависят (мкВт)
+#define LCD_POWER_SCAN_UW   15000             // Развёртка всех 320 строк при 60 Гц в 65K цветах (мкВт)
+#define LCD_POWER_IDLE_PERCENT 40             // Доля мощности развёртки в режиме 8 цветов (выходы источников — ключи)
+#define LCD_POWER_BUS_UW_PER_MBPS 2000        // Шина i80 и DMA на 1 МБ/с переданных пикселей (мкВт)
+#define LCD_POWER_CHECK_UPDATES_HZ 1          // Частота полных обновлений в оценке (статусный экран: раз в секунду)
+#define LCD_POWER_DEMO      0                 // 1 — после консоли показать режимы из lcd_power_presets по LCD_POWER_DEMO_MS
+#define LCD_POWER_DEMO_MS   3000              // Время показа одного режима в демонстрации
+#define LCD_POWER_PRESETS   6                 // Режимов в lcd_power_presets (демонстрация и проверка)
+#define LCD_FILL_TEST_DEMO  1                 // 1 — перед поворотами LVGL вывести тест заливки и полос в каждой ориентации
+                                              // Влияние: сами повороты в демонстрации идут без очистки экрана (rotate_display).
+
+// Замер частоты пиксельного тактирования (режим в app_main перед демонстрацией)
+#define LCD_PCLK_SWEEP      0                 // 1 — перебрать частоты LCD_PCLK_SWEEP_HZ и вывести таблицу пропускной способности
+                                              // Влияние: режим занимает несколько секунд при старте; на хосте выполняется всегда.
+#define LCD_PCLK_SWEEP_HZ   {2000000, 5000000, 8000000, 10000000, 13333333, 16000000, 20000000} // Проверяемые частоты (Гц)
+                                              // Частоты из ряда 160 МГц / N (N — целое): LCD_CAM делит PLL без дробной части.
+#define LCD_PCLK_SWEEP_FRAMES 5               // Кадров на частоту для усреднения времени
+
+// Параметры хост-сборки (linux): панель эмулируется, паузы демонстрации не нужны
+#if CONFIG_IDF_TARGET_LINUX
+#define DEMO_PAUSE_DIV      50                // Паузы демонстрации сокращаются в 50 раз: смотреть на экран некому
+#define HOST_MAIN_LOOP_ITERATIONS 10          // Периодов статистики главного цикла перед выходом из процесса
+#define HOST_DEFERRED_DMA   1                 // 1 — эмулятор завершает передачи отложенно, как DMA (esp_lcd_mock_set_deferred):
+                                              // проверки идут, пока передачи ещё в очереди; 0 — каждая передача завершается
+                                              // до возврата из esp_lcd_panel_io_tx_color, и гонки с DMA не видны.
+#else
+#define DEMO_PAUSE_DIV      1                 // На устройстве паузы демонстрации без изменений
+#endif
+
+// Режим отображения панели: частичный показ полосы строк развёртки, 8 цветов, частота кадров
+typedef struct {
+    bool partial;               // PTLON: показывается только полоса partial_start..partial_end, остальное чёрное
+    int16_t partial_start;      // Начало полосы вдоль оси развёртки (320 пикселей): логический Y в 0°/180°, X в 90°/270°
+    int16_t partial_end;        // Конец полосы включительно
+    bool idle;                  // IDMON: 8 цветов, от каждого канала остаётся старший бит
+    uint8_t frctrl2;            // FRCTRL2 (0xC6): RTNA в битах 4..0
+} lcd_power_mode_t;
+
+// Оценка режима: что панель показывает, сколько стоит полное обновление и сколько потребляет
+typedef struct {
+    uint32_t frame_mhz;         // Частота кадров развёртки (мГц)
+    int active_lines;           // Строк развёртки, которые показываются
+    uint32_t update_bytes;      // Байт пикселей на полное обновление видимой части
+    uint32_t update_us;         // Время шины на полное обновление при текущей pclk
+    uint32_t panel_uw;          // Панель: логика и развёртка (мкВт)
+    uint32_t bus_uw;            // Шина при LCD_POWER_CHECK_UPDATES_HZ полных обновлениях в секунду (мкВт)
+} lcd_power_estimate_t;
+
+// Режим для демонстрации и проверки: полоса задана вдоль оси развёртки, в 90°/270° это логический X
+typedef struct {
+    const char *name;           // Название для лога
+    display_orientation_t orientation; // Ориентация, в которой показывается режим
+    lcd_power_mode_t mode;      // Режим отображения
+} lcd_power_preset_t;
+
+// Способ поворота в ориентациях 90° и 270° (в 0° и 180° панель всегда поворачивает сама)
+typedef enum {
+    LCD_ROTATION_MADCTL,     // MADCTL (MV) меняет порядок записи в память панели; запись идёт поперёк строк развёртки
+    LCD_ROTATION_SOFTWARE,   // Панель в порядке развёртки 0°, области поворачиваются на CPU; запись идёт вдоль строк
+} lcd_rotation_mode_t;
+
+// Статистика вывода LVGL: время кадра и перекрытие рендеринга с передачей DMA.
+// Поля с пометкой ISR обновляются из lvgl_flush_done_cb.
+typedef struct {
+    uint32_t frames;            // Количество выведенных кадров (ISR)
+    uint32_t flushes;           // Количество переданных областей
+    int64_t frame_start_us;     // Начало текущего кадра (первый flush кадра)
+    int64_t last_frame_us;      // Длительность последнего кадра: от первого flush до окончания DMA последней области (ISR)
+    int64_t submit_us;          // Момент постановки текущей области в очередь DMA
+    int64_t wait_us;            // Момент, когда LVGL закончил рендеринг и начал ждать освобождения буфера
+    volatile int64_t done_us;   // Момент окончания DMA последней области (ISR)
+    int64_t xfer_us;            // Суммарное время передачи DMA (ISR)
+    int64_t overlap_us;         // Суммарное время, когда CPU рендерил, пока DMA передавал предыдущую область
+    volatile bool pending;      // Ожидается завершение DMA области LVGL
+    volatile bool last_area;    // Текущая область — последняя в кадре
+} lvgl_flush_stats_t;
+
+// Замеры этапов вывода (LCD_PERF). Длительности внутри одной задачи — в тактах CPU, интервалы между задачей
+// рендеринга и ISR — в мкс esp_timer: счётчики тактов двух ядер не согласованы.
+typedef enum {
+    LCD_PERF_RENDER,            // Рисование кадра LVGL без flush и ожидания буфера (такты)
+    LCD_PERF_FLUSH,             // lvgl_flush_cb до постановки области в очередь, с ожиданием TE (такты)
+    LCD_PERF_SET_AREA,          // set_draw_area в draw_area: CASET/RASET (такты)
+    LCD_PERF_TX_COLOR,          // Постановка RAMWR с пикселями в очередь DMA в draw_area (такты)
+    LCD_PERF_DMA,               // Область LVGL от постановки в очередь до прерывания окончания (мкс, ISR)
+    LCD_PERF_FRAME,             // Кадр от начала рендеринга до окончания DMA последней области (мкс, ISR)
+    LCD_PERF_INTERVAL,          // Между окончаниями соседних кадров, распределение FPS (мкс, ISR)
+    LCD_PERF_BYTES,             // Байт пикселей на flush
+    LCD_PERF_HIST_COUNT
+} lcd_perf_hist_id_t;
+
+typedef struct {
+    lcd_perf_hist_t hist[LCD_PERF_HIST_COUNT];
+    lcd_perf_ring_t ring;       // Последние кадры (ISR)
+    uint32_t frames;            // Выведено кадров (ISR)
+    uint32_t dropped;           // Пропущено периодов обновления (ISR)
+    int64_t last_done_us;       // Окончание предыдущего кадра (ISR)
+    uint32_t refr_start;        // Начало текущего вызова lvgl_refr_timer_cb (такты)
+    int64_t refr_start_us;      // То же в мкс, для длительности кадра в ISR
+    uint32_t excluded;          // Такты текущего кадра в flush и ожидании буфера, не входящие в рендеринг
+    uint32_t wait_start;        // Начало ожидания в lvgl_wait_cb (такты)
+    bool waiting;               // lvgl_wait_cb вызван после последнего flush
+    uint32_t bytes;             // Байт пикселей текущего кадра
+    uint16_t flushes;           // Областей текущего кадра
+    lcd_perf_frame_t last;      // Кадр, последняя область которого передаётся; дописывает ISR
+    int64_t last_start_us;      // Начало рендеринга кадра last
+    uint32_t period_us;         // Период обновления LVGL для подсчёта пропусков в ISR
+} lcd_perf_t;
+
+// Снимок замеров для lcd_perf_get
+typedef struct {
+    lcd_perf_hist_t hist[LCD_PERF_HIST_COUNT];
+    lcd_perf_frame_t recent[LCD_PERF_RING_LEN]; // Последние кадры, от старых к новым
+    size_t recent_count;
+    uint32_t frames;            // Выведено кадров
+    uint32_t dropped;           // Пропущено периодов обновления
+} lcd_perf_snapshot_t;
+
+// Источник импульсов TE и статистика синхронизации вывода.
+// Поля с пометкой ISR обновляются в обработчике импульса TE.
+typedef struct {
+    SemaphoreHandle_t sem;      // Выдаётся на каждый импульс TE
+    esp_timer_handle_t timer;   // Таймер, заменяющий TE (LCD_PIN_TE < 0)
+    volatile int64_t last_us;   // Момент последнего импульса (ISR)
+    volatile uint32_t pulses;   // Количество импульсов (ISR)
+    volatile int64_t period_sum_us; // Сумма интервалов между импульсами (ISR)
+    volatile int64_t period_min_us; // Минимальный интервал (ISR)
+    volatile int64_t period_max_us; // Максимальный интервал (ISR)
+    int64_t nominal_period_us;  // Период кадра по FRCTRL2, пока импульсов мало для измерения
+    bool frame_synced;          // Текущий кадр LVGL выводится по TE
+    uint32_t synced_frames;     // Кадров, начатых по импульсу TE
+    uint32_t timeouts;          // Ожиданий TE, закончившихся по таймауту
+    int64_t wait_sum_us;        // Суммарное время ожидания TE
+    int64_t latency_sum_us;     // Сумма задержек от импульса TE до начала RAMWR
+    int64_t latency_max_us;     // Максимальная задержка от импульса TE до начала RAMWR
+    uint32_t beam_waits;        // Полос, задержанных до прохода строки развёртки
+    uint32_t beam_late;         // Полос, передача которых не успевает до возврата развёртки (возможен разрыв)
+} lcd_te_t;
+
+// Обновление интерфейса, переданное задаче рендеринга через очередь
+typedef void (*lvgl_ui_fn_t)(void *arg);
+typedef struct {
+    lvgl_ui_fn_t fn;            // Выполняется в задаче рендеринга под блокировкой LVGL
+    void *arg;                  // Аргумент fn
+    int64_t post_us;            // Момент постановки в очередь
+} lvgl_ui_msg_t;
+
+// Служба рендеринга LVGL: задача, блокировка, очередь обновлений и статистика пробуждений
+typedef struct {
+    TaskHandle_t task;          // Задача рендеринга
+    SemaphoreHandle_t mutex;    // Рекурсивная блокировка LVGL
+    QueueHandle_t queue;        // Очередь lvgl_ui_msg_t
+    SemaphoreHandle_t flush_sem; // Выдаётся из lvgl_flush_done_cb; на нём спит lvgl_wait_cb
+    uint32_t wakeups_timer;     // Пробуждений по сроку таймера LVGL
+    uint32_t wakeups_post;      // Пробуждений по обновлению из очереди
+    int64_t sleep_ms;           // Суммарное запрошенное время сна
+    uint32_t posts;             // Выполненных обновлений
+    uint32_t posts_dropped;     // Обновлений, не поместившихся в очередь
+    int64_t post_latency_sum_us; // Сумма задержек от lvgl_post до вывода кадра с обновлением
+    int64_t post_latency_max_us; // Максимальная задержка от lvgl_post до вывода кадра
+} lvgl_render_t;
+
+// Объединение областей, помеченных LVGL к перерисовке, перед выводом кадра.
+// Стоимость области считается в байтах шины: пиксели плюс накладные расходы каждого flush в пересчёте на байты.
+typedef struct {
+    bool enabled;               // Объединение включено (можно переключать во время работы)
+    uint32_t frames;            // Кадров, прошедших через объединение
+    uint32_t areas_in;          // Областей от LVGL
+    uint32_t areas_out;         // Областей после объединения и деления
+    uint32_t merges;            // Пар областей, заменённых охватывающей
+    uint32_t splits;            // Областей, разрезанных, чтобы не передавать перекрытие дважды
+    uint32_t lvgl_joins;        // Пар, которые объединил бы lv_refr_join_area; объединены заранее, чтобы учесть их в стоимости
+    uint64_t pixel_bytes_in;    // Байт пикселей в областях от LVGL
+    uint64_t pixel_bytes_out;   // Байт пикселей после объединения
+    int64_t bytes_saved;        // Выигрыш по модели в байтах шины (с учётом накладных расходов на flush)
+} lvgl_coalesce_t;
+
+// Текстовая консоль: новые строки появляются снизу, старые уходят вверх.
+// В 0°/180° логическая вертикаль совпадает со строками памяти, и экран сдвигает VSCSAD;
+// в 90°/270° прокрутка ST7789 двигала бы изображение по горизонтали, поэтому строки перерисовываются.
+typedef struct {
+    bool active;                // Консоль владеет панелью (между console_start и console_stop)
+    bool hw_scroll;             // Прокрутка через VSCSAD, иначе перерисовка всех строк
+    int hor_res;                // Ширина строки в пикселях
+    int rows;                   // Строк на экране
+    uint32_t lines;             // Выведено строк с console_start
+    uint16_t scroll;            // Последнее значение VSCSAD
+    uint16_t *line_buf;         // Пиксели одной строки в порядке байт буфера (DMA)
+    char text[CONSOLE_MAX_ROWS][CONSOLE_MAX_COLS + 1]; // Кольцо строк на экране (для перерисовки)
+    uint64_t pixel_bytes;       // Байт пикселей, переданных консолью
+    uint32_t redraws;           // Перерисовок всех строк (без аппаратной прокрутки)
+} console_t;
+
+// Размещение буферов рендеринга LVGL
+typedef enum {
+    LVGL_BUF_INTERNAL_DMA,      // Внутренняя SRAM с доступом DMA
+    LVGL_BUF_PSRAM,             // PSRAM: адрес и размер выровнены по LCD_PSRAM_TRANS_ALIGN
+    LVGL_BUF_FULL_FRAME,        // Два буфера на весь экран: во внутренней памяти, если остаётся запас, иначе в PSRAM
+} lvgl_buf_placement_t;
+
+// Фактическая раскладка буферов LVGL (заполняется lvgl_buffers_configure)
+typedef struct {
+    lvgl_buf_placement_t placement; // Запрошенное размещение
+    int lines;                  // Строк по LCD_H_RES пикселей в одном буфере
+    size_t buf_pixels;          // Пикселей в одном буфере
+    size_t buf_bytes;           // Выделено байт на один буфер (с учётом выравнивания)
+    uint32_t caps;              // Возможности памяти, из которой выделены буферы (MALLOC_CAP_*)
+    lv_color_t *buf1, *buf2;    // Буферы рендеринга
+    uint16_t *rotate_buf;       // Буфер программного поворота (LCD_ROTATION_SOFTWARE) того же размера, иначе NULL
+} lvgl_buf_layout_t;
+
+// Состояние вывода (main.c)
+extern lcd_panel_t lcd_panel_main;         // Основная панель
+extern lcd_power_mode_t lcd_power;         // Текущий режим отображения
+extern uint64_t lcd_power_clipped_bytes;   // Байт пикселей LVGL, не отрисованных вне полосы частичного показа
+extern lvgl_flush_stats_t flush_stats;     // Статистика кадров LVGL
+extern console_t console;                  // Текстовая консоль
+extern lvgl_coalesce_t lvgl_coalesce;      // Объединение областей перерисовки LVGL
+extern lv_disp_t *lvgl_disp;               // Дисплей LVGL основной панели
+extern const lcd_power_preset_t lcd_power_presets[LCD_POWER_PRESETS]; // Пресеты демо режимов отображения
+
+// Функции main.c, которыми пользуются хост-проверки (host_checks.c)
+
+/**
+ * Применяет ориентацию дисплея (0°, 90°, 180°, 270°) без очистки экрана: MADCTL и окно панели
+ * (lcd_panel_set_orientation; программный поворот — у основной панели в режиме LCD_ROTATION_SOFTWARE),
+ * полосу частичного показа и разрешение LVGL.
+ * @param panel Панель
+ * @param orientation Режим ориентации (DISPLAY_ORIENTATION_0, 90, 180, 270)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t apply_display_orientation(lcd_panel_t *panel, display_orientation_t orientation);
+
+/**
+ * Текст строки лога для демонстрации и проверки консоли: у соседних строк разная длина,
+ * поэтому строка, попавшая не в свою полосу, видна при сравнении.
+ * @param buf Буфер строки
+ * @param size Размер буфера
+ * @param n Номер строки
+ */
+void console_demo_text(char *buf, size_t size, uint32_t n);
+
+/**
+ * Добавляет строку внизу консоли. В 0°/180° передаётся только новая полоса:
+ * она пишется поверх самой старой строки, и только когда полоса целиком в памяти панели
+ * (при LCD_TE_SYNC — ещё и после импульса TE), VSCSAD сдвигает экран на высоту строки.
+ * В 90°/270° после заполнения экрана перерисовываются все строки.
+ * @param text Текст строки (длиннее CONSOLE_MAX_COLS обрезается)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t console_print(const char *text);
+
+/**
+ * Рисует строку текста консоли в буфер: фон и глифы шрифта LVGL с альфа-смешиванием (пиксели в порядке CPU).
+ * Используются только данные шрифта (lv_font_get_glyph_dsc/bitmap), рендерер LVGL не участвует.
+ * @param buf Буфер width x CONSOLE_LINE_HEIGHT пикселей
+ * @param width Ширина строки в пикселях
+ * @param text Текст (ASCII; остальные байты выводятся как '?')
+ */
+void console_render_line(uint16_t *buf, int width, const char *text);
+
+/**
+ * Переводит экран в режим текстовой консоли в текущей ориентации: очищает его и в 0°/180°
+ * задаёт область прокрутки на все строки памяти (VSCRDEF). Пока консоль активна, панелью
+ * владеет она: вызывающий держит lvgl_lock (как при выводе в обход LVGL), ориентацию не меняет.
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t console_start(void);
+
+/**
+ * Выходит из режима консоли: VSCSAD возвращается к 0, прокрутку выключает NORON, а при частичном показе
+ * (lcd_power.partial) — повторный PTLON, чтобы панель осталась в режиме lcd_set_power_mode.
+ * Экран помечается LVGL к полной перерисовке. Вызывается под той же lvgl_lock, что и console_start.
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t console_stop(void);
+
+/**
+ * Создаёт и настраивает виджет с текстом "Hello World" через LVGL.
+ * Позиционирует метку в центре с указанным размером шрифта.
+ * @param font_size Размер шрифта (16 или 28 для Montserrat)
+ */
+void create_hello_world_label(int font_size);
+
+/**
+ * Рисует на весь экран тестовый кадр с цветными полосами по краям:
+ * красная сверху, синяя снизу, зелёная слева и белая справа (ширина 30 пикселей) на чёрном фоне.
+ * Кадр передаётся одной областью, поэтому по нему однозначно видно, правильно ли
+ * ориентация и смещения переводят логические координаты в память панели.
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t draw_edge_strips(void);
+
+/**
+ * Запускает дополнительную панель на общей шине после основной: инициализация со своей линией CS и сбросом SWRESET,
+ * команды lcd_st7789v, RAMCTRL, ориентация с очисткой и Display On. Подсветка общая, её включает основная панель.
+ * @param panel Панель
+ * @param cs_gpio Пин Chip Select
+ * @param orientation Ориентация панели
+ * @return ESP_OK при успехе, иначе код ошибки (панель освобождена)
+ */
+esp_err_t lcd_panel_start(lcd_panel_t *panel, int cs_gpio, display_orientation_t orientation);
+
+/**
+ * Снимок замеров вывода: копии гистограмм, последние кадры и счётчики.
+ * Можно вызывать из любой задачи: вывод не останавливается, копии согласованы по счётчикам последовательности.
+ * @param snapshot Куда записать снимок
+ * @return ESP_OK при успехе, ESP_ERR_NOT_SUPPORTED если замеры выключены (LCD_PERF 0)
+ */
+esp_err_t lcd_perf_get(lcd_perf_snapshot_t *snapshot);
+
+/**
+ * Видимая при частичном показе область в логических координатах текущей ориентации.
+ * @param mode Режим отображения
+ * @param area Область (весь экран, если частичный показ выключен)
+ */
+void lcd_power_active_area(const lcd_power_mode_t *mode, lv_area_t *area);
+
+/**
+ * Оценивает режим отображения: частоту кадров и число показываемых строк по регистрам,
+ * объём и время полного обновления видимой части при текущей pclk и мощность по модели LCD_POWER_*.
+ * @param mode Режим отображения
+ * @param estimate Результат
+ */
+void lcd_power_estimate(const lcd_power_mode_t *mode, lcd_power_estimate_t *estimate);
+
+/**
+ * Переключает режим отображения во время работы: FRCTRL2, частичный показ (PTLAR/PTLON, выход — NORON)
+ * и 8 цветов (IDMON/IDMOFF). При частичном показе LVGL рендерит и передаёт только видимую полосу
+ * (lvgl_clip_to_active_area); после выхода из него или смены полосы экран LVGL перерисовывается целиком,
+ * так как скрытые строки не обновлялись. Период TE следует за новой частотой кадров.
+ * @param mode Новый режим (полоса задаётся вдоль оси развёртки, см. lcd_power_mode_t)
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_ARG при неверной полосе, иначе код ошибки
+ */
+esp_err_t lcd_set_power_mode(const lcd_power_mode_t *mode);
+
+/**
+ * Правило lv_refr_join_area, которое _lv_disp_refr_timer применяет к областям кадра после объединения:
+ * пересекающиеся области заменяются охватывающей, если она меньше суммы их площадей.
+ * Охватывающая непересекающихся областей не меньше суммы их площадей, поэтому части разрезанной
+ * области LVGL не склеивает ни между собой, ни с областью, из которой их вырезали.
+ * @param a Первая область
+ * @param b Вторая область
+ * @param joined Охватывающая область, если LVGL объединил бы пару
+ * @return true, если LVGL объединил бы пару
+ */
+bool lvgl_area_lvgl_join(const lv_area_t *a, const lv_area_t *b, lv_area_t *joined);
+
+/**
+ * Стоимость кадра без объединения: области проходят lv_refr_join_area так же, как в _lv_disp_refr_timer
+ * (один проход, объединённая область продолжает объединяться с последующими).
+ * @param areas Области кадра от LVGL
+ * @param n Количество областей
+ * @return Стоимость в байтах шины по lvgl_area_cost
+ */
+int64_t lvgl_areas_cost_as_is(const lv_area_t *areas, int n);
+
+/**
+ * Объединяет и делит области, которые LVGL перерисует в текущем кадре.
+ * Для каждой пары областей выбирается самый дешёвый по lvgl_area_cost вариант:
+ * оставить как есть, заменить охватывающей областью (соседние и перекрывающиеся области,
+ * если лишние пиксели дешевле отдельного flush) или вырезать перекрытие из второй области,
+ * чтобы не рендерить и не передавать его дважды. Каждый шаг строго уменьшает суммарную стоимость,
+ * поэтому проход конечен. Затем заранее выполняются объединения, которые сделал бы lv_refr_join_area
+ * (lvgl_area_lvgl_join): после этого LVGL выводит ровно записанные области, и выигрыш считается по ним.
+ * Результат записывается обратно в inv_areas дисплея, если он не дороже кадра без объединения
+ * (lvgl_areas_cost_as_is), иначе области кадра не меняются.
+ * @param disp Дисплей LVGL
+ */
+void lvgl_coalesce_areas(lv_disp_t *disp);
+
+/**
+ * Регистрирует дисплей LVGL дополнительной панели: два буфера по lines строк шириной LCD_V_RES во внутренней
+ * DMA-памяти (хватает для любой ориентации), разрешение — из текущей ориентации панели.
+ * Объединение областей, TE, частичный показ и статистика flush_stats остаются у основной панели.
+ * Вызывается под lvgl_lock или до запуска задачи рендеринга.
+ * @param panel Запущенная панель (lcd_panel_start)
+ * @param lines Строк в каждом буфере
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_STATE без интерфейса или при уже зарегистрированном дисплее, иначе код ошибки
+ */
+esp_err_t lvgl_panel_register(lcd_panel_t *panel, int lines);
+
+/**
+ * Удаляет дисплей LVGL дополнительной панели вместе с его экранами и освобождает буферы
+ * после окончания их передач. Вызывается под lvgl_lock или до запуска задачи рендеринга.
+ * @param panel Панель
+ */
+void lvgl_panel_unregister(lcd_panel_t *panel);
+
+/**
+ * Немедленный вывод кадра, как lv_refr_now, но через объединение областей.
+ */
+void lvgl_refr_now(void);
+
+/**
+ * Поворот экрана LVGL с замером: задержка от вызова до окончания передачи нового кадра и его объём на шине.
+ * Вызывается под lvgl_lock.
+ * @param orientation Режим ориентации
+ * @param latency_us Задержка поворота (мкс)
+ * @param color_bytes Байт пикселей, переданных за поворот
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t rotate_display_measured(display_orientation_t orientation, int64_t *latency_us, uint64_t *color_bytes);
+
+/**
+ * Устанавливает ориентацию дисплея (0°, 90°, 180°, 270°) и очищает экран.
+ * @param panel Панель
+ * @param orientation Режим ориентации (DISPLAY_ORIENTATION_0, 90, 180, 270)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t set_display_orientation(lcd_panel_t *panel, display_orientation_t orientation);
+
+/**
+ * Выводит образ заставки (splash.h) в текущей ориентации: изображение по центру, поля цветом фона из заголовка.
+ * Пиксели декодируются полосами по половине fill_buf прямо из образа (во flash — через отображение раздела):
+ * пока DMA передаёт одну половину, декодируется следующая, копии образа в куче нет.
+ * @param image Образ (заголовок и данные)
+ * @param size Размер образа или раздела в байтах
+ * Полосы идут в порядке строк изображения, поэтому при программном повороте (90° и 270°) заставка не выводится:
+ * она показывается при старте, пока поворот выполняет MADCTL.
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_ARG для повреждённого образа,
+ *         ESP_ERR_INVALID_SIZE, если изображение больше экрана или данных меньше, чем пикселей,
+ *         ESP_ERR_INVALID_STATE без fill_buf или при программном повороте, иначе код ошибки
+ */
+esp_err_t splash_draw(const void *image, size_t size);
+
+/**
+ * Переключает способ поворота в 90° и 270°. Буферы LVGL перевыделяются в той же раскладке
+ * (программному повороту нужен буфер поворота): новые, вместе с буфером поворота, выделяются до освобождения
+ * прежних, так что rotate_buf не указывает на освобождённую память. Затем текущая ориентация применяется заново.
+ * Вызывается под lvgl_lock или до запуска задачи рендеринга; экран перерисовывается при следующем обновлении.
+ * @param mode Способ поворота
+ * @return ESP_OK при успехе, ESP_ERR_NO_MEM без памяти на буфер поворота (способ не меняется), иначе код ошибки
+ */
+esp_err_t lcd_set_rotation_mode(lcd_rotation_mode_t mode);
+
+/**
+ * Захватывает блокировку LVGL. Любой вызов API LVGL вне задачи рендеринга
+ * (и прямой вывод на панель в обход LVGL) должен выполняться под ней. Блокировка рекурсивная.
+ * @param timeout_ms Время ожидания в мс (-1 — без ограничения)
+ * @return true, если блокировка захвачена
+ */
+bool lvgl_lock(int timeout_ms);
+
+/**
+ * Освобождает блокировку LVGL, захваченную lvgl_lock.
+ */
+void lvgl_unlock(void);
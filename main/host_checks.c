@@ -0,0 +1,1424 @@
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "lvgl.h"
+#include "rgb565.h"
+#include "splash.h"
+#include "lcd_perf.h"
+#include "lcd_trace.h"
+#include "lcd_panel.h"
+#include "display.h"
+#include "host_checks.h"
+#include "esp_lcd_mock.h"
+
+static const char *TAG = "host_checks";
+
+void log_emu_stats(void) {
+    st7789_emu_stats_t stats;
+    st7789_emu_get_stats(esp_lcd_mock_get_emu(lcd_panel_main.io), &stats);
+    ESP_LOGI(TAG, "Emulator: cmd tx=%" PRIu64 ", color tx=%" PRIu64 ", cmd bytes=%" PRIu64 ", color bytes=%" PRIu64
+             ", offscreen px=%" PRIu64 ", bus time=%" PRIu64 " us at %d Hz",
+             stats.cmd_tx, stats.color_tx, stats.cmd_bytes, stats.color_bytes, stats.offscreen_pixels,
+             stats.bus_time_ns / 1000, (int)lcd_panel_main.pclk_hz);
+}
+
+// Прямоугольник эталонного кадра в координатах стекла (столбцы 0-169, строки 0-319 в портретном виде)
+typedef struct {
+    int16_t x0, x1, y0, y1;
+    uint16_t color;
+} golden_rect_t;
+
+// Эталонный кадр draw_edge_strips для одной ориентации: прямоугольники закрашиваются по порядку,
+// следующие перекрывают предыдущие (красная и синяя полосы идут последними и занимают углы)
+typedef struct {
+    display_orientation_t orientation;
+    golden_rect_t rects[5];
+} golden_frame_t;
+
+static const golden_frame_t golden_frames[] = {
+    // 0°: логический кадр совпадает со стеклом
+    {DISPLAY_ORIENTATION_0, {
+        {0, 169, 0, 319, 0x0000}, {0, 29, 0, 319, 0x07E0}, {140, 169, 0, 319, 0xFFFF},
+        {0, 169, 0, 29, 0xF800}, {0, 169, 290, 319, 0x001F}}},
+    // 90°: верх кадра у правого края стекла, левый край кадра сверху
+    {DISPLAY_ORIENTATION_90, {
+        {0, 169, 0, 319, 0x0000}, {0, 169, 0, 29, 0x07E0}, {0, 169, 290, 319, 0xFFFF},
+        {140, 169, 0, 319, 0xF800}, {0, 29, 0, 319, 0x001F}}},
+    // 180°: кадр перевёрнут по обеим осям
+    {DISPLAY_ORIENTATION_180, {
+        {0, 169, 0, 319, 0x0000}, {140, 169, 0, 319, 0x07E0}, {0, 29, 0, 319, 0xFFFF},
+        {0, 169, 290, 319, 0xF800}, {0, 169, 0, 29, 0x001F}}},
+    // 270°: верх кадра у левого края стекла, левый край кадра снизу
+    {DISPLAY_ORIENTATION_270, {
+        {0, 169, 0, 319, 0x0000}, {0, 169, 290, 319, 0x07E0}, {0, 169, 0, 29, 0xFFFF},
+        {0, 29, 0, 319, 0xF800}, {140, 169, 0, 319, 0x001F}}},
+};
+
+/**
+ * Возвращает цвет пикселя стекла в эталонном кадре.
+ * @param frame Эталонный кадр
+ * @param x Столбец стекла
+ * @param y Строка стекла
+ * @return Ожидаемый цвет RGB565
+ */
+static uint16_t golden_pixel(const golden_frame_t *frame, int x, int y) {
+    uint16_t color = 0;
+    for (size_t i = 0; i < sizeof(frame->rects) / sizeof(frame->rects[0]); i++) {
+        const golden_rect_t *r = &frame->rects[i];
+        if (x >= r->x0 && x <= r->x1 && y >= r->y0 && y <= r->y1) {
+            color = r->color;
+        }
+    }
+    return color;
+}
+
+/**
+ * Выводит через draw_area области, выходящие за левый верхний и правый нижний углы экрана, и сверяет стекло:
+ * панель должна получить только видимую часть, взятую из буфера с шагом исходной строки.
+ * @param emu Эмулятор панели
+ * @return Количество несовпавших пикселей, плюс один, если передано больше байт, чем видно
+ */
+static int draw_clipped_check(st7789_emu_t *emu) {
+    static uint16_t buf[8 * 16];
+    for (int i = 0; i < 8 * 16; i++) {
+        buf[i] = lcd_buffer_color(0x0841 * (i % 31) + i / 16);
+    }
+    int hor_res = lcd_panel_main.orient->hor_res;
+    int ver_res = lcd_panel_main.orient->ver_res;
+    // Области 16x8: видимая часть — 8x4 в углу, остальное за краем
+    const lcd_area_t areas[] = {
+        {-8, 7, -4, 3},
+        {hor_res - 8, hor_res + 7, ver_res - 4, ver_res + 3},
+    };
+    int mismatches = 0;
+    for (size_t i = 0; i < sizeof(areas) / sizeof(areas[0]); i++) {
+        const lcd_area_t *a = &areas[i];
+        st7789_emu_stats_t stats;
+        st7789_emu_reset_stats(emu);
+        esp_err_t ret = draw_area(&lcd_panel_main, a->x_start, a->x_end, a->y_start, a->y_end, buf);
+        if (ret == ESP_OK) {
+            ret = wait_lcd_transfers(&lcd_panel_main);
+        }
+        st7789_emu_get_stats(emu, &stats);
+        if (ret != ESP_OK || stats.color_bytes != 8 * 4 * sizeof(uint16_t) || stats.offscreen_pixels != 0) {
+            mismatches++;
+        }
+        for (int ly = MAX(a->y_start, 0); ly <= MIN(a->y_end, ver_res - 1); ly++) {
+            for (int lx = MAX(a->x_start, 0); lx <= MIN(a->x_end, hor_res - 1); lx++) {
+                int gx, gy;
+                lcd_orientation_to_glass(lcd_panel_main.orient, lx, ly, &gx, &gy);
+                uint16_t expected = lcd_buffer_color(buf[(ly - a->y_start) * 16 + (lx - a->x_start)]);
+                mismatches += st7789_emu_get_pixel(emu, gx, gy) != expected;
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Регрессионная проверка ориентаций на эмуляторе панели: для каждой DISPLAY_ORIENTATION_*
+ * рисует draw_edge_strips и сравнивает память эмулятора с эталонным кадром попиксельно.
+ * Смещение 35 пикселей проверяется дважды: неверный x_gap/y_gap сдвигает полосы относительно
+ * эталона и уводит часть пикселей за пределы стекла (offscreen). Для каждого кадра
+ * записывается число байт, переданных по шине, и проверяются области за краями экрана (draw_clipped_check).
+ * @return Количество ориентаций, не совпавших с эталоном
+ */
+static int run_golden_frame_suite(void) {
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    const uint64_t frame_color_bytes = (uint64_t)LCD_H_RES * LCD_V_RES * sizeof(uint16_t);
+    int failures = 0;
+
+    ESP_LOGI(TAG, "Golden-frame suite: %d orientations", (int)(sizeof(golden_frames) / sizeof(golden_frames[0])));
+    for (size_t i = 0; i < sizeof(golden_frames) / sizeof(golden_frames[0]); i++) {
+        const golden_frame_t *golden = &golden_frames[i];
+        st7789_emu_stats_t setup_stats, frame_stats;
+
+        // Смена ориентации с очисткой экрана, затем отдельно учитывается сам тестовый кадр
+        st7789_emu_reset_stats(emu);
+        esp_err_t ret = set_display_orientation(&lcd_panel_main, golden->orientation);
+        st7789_emu_get_stats(emu, &setup_stats);
+        st7789_emu_reset_stats(emu);
+        if (ret == ESP_OK) {
+            ret = draw_edge_strips();
+        }
+        st7789_emu_get_stats(emu, &frame_stats);
+
+        // Попиксельное сравнение со всем стеклом
+        int mismatches = 0;
+        for (int y = 0; y < LCD_V_RES; y++) {
+            for (int x = 0; x < LCD_H_RES; x++) {
+                uint16_t expected = golden_pixel(golden, x, y);
+                uint16_t actual = st7789_emu_get_pixel(emu, x, y);
+                if (actual != expected) {
+                    if (mismatches == 0) {
+                        ESP_LOGE(TAG, "Orientation %d: first mismatch at glass (%d,%d): 0x%04X, expected 0x%04X",
+                                 golden->orientation * 90, x, y, actual, expected);
+                    }
+                    mismatches++;
+                }
+            }
+        }
+
+        uint64_t offscreen = setup_stats.offscreen_pixels + frame_stats.offscreen_pixels;
+        int clipped = ret == ESP_OK ? draw_clipped_check(emu) : 0;
+        bool ok = ret == ESP_OK && mismatches == 0 && offscreen == 0 && frame_stats.color_bytes == frame_color_bytes &&
+                  clipped == 0;
+        ESP_LOGI(TAG, "Golden %3d deg: %s, mismatched px=%d, clipped px=%d, offscreen px=%" PRIu64 ", frame bytes=%" PRIu64
+                 " (cmd %" PRIu64 ", color %" PRIu64 ", %" PRIu64 " tx), orientation change bytes=%" PRIu64,
+                 golden->orientation * 90, ok ? "OK" : "FAIL", mismatches, clipped, offscreen,
+                 frame_stats.cmd_bytes + frame_stats.color_bytes, frame_stats.cmd_bytes, frame_stats.color_bytes,
+                 frame_stats.cmd_tx + frame_stats.color_tx, setup_stats.cmd_bytes + setup_stats.color_bytes);
+        if (!ok) {
+            failures++;
+        }
+    }
+
+    set_display_orientation(&lcd_panel_main, saved_orientation);
+    ESP_LOGI(TAG, "Golden-frame suite: %d failure(s)", failures);
+    return failures;
+}
+
+/**
+ * Переводит логические координаты текущей ориентации в координаты стекла (по MADCTL и смещению 35 пикселей).
+ * @param lx Логический X
+ * @param ly Логический Y
+ * @param gx Столбец стекла
+ * @param gy Строка стекла
+ */
+static void logical_to_glass(int lx, int ly, int *gx, int *gy) {
+    lcd_orientation_to_glass(lcd_panel_main.orient, lx, ly, gx, gy);
+}
+
+/**
+ * Перевод в стекло разбором ориентации на каждый вызов, как до таблицы lcd_orientations (эталон для проверки).
+ * @param orientation Ориентация
+ * @param lx Логический X
+ * @param ly Логический Y
+ * @param gx Столбец стекла
+ * @param gy Строка стекла
+ */
+static void orientation_to_glass_switch(display_orientation_t orientation, int lx, int ly, int *gx, int *gy) {
+    switch (orientation) {
+    case DISPLAY_ORIENTATION_90:
+        *gx = LCD_H_RES - 1 - ly;
+        *gy = lx;
+        break;
+    case DISPLAY_ORIENTATION_180:
+        *gx = LCD_H_RES - 1 - lx;
+        *gy = LCD_V_RES - 1 - ly;
+        break;
+    case DISPLAY_ORIENTATION_270:
+        *gx = ly;
+        *gy = LCD_V_RES - 1 - lx;
+        break;
+    default:
+        *gx = lx;
+        *gy = ly;
+        break;
+    }
+}
+
+/**
+ * Проверка таблицы ориентаций: для каждой ориентации каждый логический пиксель переводится в стекло
+ * по таблице и разбором ориентации, результаты должны совпасть. Затем сравнивается цена перевода окна
+ * области (ограничение разрешением и углы окна в стекле): с разбором ориентации на каждую область
+ * и со строкой таблицы, выбранной один раз. В лог выводятся такты на область.
+ * @return Количество ориентаций с расхождениями
+ */
+static int run_orientation_table_check(void) {
+    const int areas = 1000000;
+    int failures = 0;
+    volatile unsigned sink = 0; // Не даёт компилятору выбросить перевод окна
+    // Ориентация и строка таблицы читаются на каждую область, как orientation и orient панели
+    // в set_draw_area: иначе компилятор вынесет разбор ориентации из цикла
+    volatile display_orientation_t orientation_var;
+    const lcd_orientation_desc_t *volatile desc_var;
+
+    for (int o = DISPLAY_ORIENTATION_0; o <= DISPLAY_ORIENTATION_270; o++) {
+        const lcd_orientation_desc_t *desc = &lcd_orientations[o];
+        int mismatches = 0;
+        for (int ly = 0; ly < desc->ver_res; ly++) {
+            for (int lx = 0; lx < desc->hor_res; lx++) {
+                int gx, gy, ref_gx, ref_gy;
+                lcd_orientation_to_glass(desc, lx, ly, &gx, &gy);
+                orientation_to_glass_switch((display_orientation_t)o, lx, ly, &ref_gx, &ref_gy);
+                if (gx != ref_gx || gy != ref_gy || gx < 0 || gx >= LCD_H_RES || gy < 0 || gy >= LCD_V_RES) {
+                    mismatches++;
+                }
+            }
+        }
+        if (mismatches) {
+            ESP_LOGE(TAG, "Orientation table %d deg: %d mismatched px", o * 90, mismatches);
+            failures++;
+        }
+
+        // Полосы по 10 строк со сдвигом, как области LVGL; каждая чуть выходит за край и ограничивается.
+        // Ограничение — всё, что set_draw_area делает с ориентацией при MADCTL; перевод углов в стекло
+        // нужен программному повороту и TE
+        orientation_var = (display_orientation_t)o;
+        desc_var = desc;
+        uint32_t cycles[4];
+        for (int pass = 0; pass < 4; pass++) {
+            const bool glass = pass >= 2;
+            const bool table = pass & 1;
+            uint32_t start = lcd_perf_cycles();
+            for (int i = 0; i < areas; i++) {
+                int y1 = i % desc->ver_res, y2 = y1 + 9, x1 = -1, x2 = desc->hor_res;
+                int gx1 = MAX(x1, 0), gy1 = MAX(y1, 0), gx2, gy2;
+                if (table) {
+                    const lcd_orientation_desc_t *current = desc_var;
+                    gx2 = MIN(x2, current->hor_res - 1);
+                    gy2 = MIN(y2, current->ver_res - 1);
+                    if (glass) {
+                        lcd_orientation_to_glass(current, gx1, gy1, &gx1, &gy1);
+                        lcd_orientation_to_glass(current, gx2, gy2, &gx2, &gy2);
+                    }
+                } else {
+                    display_orientation_t orientation = orientation_var;
+                    bool portrait = orientation == DISPLAY_ORIENTATION_0 || orientation == DISPLAY_ORIENTATION_180;
+                    gx2 = MIN(x2, portrait ? LCD_H_RES - 1 : LCD_V_RES - 1);
+                    gy2 = MIN(y2, portrait ? LCD_V_RES - 1 : LCD_H_RES - 1);
+                    if (glass) {
+                        orientation_to_glass_switch(orientation, gx1, gy1, &gx1, &gy1);
+                        orientation_to_glass_switch(orientation, gx2, gy2, &gx2, &gy2);
+                    }
+                }
+                sink += gx1 + gy1 + gx2 + gy2;
+            }
+            cycles[pass] = lcd_perf_cycles() - start;
+        }
+
+        ESP_LOGI(TAG, "Orientation %3d deg: %s, cycles/area per-area switch vs table: clamp %.2f / %.2f, "
+                 "clamp and glass mapping %.2f / %.2f", o * 90, mismatches ? "FAIL" : "OK",
+                 (double)cycles[0] / areas, (double)cycles[1] / areas, (double)cycles[2] / areas, (double)cycles[3] / areas);
+    }
+    (void)sink;
+    ESP_LOGI(TAG, "Orientation table check: %d failure(s)", failures);
+    return failures;
+}
+
+/**
+ * Проверка консоли на эмуляторе во всех ориентациях: выводится больше строк, чем помещается на экран,
+ * и то, что видно на стекле с учётом VSCSAD, сравнивается попиксельно с кадром из последних строк,
+ * нарисованным заново. Для каждой ориентации записывается число байт на одну новую строку.
+ * Вызывается под lvgl_lock.
+ * @return Количество ориентаций с расхождениями
+ */
+static int run_console_check(void) {
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    uint16_t *expected = heap_caps_malloc((size_t)LCD_H_RES * LCD_V_RES * sizeof(uint16_t), MALLOC_CAP_DEFAULT);
+    uint16_t *line = heap_caps_malloc((size_t)LCD_V_RES * CONSOLE_LINE_HEIGHT * sizeof(uint16_t), MALLOC_CAP_DEFAULT);
+    char text[CONSOLE_MAX_COLS + 1];
+    int failures = 0;
+    if (!expected || !line) {
+        ESP_LOGE(TAG, "Failed to allocate console check buffers");
+        free(expected);
+        free(line);
+        return 1;
+    }
+
+    for (int o = DISPLAY_ORIENTATION_0; o <= DISPLAY_ORIENTATION_270; o++) {
+        esp_err_t ret = set_display_orientation(&lcd_panel_main, (display_orientation_t)o);
+        if (ret == ESP_OK) {
+            ret = console_start();
+        }
+        if (ret != ESP_OK) {
+            failures++;
+            continue;
+        }
+        const int hor_res = console.hor_res;
+        const int ver_res = lcd_orientations[o].ver_res;
+        const uint32_t total = 2 * console.rows + 3; // Кольцо полос проходит больше одного круга
+
+        // Байты шины на последнюю строку: при аппаратной прокрутке — одна полоса и VSCSAD
+        st7789_emu_stats_t line_stats = {0};
+        for (uint32_t n = 0; n < total && ret == ESP_OK; n++) {
+            console_demo_text(text, sizeof(text), n);
+            if (n == total - 1) {
+                st7789_emu_reset_stats(emu);
+            }
+            ret = console_print(text);
+        }
+        wait_lcd_transfers(&lcd_panel_main);
+        st7789_emu_get_stats(emu, &line_stats);
+
+        // Ожидаемый кадр: последние rows строк сверху вниз, ниже — фон
+        rgb565_fill(expected, CONSOLE_BG_COLOR, (size_t)hor_res * ver_res);
+        for (int band = 0; band < console.rows; band++) {
+            console_demo_text(text, sizeof(text), total - console.rows + band);
+            console_render_line(line, hor_res, text);
+            memcpy(&expected[(size_t)band * CONSOLE_LINE_HEIGHT * hor_res], line,
+                   (size_t)hor_res * CONSOLE_LINE_HEIGHT * sizeof(uint16_t));
+        }
+        int mismatches = 0;
+        for (int ly = 0; ly < ver_res; ly++) {
+            for (int lx = 0; lx < hor_res; lx++) {
+                int gx, gy;
+                logical_to_glass(lx, ly, &gx, &gy);
+                if (st7789_emu_get_display_pixel(emu, gx, gy) != expected[ly * hor_res + lx]) {
+                    if (mismatches == 0) {
+                        ESP_LOGE(TAG, "Console %d deg: first mismatch at logical (%d,%d)", o * 90, lx, ly);
+                    }
+                    mismatches++;
+                }
+            }
+        }
+
+        bool hw_scroll = console.hw_scroll;
+        uint16_t scroll = console.scroll;
+        if (console_stop() != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+        bool ok = ret == ESP_OK && mismatches == 0;
+        ESP_LOGI(TAG, "Console %3d deg: %s, %s, VSCSAD=%u, mismatched px=%d, bytes per new line=%" PRIu64
+                 " (cmd %" PRIu64 ", color %" PRIu64 "), full frame=%u",
+                 o * 90, ok ? "OK" : "FAIL", hw_scroll ? "hardware scroll" : "redraw", scroll, mismatches,
+                 line_stats.cmd_bytes + line_stats.color_bytes, line_stats.cmd_bytes, line_stats.color_bytes,
+                 (unsigned)(LCD_H_RES * LCD_V_RES * sizeof(uint16_t)));
+        if (!ok) {
+            failures++;
+        }
+    }
+
+    free(expected);
+    free(line);
+    set_display_orientation(&lcd_panel_main, saved_orientation);
+    ESP_LOGI(TAG, "Console check: %d failure(s)", failures);
+    return failures;
+}
+
+/**
+ * Тестовое изображение заставки: сверху полосы сплошных цветов (серии RLE), в середине градиент
+ * (литералы), снизу чередование пар пикселей (короткие серии внутри литералов).
+ * @param pixels Пиксели width x height (порядок CPU)
+ */
+static void splash_test_pattern(uint16_t *pixels, int width, int height) {
+    static const uint16_t bands[] = {0xF800, 0x07E0, 0x001F, 0xFFFF, 0x1234};
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint16_t c;
+            if (y < height / 3) {
+                c = bands[(x * 5 / width + y / 8) % 5];
+            } else if (y < 2 * height / 3) {
+                c = (uint16_t)(((x * 31 / width) << 11) | ((y % 64) << 5) | ((x ^ y) & 0x1F));
+            } else {
+                c = (x / 2 + y) & 1 ? 0xA5C3 : 0x5A3C;
+            }
+            pixels[y * width + x] = c;
+        }
+    }
+}
+
+/**
+ * Собирает образ заставки в памяти (как tools/png2splash.py).
+ * @param pixels Пиксели изображения
+ * @param count Сколько пикселей закодировать (меньше width * height — образ с нехваткой данных)
+ * @return Образ (освобождается free) или NULL
+ */
+static uint8_t *splash_test_image(const uint16_t *pixels, int width, int height, size_t count, uint8_t encoding,
+                                  uint16_t background, size_t *size) {
+    size_t data_size = encoding == SPLASH_ENCODING_RLE ? splash_encode_rle(pixels, count, NULL) : count * sizeof(uint16_t);
+    uint8_t *image = malloc(sizeof(splash_header_t) + data_size);
+    if (!image) {
+        return NULL;
+    }
+    uint8_t *data = image + sizeof(splash_header_t);
+    if (encoding == SPLASH_ENCODING_RLE) {
+        splash_encode_rle(pixels, count, data);
+    } else {
+        memcpy(data, pixels, data_size);
+    }
+    splash_header_t header = {
+        .magic = SPLASH_MAGIC,
+        .width = width,
+        .height = height,
+        .encoding = encoding,
+        .background = background,
+        .data_size = data_size,
+        .crc32 = esp_rom_crc32_le(0, data, data_size),
+    };
+    memcpy(image, &header, sizeof(header));
+    *size = sizeof(header) + data_size;
+    return image;
+}
+
+/**
+ * Проверка заставки на эмуляторе: образы без сжатия и в RLE, на весь экран и меньше экрана (с полями),
+ * выводятся splash_draw, и память панели сравнивается попиксельно с исходным изображением.
+ * Повреждённый образ (CRC) не должен попасть на шину, образ с нехваткой данных должен вернуть ошибку.
+ * @return Количество случаев с расхождениями
+ */
+static int run_splash_check(void) {
+    static const struct {
+        const char *name;
+        display_orientation_t orientation;
+        int width, height;
+        uint8_t encoding;
+        uint16_t background;
+        int defect;                 // 0 — образ цел, 1 — испорчен байт данных, 2 — не хватает пикселей
+        esp_err_t expected;
+    } cases[] = {
+        {"full raw", DISPLAY_ORIENTATION_90, LCD_V_RES, LCD_H_RES, SPLASH_ENCODING_RAW, 0, 0, ESP_OK},
+        {"full RLE", DISPLAY_ORIENTATION_90, LCD_V_RES, LCD_H_RES, SPLASH_ENCODING_RLE, 0, 0, ESP_OK},
+        {"logo RLE", DISPLAY_ORIENTATION_180, 120, 50, SPLASH_ENCODING_RLE, 0x001F, 0, ESP_OK},
+        {"bad CRC", DISPLAY_ORIENTATION_0, 120, 50, SPLASH_ENCODING_RLE, 0, 1, ESP_ERR_INVALID_ARG},
+        {"short", DISPLAY_ORIENTATION_0, 120, 50, SPLASH_ENCODING_RLE, 0, 2, ESP_ERR_INVALID_SIZE},
+    };
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    uint16_t *pixels = malloc((size_t)LCD_H_RES * LCD_V_RES * sizeof(uint16_t));
+    int failures = 0;
+    if (!pixels) {
+        ESP_LOGE(TAG, "Failed to allocate splash check buffer");
+        return 1;
+    }
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const int width = cases[c].width;
+        const int height = cases[c].height;
+        splash_test_pattern(pixels, width, height);
+        size_t count = (size_t)width * height - (cases[c].defect == 2 ? width : 0);
+        size_t size;
+        uint8_t *image = splash_test_image(pixels, width, height, count, cases[c].encoding, cases[c].background, &size);
+        if (!image || set_display_orientation(&lcd_panel_main, cases[c].orientation) != ESP_OK) {
+            free(image);
+            failures++;
+            continue;
+        }
+        if (cases[c].defect == 1) {
+            image[sizeof(splash_header_t) + 7] ^= 0x01;
+        }
+
+        st7789_emu_reset_stats(emu);
+        esp_err_t ret = splash_draw(image, size);
+        st7789_emu_stats_t stats;
+        st7789_emu_get_stats(emu, &stats);
+
+        // Изображение по центру, поля цветом фона (только для целого образа)
+        const int o = cases[c].orientation;
+        const int hor_res = lcd_orientations[o].hor_res;
+        const int ver_res = lcd_orientations[o].ver_res;
+        const int x0 = (hor_res - width) / 2;
+        const int y0 = (ver_res - height) / 2;
+        int mismatches = 0;
+        for (int ly = 0; ly < ver_res && cases[c].defect == 0; ly++) {
+            for (int lx = 0; lx < hor_res; lx++) {
+                bool inside = lx >= x0 && lx < x0 + width && ly >= y0 && ly < y0 + height;
+                uint16_t expected = inside ? pixels[(ly - y0) * width + lx - x0] : cases[c].background;
+                int gx, gy;
+                logical_to_glass(lx, ly, &gx, &gy);
+                if (st7789_emu_get_pixel(emu, gx, gy) != expected) {
+                    if (mismatches == 0) {
+                        ESP_LOGE(TAG, "Splash %s: first mismatch at logical (%d,%d)", cases[c].name, lx, ly);
+                    }
+                    mismatches++;
+                }
+            }
+        }
+
+        bool ok = ret == cases[c].expected && mismatches == 0 && (cases[c].defect != 1 || stats.color_bytes == 0);
+        ESP_LOGI(TAG, "Splash %-8s %3d deg: %s (%s), image %u bytes for %dx%d (%u%% of raw), bus %" PRIu64 " bytes "
+                 "in %" PRIu64 " tx, mismatched px=%d",
+                 cases[c].name, o * 90, ok ? "OK" : "FAIL", esp_err_to_name(ret), (unsigned)size, width, height,
+                 (unsigned)(size * 100 / ((size_t)width * height * sizeof(uint16_t))), stats.color_bytes,
+                 stats.color_tx, mismatches);
+        if (!ok) {
+            failures++;
+        }
+        free(image);
+    }
+
+    free(pixels);
+    set_display_orientation(&lcd_panel_main, saved_orientation);
+    ESP_LOGI(TAG, "Splash check: %d failure(s)", failures);
+    return failures;
+}
+
+/**
+ * Проверка владения ресурсами панели на эмуляторе (отдельная панель на свободной линии CS общей шины):
+ * повторная инициализация отвергается и не портит панель, ошибка посреди инициализации освобождает
+ * всё созданное и место на шине, двойной deinit безопасен, после deinit панель инициализируется снова
+ * и принимает кадр, а шина остаётся у основной панели.
+ * Утечки на хосте дополнительно ловит LeakSanitizer при выходе.
+ * @return Количество нарушений
+ */
+static int run_panel_lifecycle_check(void) {
+    const int cs_gpio = 90; // Линия CS без реальной панели: у эмулятора своя память
+    lcd_panel_t panel = {.orientation = DISPLAY_ORIENTATION_0, .orient = &lcd_orientations[DISPLAY_ORIENTATION_0]};
+    const int bus_users = lcd_bus.users;
+    int failures = 0;
+
+    // Ошибка при создании интерфейса (pclk 0): место на шине уже занято и должно быть освобождено
+    esp_err_t ret = lcd_panel_init(&panel, cs_gpio, -1, 0);
+    if (ret == ESP_OK || panel.bus || panel.io || panel.panel || panel.fill_buf || lcd_bus.users != bus_users) {
+        ESP_LOGE(TAG, "Lifecycle: failed init left resources behind");
+        failures++;
+    }
+
+    size_t heap_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    for (int round = 0; round < 2; round++) {
+        if (lcd_panel_init(&panel, cs_gpio, -1, LCD_PIXEL_CLOCK_HZ) != ESP_OK || panel.bus != lcd_panel_main.bus) {
+            ESP_LOGE(TAG, "Lifecycle: init round %d failed", round);
+            failures++;
+            break;
+        }
+        esp_lcd_panel_io_handle_t io = panel.io;
+        if (lcd_panel_init(&panel, cs_gpio, -1, LCD_PIXEL_CLOCK_HZ) != ESP_ERR_INVALID_STATE || panel.io != io) {
+            ESP_LOGE(TAG, "Lifecycle: double init was not rejected");
+            failures++;
+        }
+
+        // Панель принимает кадр: заливка через её окно и буфер заливки
+        const uint16_t color = round ? 0x07E0 : 0xF800;
+        ret = apply_display_orientation(&panel, DISPLAY_ORIENTATION_0);
+        if (ret == ESP_OK) {
+            ret = clear_screen(&panel, color);
+        }
+        st7789_emu_t *emu = esp_lcd_mock_get_emu(panel.io);
+        if (ret != ESP_OK || st7789_emu_get_pixel(emu, 0, 0) != color ||
+            st7789_emu_get_pixel(emu, LCD_H_RES - 1, LCD_V_RES - 1) != color) {
+            ESP_LOGE(TAG, "Lifecycle: frame on round %d did not reach the panel", round);
+            failures++;
+        }
+
+        if (lcd_panel_deinit(&panel) != ESP_OK || lcd_panel_deinit(&panel) != ESP_OK ||
+            panel.bus || panel.io || panel.panel || panel.fill_buf || lcd_bus.users != bus_users || !lcd_bus.handle) {
+            ESP_LOGE(TAG, "Lifecycle: deinit round %d left resources behind", round);
+            failures++;
+        }
+    }
+    size_t heap_after = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    ESP_LOGI(TAG, "Panel lifecycle check: %d failure(s), heap delta %d bytes", failures, (int)heap_before - (int)heap_after);
+    return failures;
+}
+
+/**
+ * Меняет политику порядка байт (проверка на хосте) для всех панелей шины: их интерфейсы i80 пересоздаются
+ * с нужным swap_color_bytes, каждой панели отправляется RAMCTRL, а буферы заливки помечаются недействительными.
+ * LVGL рисует в порядке, заданном LV_COLOR_16_SWAP при сборке, поэтому доступны только политики, совместимые с ним.
+ * @param order Новая политика
+ * @return ESP_OK при успехе, ESP_ERR_NOT_SUPPORTED при несовместимости с LV_COLOR_16_SWAP, иначе код ошибки
+ */
+static esp_err_t lcd_set_byte_order(lcd_byte_order_t order) {
+    if ((order == LCD_BYTE_ORDER_RENDERER) != (LV_COLOR_16_SWAP != 0)) {
+        ESP_LOGE(TAG, "Byte order %s does not match LV_COLOR_16_SWAP=%d", lcd_byte_order_name(order), LV_COLOR_16_SWAP);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    lcd_byte_order = order;
+    for (int i = 0; i < lcd_bus.users; i++) {
+        lcd_bus.panels[i]->fill_valid = false; // fill_buf заполнен в порядке прежней политики
+    }
+    esp_err_t ret = set_pixel_clock(lcd_panel_main.pclk_hz);
+
+    for (int i = 0; ret == ESP_OK && i < lcd_bus.users; i++) {
+        ret = lcd_send_ramctrl(lcd_bus.panels[i]);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to switch byte order to %s: %s", lcd_byte_order_name(order), esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * Считает пиксели видимой области эмулятора, отличные от ожидаемого цвета.
+ * @param emu Эмулятор панели
+ * @param color Ожидаемый цвет в порядке CPU
+ * @return Количество несовпавших пикселей
+ */
+static int emu_count_mismatches(st7789_emu_t *emu, uint16_t color) {
+    int mismatches = 0;
+    for (int y = 0; y < LCD_V_RES; y++) {
+        for (int x = 0; x < LCD_H_RES; x++) {
+            mismatches += st7789_emu_get_pixel(emu, x, y) != color;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Проверка политики порядка байт на эмуляторе: для каждой политики, совместимой с LV_COLOR_16_SWAP,
+ * цвета, у которых перестановка байтов меняет значение, выводятся сырой заливкой fill_area и фоном
+ * экрана LVGL, и каждый пиксель памяти панели сравнивается с исходным цветом. Двойная перестановка
+ * или её отсутствие здесь обнаруживаются сразу (на заливках 0x0000/0xFFFF они не видны).
+ * То же проверяется на временной второй панели шины (свободная линия CS, свой дисплей LVGL):
+ * политика меняется у всех панелей, а не только у текущей.
+ * Вызывается до запуска задачи рендеринга.
+ * @return Количество несовпавших проверок
+ */
+static int run_byte_order_suite(void) {
+    static const uint16_t colors[] = {0xF800, 0x07E0, 0x001F, 0x1234, 0xA5C3};
+#if LV_COLOR_16_SWAP
+    static const lcd_byte_order_t orders[] = {LCD_BYTE_ORDER_RENDERER};
+#else
+    static const lcd_byte_order_t orders[] = {LCD_BYTE_ORDER_DMA, LCD_BYTE_ORDER_PANEL};
+#endif
+    const int cs_gpio = 92; // Линия CS без реальной панели: у эмулятора своя память
+    const lcd_byte_order_t saved_order = lcd_byte_order;
+    lcd_panel_t panel2 = {0};
+    int failures = 0;
+
+    // Вторая панель запускается в исходной политике, до первой её смены
+    if (lcd_panel_start(&panel2, cs_gpio, DISPLAY_ORIENTATION_0) != ESP_OK) {
+        ESP_LOGE(TAG, "Byte-order suite: panel on CS %d did not start", cs_gpio);
+        return 1;
+    }
+    if (lvgl_panel_register(&panel2, LVGL_PANEL2_BUFFER_LINES) != ESP_OK) {
+        lcd_panel_deinit(&panel2);
+        return 1;
+    }
+    lcd_panel_t *const panels[] = {&lcd_panel_main, &panel2};
+    lv_disp_t *const disps[] = {lvgl_disp, panel2.disp};
+
+    ESP_LOGI(TAG, "Byte-order suite: %d policies, %d colors, %d panels", (int)(sizeof(orders) / sizeof(orders[0])),
+             (int)(sizeof(colors) / sizeof(colors[0])), (int)(sizeof(panels) / sizeof(panels[0])));
+    for (size_t o = 0; o < sizeof(orders) / sizeof(orders[0]); o++) {
+        if (lcd_set_byte_order(orders[o]) != ESP_OK) {
+            failures++;
+            continue;
+        }
+        for (size_t p = 0; p < sizeof(panels) / sizeof(panels[0]); p++) {
+            lcd_panel_t *panel = panels[p];
+            st7789_emu_t *emu = esp_lcd_mock_get_emu(panel->io);
+            const int hor_res = panel->orient->hor_res;
+            const int ver_res = panel->orient->ver_res;
+            lv_obj_t *scr = lv_disp_get_scr_act(disps[p]);
+            for (size_t c = 0; c < sizeof(colors) / sizeof(colors[0]); c++) {
+                uint16_t color = colors[c];
+
+                // Сырая заливка в обход LVGL
+                esp_err_t ret = fill_area(panel, 0, hor_res - 1, 0, ver_res - 1, color);
+                wait_lcd_transfers(panel);
+                int raw_mismatches = ret == ESP_OK ? emu_count_mismatches(emu, color) : LCD_H_RES * LCD_V_RES;
+
+                // Тот же цвет фоном экрана LVGL (8-битные каналы переводятся в RGB565 без потерь)
+                lv_obj_set_style_bg_color(scr, lv_color_make((color >> 11) << 3, ((color >> 5) & 0x3F) << 2, (color & 0x1F) << 3), 0);
+                lv_obj_invalidate(scr);
+                if (disps[p] == lvgl_disp) {
+                    lvgl_refr_now(); // Основная панель выводит кадр через объединение областей
+                } else {
+                    lv_refr_now(disps[p]);
+                }
+                wait_lcd_transfers(panel);
+                int lvgl_mismatches = emu_count_mismatches(emu, color);
+
+                bool ok = raw_mismatches == 0 && lvgl_mismatches == 0;
+                ESP_LOGI(TAG, "Byte order %-19s CS %2d 0x%04X: %s, raw mismatched px=%d, LVGL mismatched px=%d (panel 0x%04X)",
+                         lcd_byte_order_name(orders[o]), panel->cs_gpio, color, ok ? "OK" : "FAIL", raw_mismatches,
+                         lvgl_mismatches, st7789_emu_get_pixel(emu, 0, 0));
+                if (!ok) {
+                    failures++;
+                }
+            }
+            lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+        }
+    }
+
+    lcd_set_byte_order(saved_order);
+    lvgl_panel_unregister(&panel2);
+    lcd_panel_deinit(&panel2);
+    lv_obj_invalidate(lv_scr_act());
+    lvgl_refr_now();
+    ESP_LOGI(TAG, "Byte-order suite: %d failure(s)", failures);
+    return failures;
+}
+
+/**
+ * Проверка режимов пониженного потребления на эмуляторе: для каждого режима из lcd_power_presets экран LVGL
+ * перерисовывается целиком, и сверяются байты пикселей на шине с оценкой (LVGL передаёт только видимую полосу),
+ * частота кадров и число строк, декодированные эмулятором из команд панели, и то, что видно на стекле:
+ * вне полосы чёрный, в полосе — цвет фона (в режиме 8 цветов — старшие биты каналов).
+ * Вызывается до запуска задачи рендеринга.
+ * @return Количество режимов с расхождениями
+ */
+static int run_power_mode_check(void) {
+    const uint16_t color = 0xA5C3; // У каналов разные старшие биты: IDMON даёт 0xFFE0
+    const uint16_t marker = 0x1234; // Память панели вне полосы: LVGL не должен её перезаписать
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    lv_obj_t *scr = lv_scr_act();
+    int failures = 0;
+
+    lv_obj_set_style_bg_color(scr, lv_color_make((color >> 11) << 3, ((color >> 5) & 0x3F) << 2, (color & 0x1F) << 3), 0);
+    for (size_t p = 0; p < sizeof(lcd_power_presets) / sizeof(lcd_power_presets[0]); p++) {
+        const lcd_power_mode_t *mode = &lcd_power_presets[p].mode;
+        const display_orientation_t o = lcd_power_presets[p].orientation;
+        const int hor_res = lcd_orientations[o].hor_res;
+        const int ver_res = lcd_orientations[o].ver_res;
+        esp_err_t ret = set_display_orientation(&lcd_panel_main, o);
+        if (ret == ESP_OK) {
+            ret = fill_area(&lcd_panel_main, 0, hor_res - 1, 0, ver_res - 1, marker);
+        }
+        if (ret == ESP_OK) {
+            ret = lcd_set_power_mode(mode);
+        }
+        if (ret != ESP_OK) {
+            failures++;
+            continue;
+        }
+        wait_lcd_transfers(&lcd_panel_main);
+
+        // Полный кадр LVGL: после отсечения на шину уходит только видимая полоса
+        st7789_emu_reset_stats(emu);
+        lv_obj_invalidate(scr);
+        lvgl_refr_now();
+        wait_lcd_transfers(&lcd_panel_main);
+        st7789_emu_stats_t stats;
+        st7789_emu_get_stats(emu, &stats);
+
+        lcd_power_estimate_t estimate;
+        lcd_power_estimate(mode, &estimate);
+        st7789_emu_display_mode_t panel;
+        st7789_emu_get_display_mode(emu, &panel);
+
+        lv_area_t active;
+        lcd_power_active_area(mode, &active);
+        uint16_t shown = color;
+        if (mode->idle) {
+            shown = (color & 0x8000 ? 0xF800 : 0) | (color & 0x0400 ? 0x07E0 : 0) | (color & 0x0010 ? 0x001F : 0);
+        }
+        int mismatches = 0;
+        for (int ly = 0; ly < ver_res; ly++) {
+            for (int lx = 0; lx < hor_res; lx++) {
+                bool inside = lx >= active.x1 && lx <= active.x2 && ly >= active.y1 && ly <= active.y2;
+                int gx, gy;
+                logical_to_glass(lx, ly, &gx, &gy);
+                if (st7789_emu_get_display_pixel(emu, gx, gy) != (inside ? shown : 0) ||
+                    st7789_emu_get_pixel(emu, gx, gy) != (inside ? color : marker)) {
+                    if (mismatches == 0) {
+                        ESP_LOGE(TAG, "Power mode %s %d deg: first mismatch at logical (%d,%d)",
+                                 lcd_power_presets[p].name, o * 90, lx, ly);
+                    }
+                    mismatches++;
+                }
+            }
+        }
+
+        bool ok = mismatches == 0 && stats.color_bytes == estimate.update_bytes &&
+                  panel.partial == mode->partial && panel.idle == mode->idle &&
+                  panel.active_lines == estimate.active_lines && panel.frame_mhz == estimate.frame_mhz;
+        ESP_LOGI(TAG, "Power mode %-10s %3d deg: %s, %" PRIu32 ".%03" PRIu32 " Hz (panel %" PRIu32 ".%03" PRIu32 "), "
+                 "%d lines (panel %d), bytes %" PRIu64 " (estimate %" PRIu32 "), bus %" PRIu64 " us (estimate %" PRIu32 "), "
+                 "panel ~%" PRIu32 " uW, bus ~%" PRIu32 " uW, mismatched px=%d",
+                 lcd_power_presets[p].name, o * 90, ok ? "OK" : "FAIL",
+                 estimate.frame_mhz / 1000, estimate.frame_mhz % 1000, panel.frame_mhz / 1000, panel.frame_mhz % 1000,
+                 estimate.active_lines, panel.active_lines, stats.color_bytes, estimate.update_bytes,
+                 stats.bus_time_ns / 1000, estimate.update_us, estimate.panel_uw, estimate.bus_uw, mismatches);
+        if (!ok) {
+            failures++;
+        }
+    }
+
+    // Консоль при частичном показе: выход из прокрутки не должен выключать PTLON
+    st7789_emu_display_mode_t panel;
+    esp_err_t ret = set_display_orientation(&lcd_panel_main, lcd_power_presets[2].orientation);
+    if (ret == ESP_OK) {
+        ret = lcd_set_power_mode(&lcd_power_presets[2].mode);
+    }
+    if (ret == ESP_OK) {
+        ret = console_start();
+    }
+    for (uint32_t n = 0; ret == ESP_OK && n < (uint32_t)console.rows + 1; n++) {
+        char text[CONSOLE_MAX_COLS + 1];
+        console_demo_text(text, sizeof(text), n);
+        ret = console_print(text);
+    }
+    if (ret == ESP_OK) {
+        ret = console_stop();
+    }
+    wait_lcd_transfers(&lcd_panel_main);
+    st7789_emu_get_display_mode(emu, &panel);
+    bool console_ok = ret == ESP_OK && panel.partial && lcd_power.partial && !panel.scroll;
+    ESP_LOGI(TAG, "Power mode with console: %s, panel partial=%d scroll=%d, lcd_power.partial=%d",
+             console_ok ? "OK" : "FAIL", panel.partial, panel.scroll, lcd_power.partial);
+    if (!console_ok) {
+        failures++;
+    }
+
+    const lcd_power_mode_t normal = {.frctrl2 = LCD_FRCTRL2_DEFAULT};
+    lcd_set_power_mode(&normal);
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+    set_display_orientation(&lcd_panel_main, saved_orientation);
+    lv_obj_invalidate(scr);
+    lvgl_refr_now();
+    ESP_LOGI(TAG, "Power mode check: %d failure(s), clipped %" PRIu64 " bytes", failures, lcd_power_clipped_bytes);
+    return failures;
+}
+
+/**
+ * Считает пиксели стекла эмулятора, отличные от цвета.
+ * @param emu Эмулятор панели
+ * @param color Ожидаемый цвет всего стекла
+ * @return Количество несовпавших пикселей
+ */
+static int glass_mismatches(st7789_emu_t *emu, uint16_t color) {
+    int mismatches = 0;
+    for (int gy = 0; gy < LCD_V_RES; gy++) {
+        for (int gx = 0; gx < LCD_H_RES; gx++) {
+            mismatches += st7789_emu_get_pixel(emu, gx, gy) != color;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * Арбитраж очереди шины: длинная заливка основной панели не задерживает область другой панели до своего конца.
+ * Заливка ставится кусками fill_buf подряд, как в fill_area, а посреди неё вторая панель ставит свою область.
+ * Эмулятор в режиме отложенного окончания, как драйвер i80, выполняет очередь панели, чья передача шла последней,
+ * поэтому без арбитража область ждала бы всех кусков заливки. Здесь до окончания области завершается не больше
+ * доли очереди шины (и одного куска, который ставится, когда она освободилась) кусков заливки, пиксели обеих
+ * панелей на своих стёклах, а все кредиты к концу возвращаются в бюджет шины.
+ * @param panel Вторая панель на шине
+ * @return Количество нарушений
+ */
+static int multi_panel_fairness_check(lcd_panel_t *panel) {
+    const int fill_chunks = LCD_TRANS_QUEUE_DEPTH * 8;   // Длинная заливка: восемь глубин очереди
+    const int area_at = LCD_TRANS_QUEUE_DEPTH * 2;       // Кусок заливки, перед которым ставится область
+    const int area_lines = LCD_FILL_BUF_LINES * 3 / 2;   // Область второй панели: пара кусков fill_buf
+    const uint16_t main_color = 0x07E0, area_color = 0xF81F;
+    const uint32_t main_yields = lcd_panel_main.stats.yields;
+    int failures = 0;
+
+    // Окно и fill_buf заливки готовы заранее: дальше куски ставятся без команд и без ожидания очереди
+    esp_err_t ret = fill_area(&lcd_panel_main, 0, lcd_panel_main.orient->hor_res - 1, 0, lcd_panel_main.orient->ver_res - 1, main_color);
+    uint32_t area_target = 0, main_done_at_area = 0;
+    int main_done_before_area = -1;
+    for (int i = 0; ret == ESP_OK && i < fill_chunks; i++) {
+        if (i == area_at) {
+            ret = fill_area(panel, 0, panel->orient->hor_res - 1, 0, area_lines - 1, area_color);
+            area_target = panel->color_queued;
+            main_done_at_area = lcd_panel_main.color_done;
+        }
+        if (ret == ESP_OK) {
+            ret = lcd_tx_color(&lcd_panel_main, -1, lcd_panel_main.fill_buf, LCD_FILL_BUF_PIXELS * sizeof(uint16_t));
+        }
+        if (area_target && main_done_before_area < 0 && panel->color_done >= area_target) {
+            main_done_before_area = (int)(lcd_panel_main.color_done - main_done_at_area);
+        }
+    }
+    wait_lcd_transfers(&lcd_panel_main);
+    wait_lcd_transfers(panel);
+    if (main_done_before_area < 0) {
+        main_done_before_area = (int)(lcd_panel_main.color_done - main_done_at_area);
+    }
+
+    int area_mismatches = 0;
+    for (int y = 0; y < area_lines; y++) {
+        for (int x = 0; x < panel->orient->hor_res; x++) {
+            int gx, gy;
+            lcd_orientation_to_glass(panel->orient, x, y, &gx, &gy);
+            area_mismatches += st7789_emu_get_pixel(esp_lcd_mock_get_emu(panel->io), gx, gy) != area_color;
+        }
+    }
+    int main_mismatches = glass_mismatches(esp_lcd_mock_get_emu(lcd_panel_main.io), main_color);
+    UBaseType_t credits = uxSemaphoreGetCount(lcd_bus.credits);
+    bool ok = ret == ESP_OK && main_done_before_area <= lcd_bus_share() + 1 && area_mismatches == 0 &&
+              main_mismatches == 0 && credits == LCD_TRANS_QUEUE_DEPTH && lcd_panel_main.stats.yields != main_yields &&
+              lcd_panel_main.color_done == lcd_panel_main.color_queued && panel->color_done == panel->color_queued;
+    ESP_LOGI(TAG, "Multi-panel fairness: %s, %d fill chunks ran ahead of the other panel's area (share %d), "
+             "%" PRIu32 " yields, %d+%d mismatched px, %u of %d credits back",
+             ok ? "OK" : "FAIL", main_done_before_area, lcd_bus_share(),
+             lcd_panel_main.stats.yields - main_yields, main_mismatches, area_mismatches, (unsigned)credits,
+             LCD_TRANS_QUEUE_DEPTH);
+    if (!ok) {
+        failures++;
+    }
+    return failures;
+}
+
+/**
+ * Проверка нескольких панелей на общей шине (временная панель на свободной линии CS со своим дисплеем LVGL):
+ * панель подключается к шине основной панели, кадры LVGL обеих панелей попадают каждый на своё стекло,
+ * смена ориентации одной панели не трогает разрешение и окно другой, счётчики передач и доля шины у каждой
+ * панели свои, а длинная заливка одной панели не задерживает области другой (multi_panel_fairness_check). После проверки дисплей и панель удаляются, шина остаётся у основной панели.
+ * Вызывается до запуска задачи рендеринга.
+ * @return Количество нарушений
+ */
+static int run_multi_panel_check(void) {
+    const int cs_gpio = 91; // Линия CS без реальной панели: у эмулятора своя память
+    const uint16_t main_color = 0x001F, panel_color = 0xFFE0;
+    const size_t frame_bytes = (size_t)LCD_H_RES * LCD_V_RES * sizeof(uint16_t);
+    const int bus_users = lcd_bus.users;
+    lcd_panel_t panel = {0};
+    int failures = 0;
+
+    if (lcd_panel_start(&panel, cs_gpio, DISPLAY_ORIENTATION_0) != ESP_OK) {
+        ESP_LOGE(TAG, "Multi-panel: panel on CS %d did not start", cs_gpio);
+        return 1;
+    }
+    if (lvgl_panel_register(&panel, LVGL_PANEL2_BUFFER_LINES) != ESP_OK) {
+        lcd_panel_deinit(&panel);
+        return 1;
+    }
+    if (panel.bus != lcd_panel_main.bus || lcd_bus.users != bus_users + 1) {
+        ESP_LOGE(TAG, "Multi-panel: panel did not join the shared bus");
+        failures++;
+    }
+    st7789_emu_t *main_emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(panel.io);
+    lv_obj_t *main_scr = lv_scr_act();
+    lv_obj_t *scr = lv_disp_get_scr_act(panel.disp);
+    lv_obj_set_style_bg_color(main_scr, lv_color_make((main_color >> 11) << 3, ((main_color >> 5) & 0x3F) << 2, (main_color & 0x1F) << 3), 0);
+    lv_obj_set_style_bg_color(scr, lv_color_make((panel_color >> 11) << 3, ((panel_color >> 5) & 0x3F) << 2, (panel_color & 0x1F) << 3), 0);
+
+    for (int round = 0; round < 2; round++) {
+        // Второй круг: панель поворачивается в 90°, основная остаётся в своей ориентации
+        const display_orientation_t o = round ? DISPLAY_ORIENTATION_90 : DISPLAY_ORIENTATION_0;
+        const display_orientation_t main_orientation = lcd_panel_main.orientation;
+        const lv_coord_t main_hor_res = lv_disp_get_hor_res(lvgl_disp);
+        esp_err_t ret = apply_display_orientation(&panel, o);
+        if (ret != ESP_OK || lv_disp_get_hor_res(panel.disp) != lcd_orientations[o].hor_res ||
+            lcd_panel_main.orientation != main_orientation || lv_disp_get_hor_res(lvgl_disp) != main_hor_res) {
+            ESP_LOGE(TAG, "Multi-panel: orientation %d deg of one panel leaked into the other", o * 90);
+            failures++;
+        }
+
+        // Кадр каждой панели: области стоят в очередях своих интерфейсов
+        lcd_panel_stats_t main_before = lcd_panel_main.stats, panel_before = panel.stats;
+        lv_obj_invalidate(main_scr);
+        lv_obj_invalidate(scr);
+        lvgl_refr_now();
+        lv_refr_now(panel.disp);
+        wait_lcd_transfers(&lcd_panel_main);
+        esp_lcd_panel_io_tx_param(panel.io, -1, NULL, 0);
+
+        int main_mismatches = glass_mismatches(main_emu, main_color);
+        int mismatches = glass_mismatches(emu, panel_color);
+        uint64_t main_bytes = lcd_panel_main.stats.color_bytes - main_before.color_bytes;
+        uint64_t bytes = panel.stats.color_bytes - panel_before.color_bytes;
+        bool ok = main_mismatches == 0 && mismatches == 0 && main_bytes == frame_bytes && bytes == frame_bytes &&
+                  panel.stats.frames != panel_before.frames && lcd_panel_main.stats.frames != main_before.frames &&
+                  panel.color_done == panel.color_queued && lcd_panel_main.color_done == lcd_panel_main.color_queued &&
+                  !panel.lvgl_pending && !flush_stats.pending;
+        ESP_LOGI(TAG, "Multi-panel %d deg: %s, main CS %d %" PRIu64 " bytes, %d mismatched px; CS %d %" PRIu64
+                 " bytes, %d mismatched px; transfers %" PRIu32 "/%" PRIu32 " and %" PRIu32 "/%" PRIu32 " done",
+                 o * 90, ok ? "OK" : "FAIL", lcd_panel_main.cs_gpio, main_bytes, main_mismatches, cs_gpio, bytes,
+                 mismatches, lcd_panel_main.color_done, lcd_panel_main.color_queued, panel.color_done, panel.color_queued);
+        if (!ok) {
+            failures++;
+        }
+    }
+    failures += multi_panel_fairness_check(&panel);
+    log_panel_stats();
+
+    lvgl_panel_unregister(&panel);
+    if (lcd_panel_deinit(&panel) != ESP_OK || lcd_bus.users != bus_users || !lcd_bus.handle) {
+        ESP_LOGE(TAG, "Multi-panel: removing the panel did not leave the bus to the main panel");
+        failures++;
+    }
+    lv_obj_set_style_bg_color(main_scr, lv_color_black(), 0);
+    lv_obj_invalidate(main_scr);
+    lvgl_refr_now();
+    ESP_LOGI(TAG, "Multi-panel check: %d failure(s), queue depth %d per bus", failures, LCD_TRANS_QUEUE_DEPTH);
+    return failures;
+}
+
+/**
+ * Проверка поворота без очистки на эмуляторе: из каждой ориентации в следующую экран LVGL поворачивается
+ * прежним путём (set_display_orientation с очисткой, пересоздание метки, кадр LVGL) и через rotate_display.
+ * Поворот без очистки должен передать ровно один кадр пикселей, и всё стекло должно показывать фон экрана LVGL
+ * в новой ориентации. В лог выводятся задержка, время шины по модели эмулятора и байты обоих путей.
+ * Вызывается до запуска задачи рендеринга.
+ * @return Количество поворотов с расхождениями
+ */
+static int run_rotation_check(void) {
+    const uint16_t color = 0x3A6F; // Не чёрный: очистка перед кадром LVGL была бы видна на стекле
+    const uint64_t frame_bytes = (uint64_t)LCD_H_RES * LCD_V_RES * sizeof(uint16_t);
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    lv_obj_t *scr = lv_scr_act();
+    int failures = 0;
+
+    lv_obj_set_style_bg_color(scr, lv_color_make((color >> 11) << 3, ((color >> 5) & 0x3F) << 2, (color & 0x1F) << 3), 0);
+    for (int o = DISPLAY_ORIENTATION_0; o <= DISPLAY_ORIENTATION_270; o++) {
+        const display_orientation_t from = (display_orientation_t)o;
+        const display_orientation_t to = (display_orientation_t)((o + 1) % 4);
+        int64_t latency_us = 0;
+        uint64_t bytes = 0;
+        st7789_emu_stats_t legacy_stats, rotate_stats;
+
+        // Прежний путь: поворот с очисткой, метка создаётся заново, затем полный кадр LVGL
+        esp_err_t ret = rotate_display_measured(from, &latency_us, &bytes);
+        st7789_emu_reset_stats(emu);
+        int64_t legacy_start_us = esp_timer_get_time();
+        if (ret == ESP_OK) {
+            ret = set_display_orientation(&lcd_panel_main, to);
+        }
+        if (ret == ESP_OK) {
+            create_hello_world_label(16);
+            lv_obj_invalidate(scr);
+            lvgl_refr_now();
+            ret = wait_lcd_transfers(&lcd_panel_main);
+        }
+        int64_t legacy_us = esp_timer_get_time() - legacy_start_us;
+        st7789_emu_get_stats(emu, &legacy_stats);
+
+        // Поворот без очистки из той же исходной ориентации
+        if (ret == ESP_OK) {
+            ret = rotate_display_measured(from, &latency_us, &bytes);
+        }
+        st7789_emu_reset_stats(emu);
+        if (ret == ESP_OK) {
+            ret = rotate_display_measured(to, &latency_us, &bytes);
+        }
+        st7789_emu_get_stats(emu, &rotate_stats);
+
+        const int hor_res = lcd_orientations[to].hor_res;
+        const int ver_res = lcd_orientations[to].ver_res;
+        int mismatches = 0;
+        for (int ly = 0; ly < ver_res; ly++) {
+            for (int lx = 0; lx < hor_res; lx++) {
+                int gx, gy;
+                logical_to_glass(lx, ly, &gx, &gy);
+                if (st7789_emu_get_pixel(emu, gx, gy) != color) {
+                    if (mismatches == 0) {
+                        ESP_LOGE(TAG, "Rotation %d -> %d deg: first mismatch at logical (%d,%d)", from * 90, to * 90, lx, ly);
+                    }
+                    mismatches++;
+                }
+            }
+        }
+
+        bool ok = ret == ESP_OK && mismatches == 0 && bytes == frame_bytes && rotate_stats.color_bytes == frame_bytes &&
+                  lv_disp_get_hor_res(lvgl_disp) == hor_res && lv_disp_get_ver_res(lvgl_disp) == ver_res &&
+                  lvgl_disp->driver->rotated == LV_DISP_ROT_NONE;
+        ESP_LOGI(TAG, "Rotation %3d -> %3d deg: %s, %" PRId64 " us, bus %" PRIu64 " us, %" PRIu64 " bytes "
+                 "(with clear: %" PRId64 " us, bus %" PRIu64 " us, %" PRIu64 " bytes), mismatched px=%d",
+                 from * 90, to * 90, ok ? "OK" : "FAIL", latency_us, rotate_stats.bus_time_ns / 1000, rotate_stats.color_bytes,
+                 legacy_us, legacy_stats.bus_time_ns / 1000, legacy_stats.color_bytes, mismatches);
+        if (!ok) {
+            failures++;
+        }
+    }
+
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+    int64_t latency_us;
+    uint64_t bytes;
+    rotate_display_measured(saved_orientation, &latency_us, &bytes);
+    ESP_LOGI(TAG, "Rotation check: %d failure(s)", failures);
+    return failures;
+}
+
+#define COALESCE_CHECK_FRAMES 500            // Случайных кадров в проверке объединения областей
+
+/**
+ * Проверка объединения областей на кадрах из пересекающихся и соседних областей (фиксированный набор
+ * и случайные кадры с постоянным зерном): области после lvgl_coalesce_areas покрывают все пиксели входных,
+ * не выходят за их охватывающую, ни одну пару из них не объединил бы lv_refr_join_area
+ * (LVGL выводит ровно эти области, если кадр не оставлен как был), а стоимость выведенного LVGL
+ * не больше стоимости кадра без объединения.
+ * Счётчики объединения после проверки восстанавливаются.
+ * @return Количество кадров с нарушениями
+ */
+static int run_coalesce_join_check(void) {
+    static const lv_area_t fixed[][3] = {
+        {{0, 0, 99, 49}, {50, 25, 149, 74}, {0, 0, -1, -1}},         // Пересечение углами
+        {{0, 20, 319, 29}, {150, 0, 159, 169}, {0, 0, -1, -1}},      // Крест
+        {{0, 0, 199, 99}, {10, 10, 209, 109}, {0, 0, -1, -1}},       // Почти совпадают
+        {{0, 0, 9, 169}, {10, 0, 19, 169}, {20, 0, 29, 169}},        // Соседние полосы
+        {{0, 0, 159, 84}, {100, 50, 319, 169}, {140, 70, 180, 100}}, // Три пересекающиеся
+    };
+    static uint8_t covered[LCD_V_RES * LCD_H_RES];
+    const int fixed_count = sizeof(fixed) / sizeof(fixed[0]);
+    const lvgl_coalesce_t saved = lvgl_coalesce;
+    uint32_t seed = 1;
+    int failures = 0;
+
+    lvgl_coalesce.enabled = true;
+    for (int frame = 0; frame < fixed_count + COALESCE_CHECK_FRAMES; frame++) {
+        lv_area_t in[LV_INV_BUF_SIZE];
+        int n = 0;
+        if (frame < fixed_count) {
+            for (int i = 0; i < 3; i++) {
+                if (fixed[frame][i].x2 >= fixed[frame][i].x1) {
+                    in[n++] = fixed[frame][i];
+                }
+            }
+        } else {
+            // Линейный конгруэнтный генератор: кадры одинаковы от прогона к прогону
+            int count = 2 + frame % 11;
+            for (int i = 0; i < count; i++) {
+                uint32_t r[4];
+                for (int k = 0; k < 4; k++) {
+                    seed = seed * 1103515245u + 12345u;
+                    r[k] = seed >> 16;
+                }
+                lv_coord_t x = r[0] % LCD_V_RES, y = r[1] % LCD_H_RES;
+                in[n++] = (lv_area_t){x, y, MIN(x + r[2] % 120, LCD_V_RES - 1), MIN(y + r[3] % 80, LCD_H_RES - 1)};
+            }
+        }
+
+        lv_disp_t disp = {0};
+        lv_area_t bounds = in[0];
+        for (int i = 0; i < n; i++) {
+            disp.inv_areas[i] = in[i];
+            bounds = (lv_area_t){MIN(bounds.x1, in[i].x1), MIN(bounds.y1, in[i].y1), MAX(bounds.x2, in[i].x2), MAX(bounds.y2, in[i].y2)};
+        }
+        disp.inv_p = n;
+        lvgl_coalesce_areas(&disp);
+
+        memset(covered, 0, sizeof(covered));
+        bool ok = true;
+        bool joinable = false;
+        for (int i = 0; i < disp.inv_p; i++) {
+            const lv_area_t *a = &disp.inv_areas[i];
+            if (a->x1 < bounds.x1 || a->y1 < bounds.y1 || a->x2 > bounds.x2 || a->y2 > bounds.y2 || disp.inv_area_joined[i]) {
+                ok = false;
+                continue;
+            }
+            for (lv_coord_t y = a->y1; y <= a->y2; y++) {
+                memset(&covered[y * LCD_V_RES + a->x1], 1, a->x2 - a->x1 + 1);
+            }
+            for (int j = i + 1; j < disp.inv_p; j++) {
+                lv_area_t joined;
+                joinable |= lvgl_area_lvgl_join(a, &disp.inv_areas[j], &joined);
+            }
+        }
+        // Пары, которые объединит LVGL, допустимы, только если области кадра остались как были
+        bool unchanged = disp.inv_p == n && memcmp(disp.inv_areas, in, n * sizeof(lv_area_t)) == 0;
+        ok &= !joinable || unchanged;
+        int64_t cost_out = lvgl_areas_cost_as_is(disp.inv_areas, disp.inv_p);
+        int uncovered = 0;
+        for (int i = 0; i < n; i++) {
+            for (lv_coord_t y = in[i].y1; y <= in[i].y2; y++) {
+                for (lv_coord_t x = in[i].x1; x <= in[i].x2; x++) {
+                    uncovered += !covered[y * LCD_V_RES + x];
+                }
+            }
+        }
+        int64_t cost_in = lvgl_areas_cost_as_is(in, n);
+        if (!ok || uncovered != 0 || cost_out > cost_in) {
+            ESP_LOGE(TAG, "Coalesce frame %d: %d areas -> %d, %d uncovered px, cost %" PRId64 " -> %" PRId64 "%s",
+                     frame, n, disp.inv_p, uncovered, cost_in, cost_out, ok ? "" : ", joinable or outside areas left");
+            failures++;
+        }
+    }
+
+    // Кадры должны были пройти через все виды шагов, иначе проверка ничего не доказывает
+    uint32_t merges = lvgl_coalesce.merges - saved.merges;
+    uint32_t splits = lvgl_coalesce.splits - saved.splits;
+    uint32_t joins = lvgl_coalesce.lvgl_joins - saved.lvgl_joins;
+    if (merges == 0 || splits == 0) {
+        ESP_LOGE(TAG, "Coalesce check: frames did not exercise merges (%" PRIu32 ") and splits (%" PRIu32 ")", merges, splits);
+        failures++;
+    }
+    ESP_LOGI(TAG, "Coalesce join check: %d failure(s) in %d frames, merges=%" PRIu32 ", splits=%" PRIu32 ", LVGL joins=%" PRIu32,
+             failures, fixed_count + COALESCE_CHECK_FRAMES, merges, splits, joins);
+    lvgl_coalesce = saved;
+    return failures;
+}
+
+#if LCD_PERF
+#define PERF_CHECK_SAMPLES  1000000           // Записей в гистограмму для замера стоимости записи
+
+/**
+ * Проверка замеров вывода: корзины и перцентили гистограммы, вытеснение в кольце, согласие счётчиков
+ * с flush_stats после всех кадров прогона и стоимость записи одного значения.
+ * Вызывается под lvgl_lock, когда задача рендеринга стоит.
+ * @return 0 при успехе, иначе число ошибок
+ */
+static int run_perf_check(void) {
+    int errors = 0;
+
+    // Гистограмма: 0 в корзине 0, 1 в корзине 1, 2..3 в корзине 2, 1000 в корзине 10
+    static lcd_perf_hist_t hist;
+    static const uint32_t values[] = {0, 1, 2, 3, 1000};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        lcd_perf_hist_add(&hist, values[i]);
+    }
+    if (hist.buckets[0] != 1 || hist.buckets[1] != 1 || hist.buckets[2] != 2 || hist.buckets[10] != 1 ||
+        hist.count != 5 || hist.sum != 1006 || hist.max != 1000 || hist.seq != 10 ||
+        lcd_perf_hist_percentile(&hist, 50) != 3 || lcd_perf_hist_percentile(&hist, 100) != 1000) {
+        ESP_LOGE(TAG, "Perf histogram: count=%" PRIu32 ", sum=%" PRIu64 ", p50=%" PRIu32 ", p100=%" PRIu32,
+                 hist.count, hist.sum, lcd_perf_hist_percentile(&hist, 50), lcd_perf_hist_percentile(&hist, 100));
+        errors++;
+    }
+
+    // Кольцо: из LCD_PERF_RING_LEN + 4 кадров читаются последние LCD_PERF_RING_LEN - 1, от старых к новым
+    static lcd_perf_ring_t ring;
+    static lcd_perf_frame_t frames[LCD_PERF_RING_LEN];
+    for (uint32_t i = 1; i <= LCD_PERF_RING_LEN + 4; i++) {
+        lcd_perf_ring_push(&ring, &(lcd_perf_frame_t){.frame = i});
+    }
+    size_t count = lcd_perf_ring_read(&ring, frames);
+    if (count != LCD_PERF_RING_LEN - 1 || frames[0].frame != 6 || frames[count - 1].frame != LCD_PERF_RING_LEN + 4) {
+        ESP_LOGE(TAG, "Perf ring: %u frames, %" PRIu32 "..%" PRIu32, (unsigned)count, count ? frames[0].frame : 0,
+                 count ? frames[count - 1].frame : 0);
+        errors++;
+    }
+
+    // Замеры прогона: каждый flush LVGL и каждый кадр учтены ровно один раз (на хосте DMA завершается внутри flush)
+    static lcd_perf_snapshot_t perf;
+    lcd_perf_get(&perf);
+    const lcd_perf_frame_t *newest = perf.recent_count ? &perf.recent[perf.recent_count - 1] : NULL;
+    if (perf.frames != flush_stats.frames || perf.hist[LCD_PERF_RENDER].count != flush_stats.frames ||
+        perf.hist[LCD_PERF_FRAME].count != flush_stats.frames || perf.hist[LCD_PERF_FLUSH].count != flush_stats.flushes ||
+        perf.hist[LCD_PERF_DMA].count != flush_stats.flushes || perf.hist[LCD_PERF_BYTES].count != flush_stats.flushes ||
+        perf.hist[LCD_PERF_SET_AREA].count < flush_stats.flushes || !newest || newest->frame != perf.frames) {
+        ESP_LOGE(TAG, "Perf counters: frames=%" PRIu32 " (flush stats %" PRIu32 "), render=%" PRIu32 ", flush=%" PRIu32
+                 " (flush stats %" PRIu32 "), DMA=%" PRIu32 ", newest=%" PRIu32,
+                 perf.frames, flush_stats.frames, perf.hist[LCD_PERF_RENDER].count, perf.hist[LCD_PERF_FLUSH].count,
+                 flush_stats.flushes, perf.hist[LCD_PERF_DMA].count, newest ? newest->frame : 0);
+        errors++;
+    }
+    uint32_t flushes = 0;
+    for (size_t i = 0; i < perf.recent_count; i++) {
+        flushes += perf.recent[i].flushes;
+        if (perf.recent[i].bytes == 0 || perf.recent[i].flushes == 0) {
+            ESP_LOGE(TAG, "Perf frame %" PRIu32 ": %" PRIu32 " bytes in %u flushes", perf.recent[i].frame,
+                     perf.recent[i].bytes, perf.recent[i].flushes);
+            errors++;
+            break;
+        }
+    }
+
+    // Стоимость записи: значения разного порядка, чтобы корзины менялись, как в работе
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < PERF_CHECK_SAMPLES; i++) {
+        lcd_perf_hist_add(&hist, i * 2654435761u >> (i & 15));
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "Perf check: %" PRIu32 " frames, %" PRIu32 " dropped, %u recent frames (%" PRIu32 " flushes), "
+             "%" PRId64 " ns per histogram sample",
+             perf.frames, perf.dropped, (unsigned)perf.recent_count, flushes, elapsed_us * 1000 / PERF_CHECK_SAMPLES);
+    return errors;
+}
+#endif
+
+/**
+ * Проверка формата трассы: переполненное кольцо отбрасывает новые события и считает их, пакеты
+ * разбираются обратно в те же события по порядку, испорченный байт отвергается по CRC.
+ * @return 0 при успехе, иначе число ошибок
+ */
+static int run_trace_check(void) {
+    static lcd_trace_ring_t ring;
+    static uint8_t packet[LCD_TRACE_PACKET_BYTES];
+    int errors = 0;
+
+    for (uint32_t i = 0; i < LCD_TRACE_RING_LEN + 3; i++) {
+        lcd_trace_push(&ring, LCD_TRACE_FLUSH_BEGIN, i & 1, i, ~i);
+    }
+    uint32_t next = 0;
+    uint32_t packets = 0;
+    size_t size;
+    lcd_trace_header_t header = {0};
+    while ((size = lcd_trace_pack(&ring, packets, packet, LCD_TRACE_PACKET_EVENTS)) > 0) {
+        const lcd_trace_event_t *events = lcd_trace_unpack(packet, size, &header);
+        if (!events || header.seq != packets || header.dropped != 3) {
+            ESP_LOGE(TAG, "Trace packet %" PRIu32 " rejected or wrong header (dropped %" PRIu32 ")", packets, header.dropped);
+            errors++;
+            break;
+        }
+        for (int i = 0; i < header.count; i++, next++) {
+            if (events[i].type != LCD_TRACE_FLUSH_BEGIN || events[i].a != next || events[i].b != ~next || events[i].arg != (next & 1)) {
+                ESP_LOGE(TAG, "Trace event %" PRIu32 " decoded as %" PRIu32, next, events[i].a);
+                errors++;
+                break;
+            }
+        }
+        packets++;
+    }
+    if (next != LCD_TRACE_RING_LEN) {
+        ESP_LOGE(TAG, "Trace ring returned %" PRIu32 " of %d events", next, LCD_TRACE_RING_LEN);
+        errors++;
+    }
+
+    // После выгрузки кольцо снова принимает события; испорченный пакет не разбирается
+    lcd_trace_push(&ring, LCD_TRACE_HEAP, 0, 1, 2);
+    size = lcd_trace_pack(&ring, packets, packet, LCD_TRACE_PACKET_EVENTS);
+    packet[sizeof(lcd_trace_header_t) + 4] ^= 0x01;
+    if (size != lcd_trace_packet_size(1) || lcd_trace_unpack(packet, size, &header) != NULL) {
+        ESP_LOGE(TAG, "Trace: corrupted packet of %u bytes accepted", (unsigned)size);
+        errors++;
+    }
+    ESP_LOGI(TAG, "Trace check: %" PRIu32 " events in %" PRIu32 " packets, %" PRIu32 " dropped, %d error(s)",
+             next, packets, ring.dropped, errors);
+    return errors;
+}
+
+void host_checks_init(void) {
+    // Все проверки эмулятора идут с передачами, которые завершаются позже постановки, как при настоящем DMA
+    esp_lcd_mock_set_deferred(HOST_DEFERRED_DMA);
+    ESP_LOGI(TAG, "Emulator DMA completion: %s", HOST_DEFERRED_DMA ? "deferred" : "immediate");
+}
+
+int run_host_panel_checks(void) {
+    // Панель владеет своими ресурсами: повторная инициализация отвергается, deinit освобождает всё
+    if (run_panel_lifecycle_check() != 0) {
+        return 1;
+    }
+    // Таблица ориентаций совпадает с прежним разбором ориентации по каждому пикселю
+    if (run_orientation_table_check() != 0) {
+        return 1;
+    }
+    // Регрессия ориентаций на эмуляторе: при расхождении с эталоном прогон завершается с ошибкой
+    if (run_golden_frame_suite() != 0) {
+        return 1;
+    }
+    // Заставка: декодирование образов без сжатия и в RLE, поля вокруг изображения, отказ на повреждённом образе
+    if (run_splash_check() != 0) {
+        return 1;
+    }
+    // Трасса: кольцо событий и разбор пакетов (tools/trace2perfetto.py читает тот же формат)
+    return run_trace_check() != 0;
+}
+
+int run_host_lvgl_checks(void) {
+    // Сырые заливки и пиксели LVGL должны попадать в память панели одинаково при любой политике порядка байт
+    if (run_byte_order_suite() != 0) {
+        return 1;
+    }
+    // В частичном показе LVGL передаёт только видимую полосу, режим панели совпадает с оценкой
+    if (run_power_mode_check() != 0) {
+        return 1;
+    }
+    // Поворот без очистки передаёт один кадр, и на стекле сразу изображение в новой ориентации
+    if (run_rotation_check() != 0) {
+        return 1;
+    }
+    // Другой способ поворота: те же эталонные кадры и тот же поворот без очистки
+    const lcd_rotation_mode_t other_rotation = LCD_ROTATION_MODE == LCD_ROTATION_SOFTWARE ? LCD_ROTATION_MADCTL : LCD_ROTATION_SOFTWARE;
+    if (lcd_set_rotation_mode(other_rotation) != ESP_OK || run_golden_frame_suite() != 0 || run_rotation_check() != 0 ||
+        lcd_set_rotation_mode(LCD_ROTATION_MODE) != ESP_OK) {
+        return 1;
+    }
+    // Вторая панель на той же шине: свой кадр на своём стекле, свои ориентация, счётчики и доля шины
+    return run_multi_panel_check() != 0;
+}
+
+int run_host_render_checks(void) {
+    // Консоль с аппаратной прокруткой выводит на панель напрямую, поэтому задача рендеринга стоит на блокировке
+    lvgl_lock(-1);
+    int errors = run_console_check();
+    lvgl_unlock();
+    if (errors != 0) {
+        return 1;
+    }
+    // Объединение областей не теряет пикселей, и LVGL не объединяет его результат заново
+    return run_coalesce_join_check() != 0;
+}
+
+int run_host_perf_checks(void) {
+#if LCD_PERF
+    // Замеры этапов вывода сходятся со счётчиками flush после всех кадров прогона
+    lvgl_lock(-1);
+    int errors = run_perf_check();
+    lvgl_unlock();
+    return errors != 0;
+#else
+    return 0;
+#endif
+}
+
+#endif // CONFIG_IDF_TARGET_LINUX
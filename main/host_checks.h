@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * Проверки хост-сборки (linux): вывод идёт в эмулятор ST7789 (components/st7789_emu), и каждая проверка
+ * сверяет память панели, счётчики шины или состояние LVGL с ожидаемым. app_main вызывает группы проверок
+ * по мере готовности вывода и завершает процесс с ошибкой, если группа вернула не 0.
+ * На устройстве файл пуст: проверки живут только в хост-сборке.
+ */
+
+/**
+ * Переводит эмулятор в режим отложенного окончания передач (HOST_DEFERRED_DMA): проверки идут,
+ * пока передачи ещё в очереди, как при настоящем DMA. Вызывается до init_display.
+ */
+void host_checks_init(void);
+
+/**
+ * Проверки панели без LVGL (после init_display): жизненный цикл панели, таблица ориентаций,
+ * эталонные кадры ориентаций, декодер заставки и трасса вывода.
+ * @return 0, если все проверки прошли, иначе 1
+ */
+int run_host_panel_checks(void);
+
+/**
+ * Проверки вывода LVGL до запуска задачи рендеринга (после init_lvgl): порядок байт, режимы пониженного
+ * потребления, поворот без очистки в обоих способах поворота и вторая панель на общей шине.
+ * @return 0, если все проверки прошли, иначе 1
+ */
+int run_host_lvgl_checks(void);
+
+/**
+ * Проверки при работающей задаче рендеринга: консоль с аппаратной прокруткой (под lvgl_lock)
+ * и объединение областей против lv_refr_join_area.
+ * @return 0, если все проверки прошли, иначе 1
+ */
+int run_host_render_checks(void);
+
+/**
+ * Сверка замеров этапов вывода (LCD_PERF) со счётчиками flush после всех кадров прогона (под lvgl_lock).
+ * @return 0, если проверка прошла или замеры выключены, иначе 1
+ */
+int run_host_perf_checks(void);
+
+/**
+ * Выводит в лог счётчики эмулятора ST7789: транзакции, байты и расчётное время занятости шины.
+ */
+void log_emu_stats(void);
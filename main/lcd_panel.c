@@ -0,0 +1,837 @@
+#include <string.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "rgb565.h"
+#include "lcd_panel.h"
+
+static const char *TAG = "lcd_panel";
+
+const lcd_orientation_desc_t lcd_orientations[LCD_ORIENTATIONS] = {
+    [DISPLAY_ORIENTATION_0] = { // MY=0, MX=0, MV=0, BGR=1: стекло как есть
+        .madctl = 0x08, .hor_res = LCD_H_RES, .ver_res = LCD_V_RES, .x_gap = 35, .y_gap = 0,
+        .gx0 = 0, .gy0 = 0, .gx_lx = 1, .gx_ly = 0, .gy_lx = 0, .gy_ly = 1,
+    },
+    [DISPLAY_ORIENTATION_90] = { // MY=0, MX=1, MV=1, BGR=1: логический X идёт вдоль строк стекла
+        .madctl = 0x68, .hor_res = LCD_V_RES, .ver_res = LCD_H_RES, .x_gap = 0, .y_gap = 35,
+        .landscape = true, .clockwise = true,
+        .gx0 = LCD_H_RES - 1, .gy0 = 0, .gx_lx = 0, .gx_ly = -1, .gy_lx = 1, .gy_ly = 0,
+    },
+    [DISPLAY_ORIENTATION_180] = { // MY=1, MX=1, MV=0, BGR=1: обе оси инвертированы
+        .madctl = 0xC8, .hor_res = LCD_H_RES, .ver_res = LCD_V_RES, .x_gap = 35, .y_gap = 0,
+        .mirror_rows = true,
+        .gx0 = LCD_H_RES - 1, .gy0 = LCD_V_RES - 1, .gx_lx = -1, .gx_ly = 0, .gy_lx = 0, .gy_ly = -1,
+    },
+    [DISPLAY_ORIENTATION_270] = { // MY=1, MX=0, MV=1, BGR=1: логический X идёт вдоль строк стекла снизу вверх
+        .madctl = 0xA8, .hor_res = LCD_V_RES, .ver_res = LCD_H_RES, .x_gap = 0, .y_gap = 35,
+        .landscape = true, .mirror_rows = true,
+        .gx0 = 0, .gy0 = LCD_V_RES - 1, .gx_lx = 0, .gx_ly = 1, .gy_lx = -1, .gy_ly = 0,
+    },
+};
+
+lcd_byte_order_t lcd_byte_order = LCD_BYTE_ORDER;
+lcd_bus_t lcd_bus = {0};
+lcd_bus_stats_t bus_stats = {0};
+bool push_crc_enabled = false;
+uint32_t push_crc = 0;
+
+// Список команд инициализации ST7789 одной константной последовательностью (во flash, около 100 байт):
+// код команды, число параметров (бит 7: после команды выход из сна, см. LCD_SLEEP_OUT_MS), параметры.
+// Команда 0x36 (MADCTL) исключена, так как она задаётся в lcd_panel_set_orientation; CASET/RASET — так как
+// set_draw_area после смены ориентации отправляет их перед первой записью; 0x29 (Display On) — в lcd_display_on.
+#define LCD_INIT_SLEEP_OUT  0x80              // Флаг в байте длины
+#define LCD_INIT_END        0xFF              // Байт длины, завершающий список
+static const uint8_t lcd_st7789v[] = {
+    0x11, 0 | LCD_INIT_SLEEP_OUT,                      // Sleep Out: выход из спящего режима
+    0x21, 0,                                           // INVON: включение инверсии цветов
+                                                        // Влияние: без INVON цвета могут быть инвертированы (например, белый станет чёрным).
+    0x35, 1, 0x00,                                     // TEON: включение tearing effect для синхронизации
+    0x3A, 1, 0x55,                                     // Pixel Format: RGB565 (16 бит на пиксель)
+                                                        // Влияние: установка 0x66 (RGB666) увеличит размер данных, что не поддерживается шиной i80 в данном коде.
+    0xB2, 5, 0x0C, 0x0C, 0x00, 0x33, 0x33,             // Porch Setting: настройка временных интервалов
+    0xB7, 1, 0x35,                                     // Gate Control: управление затвором
+    0xBB, 1, 0x19,                                     // VCOM Setting: настройка напряжения
+    0xC0, 1, 0x2C,                                     // LCM Control: управление модулем
+    0xC2, 1, 0x01,                                     // VDV/VRH Enable: включение VDV/VRH
+    0xC3, 1, 0x12,                                     // VRH Set: установка VRH
+    0xC4, 1, 0x20,                                     // VDV Set: установка VDV
+    0xC6, 1, LCD_FRCTRL2_DEFAULT,                      // Frame Rate Control: частота обновления 60 Гц
+                                                        // Влияние: установка 0x05 (120 Гц) может вызвать мерцание на некоторых дисплеях.
+    0xD0, 2, 0xA4, 0xA1,                               // Power Control: управление питанием
+    0xE0, 14, 0xD0, 0x08, 0x11, 0x08, 0x09, 0x15, 0x31, 0x33, 0x48, 0x17, 0x14, 0x15, 0x31, 0x34, // Positive Gamma
+    0xE1, 14, 0xD0, 0x08, 0x11, 0x08, 0x09, 0x15, 0x31, 0x33, 0x48, 0x17, 0x14, 0x15, 0x31, 0x34, // Negative Gamma
+    0x00, LCD_INIT_END,                                // Конец списка команд
+};
+
+/**
+ * Арбитраж очереди шины между панелями. Драйвер i80 берёт следующую передачу из очереди той панели,
+ * чья передача шла последней, и переходит к другим, только когда эта очередь пуста, поэтому панель,
+ * которая ставит передачи быстрее шины (длинная заливка), держала бы шину до конца. Здесь у каждой панели
+ * доля бюджета LCD_TRANS_QUEUE_DEPTH / users: больше неё в очереди не бывает, а поставив долю подряд,
+ * панель при ожидающих передачах другой панели ждёт, пока её очередь опустеет, и драйвер переключается.
+ * @param panel Панель
+ * @return true, если панель может поставить передачу сейчас
+ */
+static bool lcd_bus_may_queue(const lcd_panel_t *panel) {
+    const int share = lcd_bus_share();
+    int in_flight = lcd_panel_in_flight(panel);
+    if (in_flight >= share) {
+        return false;
+    }
+    if (in_flight == 0 || panel->bus_burst < (uint32_t)share) {
+        return true;
+    }
+    for (int i = 0; i < lcd_bus.users; i++) {
+        if (lcd_bus.panels[i] != panel && lcd_panel_in_flight(lcd_bus.panels[i]) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Ждёт очереди панели (lcd_bus_may_queue) и берёт кредит очереди шины на одну передачу.
+ * Ожидание просыпается на каждом окончании передачи шины.
+ * @param panel Панель
+ */
+static void lcd_bus_take_credit(lcd_panel_t *panel) {
+    bool yielded = false;
+    for (;;) {
+        if (lcd_bus_may_queue(panel)) {
+            if (xSemaphoreTake(lcd_bus.credits, 0) == pdTRUE) {
+                break;
+            }
+        } else if (!yielded && lcd_panel_in_flight(panel) < lcd_bus_share()) {
+            yielded = true; // Доля не выбрана: панель ждёт, пока шина перейдёт к другой
+            panel->stats.yields++;
+        }
+        lcd_dma_wait_step();
+        xSemaphoreTake(lcd_bus.done_sem, pdMS_TO_TICKS(LCD_BUS_WAIT_MS));
+    }
+    if (lcd_panel_in_flight(panel) == 0) {
+        panel->bus_burst = 0; // Очередь панели пуста: новая пачка
+    }
+    // Окончание передачи будит одну ожидающую задачу: остальные проверят свою очередь ещё раз
+    xSemaphoreGive(lcd_bus.done_sem);
+}
+
+esp_err_t wait_lcd_transfers(lcd_panel_t *panel) {
+    return esp_lcd_panel_io_tx_param(panel->io, -1, NULL, 0);
+}
+
+esp_err_t lcd_tx_param(lcd_panel_t *panel, int cmd, const void *params, size_t len) {
+    bus_stats.cmd_tx++;
+    bus_stats.cmd_bytes += (cmd >= 0) + len;
+    return esp_lcd_panel_io_tx_param(panel->io, cmd, params, len);
+}
+
+esp_err_t lcd_tx_color(lcd_panel_t *panel, int cmd, const void *data, size_t len) {
+    bus_stats.color_tx++;
+    bus_stats.cmd_bytes += cmd >= 0;
+    bus_stats.color_bytes += len;
+    // Постановка ждёт доли панели в очереди шины: это время — ожидание освобождения места в ней
+    uint32_t t0 = lcd_perf_cycles();
+    lcd_bus_take_credit(panel);
+    esp_err_t ret = esp_lcd_panel_io_tx_color(panel->io, cmd, data, len);
+    panel->stats.tx_cycles += lcd_perf_cycles() - t0;
+    if (ret == ESP_OK) {
+        panel->color_queued++;
+        panel->bus_burst++;
+        panel->stats.color_tx++;
+        panel->stats.color_bytes += len;
+    } else {
+        xSemaphoreGive(lcd_bus.credits); // Передача не поставлена, и окончания у неё не будет
+    }
+    if (push_crc_enabled && ret == ESP_OK) {
+        // CRC считается уже после постановки в очередь, параллельно с DMA: буфер до конца передачи не меняется
+        push_crc = esp_rom_crc32_le(push_crc, data, len);
+    }
+    return ret;
+}
+
+const char *lcd_byte_order_name(lcd_byte_order_t order) {
+    switch (order) {
+    case LCD_BYTE_ORDER_DMA:
+        return "DMA swap";
+    case LCD_BYTE_ORDER_RENDERER:
+        return "LVGL swap";
+    case LCD_BYTE_ORDER_PANEL:
+        return "panel little-endian";
+    }
+    return "unknown";
+}
+
+esp_err_t lcd_send_ramctrl(lcd_panel_t *panel) {
+    // Первый параметр: интерфейс MCU, запись в RAM по RAMWR; второй: EPF=11 (как после сброса) и ENDIAN
+    uint8_t ramctrl[2] = {0x00, lcd_byte_order == LCD_BYTE_ORDER_PANEL ? 0xF0 | LCD_RAMCTRL_ENDIAN : 0xF0};
+    return lcd_tx_param(panel, 0xB0, ramctrl, sizeof(ramctrl));
+}
+
+/**
+ * Перевод окна в адреса памяти панели, когда поворот и отражение выполняет MADCTL:
+ * контроллер уже обменял оси и инвертировал адреса, поэтому добавляются только смещения видимой области.
+ * @param panel Панель
+ * @param area Окно, ограниченное экраном (логические координаты со смещениями LCD_X_OFFSET/LCD_Y_OFFSET)
+ * @param addr Столбцы (x_start..x_end) и строки (y_start..y_end) памяти панели
+ */
+static void lcd_window_map_madctl(lcd_panel_t *panel, const lcd_area_t *area, lcd_area_t *addr) {
+    addr->x_start = area->x_start + panel->window.x_gap;
+    addr->x_end = area->x_end + panel->window.x_gap;
+    addr->y_start = area->y_start + panel->window.y_gap;
+    addr->y_end = area->y_end + panel->window.y_gap;
+}
+
+/**
+ * Перевод окна в адреса памяти панели при программном повороте: панель остаётся в развёртке 0°,
+ * и окно поворачивается так же, как пиксели в draw_area_rotated.
+ * @param panel Панель
+ * @param area Окно, ограниченное экраном (логические координаты со смещениями LCD_X_OFFSET/LCD_Y_OFFSET)
+ * @param addr Столбцы (x_start..x_end) и строки (y_start..y_end) памяти панели
+ */
+static void lcd_window_map_rotated(lcd_panel_t *panel, const lcd_area_t *area, lcd_area_t *addr) {
+    int gx1, gy1, gx2, gy2;
+    lcd_orientation_to_glass(panel->orient, area->x_start, area->y_start, &gx1, &gy1);
+    lcd_orientation_to_glass(panel->orient, area->x_end, area->y_end, &gx2, &gy2);
+    addr->x_start = MIN(gx1, gx2) + panel->window.x_gap;
+    addr->x_end = MAX(gx1, gx2) + panel->window.x_gap;
+    addr->y_start = MIN(gy1, gy2) + panel->window.y_gap;
+    addr->y_end = MAX(gy1, gy2) + panel->window.y_gap;
+}
+
+esp_err_t set_draw_area(lcd_panel_t *panel, int x_start, int x_end, int y_start, int y_end, lcd_area_t *clamped) {
+    ESP_LOGD(TAG, "Setting draw area: x=%d-%d, y=%d-%d (before offset, orientation=%d)", 
+             x_start, x_end, y_start, y_end, panel->orientation);
+
+    // Применение логических смещений (LCD_X_OFFSET, LCD_Y_OFFSET)
+    x_start += LCD_X_OFFSET;
+    x_end += LCD_X_OFFSET;
+    y_start += LCD_Y_OFFSET;
+    y_end += LCD_Y_OFFSET;
+
+    // Ограничение координат логическим разрешением текущей ориентации
+    x_start = MAX(x_start, 0);
+    x_end = MIN(x_end, panel->orient->hor_res - 1);
+    y_start = MAX(y_start, 0);
+    y_end = MIN(y_end, panel->orient->ver_res - 1);
+    if (x_start > x_end || y_start > y_end) {
+        ESP_LOGD(TAG, "Draw area is off screen");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (clamped) {
+        *clamped = (lcd_area_t){
+            .x_start = x_start - LCD_X_OFFSET, .x_end = x_end - LCD_X_OFFSET,
+            .y_start = y_start - LCD_Y_OFFSET, .y_end = y_end - LCD_Y_OFFSET,
+        };
+    }
+
+    // Преобразование в адреса памяти панели функцией текущей ориентации, без проверки режима поворота
+    lcd_area_t addr;
+    panel->window.map(panel, &(lcd_area_t){.x_start = x_start, .x_end = x_end, .y_start = y_start, .y_end = y_end}, &addr);
+    uint16_t col_start = addr.x_start;
+    uint16_t col_end = addr.x_end;
+    uint16_t row_start = addr.y_start;
+    uint16_t row_end = addr.y_end;
+
+    ESP_LOGD(TAG, "Physical draw area: cols=%d-%d, rows=%d-%d", col_start, col_end, row_start, row_end);
+
+    // Пример влияния: если дополнительно инвертировать координаты для 180° или 270° в режиме MADCTL, изображение
+    // будет перевёрнуто дважды, так как MADCTL уже выполнил инверсию.
+
+    uint8_t params[4];
+    esp_err_t ret;
+
+    // Установка CASET (столбцы), если окно по столбцам изменилось
+    if (panel->window.col_valid && panel->window.col_start == col_start && panel->window.col_end == col_end) {
+        bus_stats.caset_skipped++;
+    } else {
+        params[0] = (col_start >> 8) & 0xFF;
+        params[1] = col_start & 0xFF;
+        params[2] = (col_end >> 8) & 0xFF;
+        params[3] = col_end & 0xFF;
+        ret = lcd_tx_param(panel, 0x2A, params, 4);
+        if (ret != ESP_OK) {
+            panel->window.col_valid = false;
+            ESP_LOGE(TAG, "CASET failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        panel->window.col_start = col_start;
+        panel->window.col_end = col_end;
+        panel->window.col_valid = true;
+    }
+
+    // Установка RASET (строки), если окно по строкам изменилось
+    if (panel->window.row_valid && panel->window.row_start == row_start && panel->window.row_end == row_end) {
+        bus_stats.raset_skipped++;
+    } else {
+        params[0] = (row_start >> 8) & 0xFF;
+        params[1] = row_start & 0xFF;
+        params[2] = (row_end >> 8) & 0xFF;
+        params[3] = row_end & 0xFF;
+        ret = lcd_tx_param(panel, 0x2B, params, 4);
+        if (ret != ESP_OK) {
+            panel->window.row_valid = false;
+            ESP_LOGE(TAG, "RASET failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        panel->window.row_start = row_start;
+        panel->window.row_end = row_end;
+        panel->window.row_valid = true;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Передача области в развёртке MADCTL (окно уже задано set_draw_area): одна транзакция RAMWR.
+ * Если обрезаны столбцы, строки буфера идут отдельными передачами, и функция дожидается их окончания.
+ * @param panel Панель
+ * @param data Пиксели области построчно
+ * @param stride Длина строки data в пикселях (не меньше w, если область обрезана экраном)
+ * @param w Ширина области
+ * @param h Высота области
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t draw_area_direct(lcd_panel_t *panel, const uint16_t *data, int stride, int w, int h) {
+    if (w == stride) {
+        return lcd_tx_color(panel, 0x2C, data, (size_t)w * h * sizeof(uint16_t));
+    }
+    esp_err_t ret = ESP_OK;
+    int cmd = 0x2C;
+    for (int row = 0; ret == ESP_OK && row < h; row++) {
+        ret = lcd_tx_color(panel, cmd, data + (size_t)row * stride, (size_t)w * sizeof(uint16_t));
+        cmd = -1;
+    }
+    if (ret == ESP_OK) {
+        ret = wait_lcd_transfers(panel);
+    }
+    return ret;
+}
+
+/**
+ * Программный поворот области в развёртку панели и её передача (окно уже задано set_draw_area).
+ * Логические столбцы области становятся строками стекла: при 90° — слева направо (поворот по часовой),
+ * при 270° — справа налево (против часовой). Область LVGL целиком помещается в буфер поворота lcd_panel_t.rotate
+ * и уходит одной передачей; большие области (кадры в обход LVGL) идут полосами строк стекла с ожиданием между ними.
+ * Перед записью в буфер поворота дожидается окончания передачи, которая ещё читает его.
+ * @param panel Панель
+ * @param data Пиксели области построчно
+ * @param stride Длина строки data в пикселях (не меньше w, если область обрезана экраном)
+ * @param w Ширина области (логическая)
+ * @param h Высота области (логическая)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t draw_area_rotated(lcd_panel_t *panel, const uint16_t *data, int stride, int w, int h) {
+    if (!panel->rotate.buf) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool clockwise = panel->orient->clockwise;
+    int band = MAX((int)(panel->rotate.buf_pixels / h), 1); // Строк стекла (логических столбцов) за передачу
+    int cmd = 0x2C;
+    for (int r0 = 0; r0 < w; r0 += band) {
+        int k = MIN(band, w - r0);
+        if ((int32_t)(panel->color_done - panel->rotate.busy_until) < 0) {
+            esp_err_t ret = wait_lcd_transfers(panel);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        // Полоса — столбцы r0..r0+k-1 в порядке строк стекла: при 270° это столбцы с правого края
+        const uint16_t *src = data + (clockwise ? r0 : w - r0 - k);
+        uint32_t c0 = lcd_perf_cycles();
+        rgb565_rotate90(panel->rotate.buf, src, stride, k, h, clockwise);
+        panel->rotate.cycles += lcd_perf_cycles() - c0;
+        panel->rotate.pixels += (uint64_t)k * h;
+
+        esp_err_t ret = lcd_tx_color(panel, cmd, panel->rotate.buf, (size_t)k * h * sizeof(uint16_t));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        panel->rotate.busy_until = panel->color_queued;
+        cmd = -1;
+    }
+    return ESP_OK;
+}
+
+esp_err_t draw_area(lcd_panel_t *panel, int x_start, int x_end, int y_start, int y_end, const void *data) {
+    uint32_t t0 = lcd_perf_cycles();
+    lcd_area_t win;
+    esp_err_t ret = set_draw_area(panel, x_start, x_end, y_start, y_end, &win);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    uint32_t t1 = lcd_perf_cycles();
+    if (panel->perf_set_area) {
+        lcd_perf_hist_add(panel->perf_set_area, t1 - t0);
+    }
+
+    // Размер передачи — по окну, которое получила панель; строки буфера остаются длиной исходной области
+    int stride = x_end - x_start + 1;
+    int w = win.x_end - win.x_start + 1;
+    int h = win.y_end - win.y_start + 1;
+    const uint16_t *src = (const uint16_t *)data + (size_t)(win.y_start - y_start) * stride + (win.x_start - x_start);
+
+    // RAMWR сбрасывает указатель записи на начало окна, поэтому повторять CASET/RASET не нужно;
+    // передачу (прямую или с программным поворотом) выбрал lcd_panel_set_orientation
+    ret = panel->window.write(panel, src, stride, w, h);
+    if (panel->perf_tx_color) {
+        lcd_perf_hist_add(panel->perf_tx_color, lcd_perf_cycles() - t1);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "RAMWR failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t fill_area(lcd_panel_t *panel, int x_start, int x_end, int y_start, int y_end, uint16_t color) {
+    if (!panel->fill_buf) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Перезаполнение буфера: предыдущая заливка могла ещё читать его через DMA.
+    // Порядок байт учитывается один раз на цвет, а не на каждый пиксель.
+    uint16_t buffer_color = lcd_buffer_color(color);
+    if (!panel->fill_valid || panel->fill_color != buffer_color) {
+        esp_err_t ret = wait_lcd_transfers(panel);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        rgb565_fill(panel->fill_buf, buffer_color, LCD_FILL_BUF_PIXELS);
+        panel->fill_color = buffer_color;
+        panel->fill_valid = true;
+    }
+
+    lcd_area_t win;
+    esp_err_t ret = set_draw_area(panel, x_start, x_end, y_start, y_end, &win);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Первый кусок идёт с RAMWR, остальные — продолжение записи без команды
+    size_t remaining = (size_t)(win.x_end - win.x_start + 1) * (win.y_end - win.y_start + 1) * sizeof(uint16_t);
+    int cmd = 0x2C;
+    while (remaining > 0) {
+        size_t chunk = MIN(remaining, LCD_FILL_BUF_PIXELS * sizeof(uint16_t));
+        ret = lcd_tx_color(panel, cmd, panel->fill_buf, chunk);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Fill chunk failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        cmd = -1;
+        remaining -= chunk;
+    }
+    return ESP_OK;
+}
+
+esp_err_t clear_screen(lcd_panel_t *panel, uint16_t color) {
+    ESP_LOGI(TAG, "Clearing screen with color 0x%04X, free heap: %" PRIu32, color, esp_get_free_heap_size());
+
+    // Определение размеров области в зависимости от ориентации
+    int hor_res = panel->orient->hor_res;
+    int ver_res = panel->orient->ver_res;
+
+    size_t heap_before = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    size_t min_before = heap_caps_get_minimum_free_size(MALLOC_CAP_DMA);
+    int64_t start_us = esp_timer_get_time();
+
+    // Заливка всего экрана и ожидание окончания DMA
+    esp_err_t ret = fill_area(panel, 0, hor_res - 1, 0, ver_res - 1, color);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fill failed: %s", esp_err_to_name(ret));
+    }
+    wait_lcd_transfers(panel);
+
+    // Отчёт: пропускная способность и пик памяти DMA. Разница свободной памяти до и после не видит выделений,
+    // освобождённых внутри заливки, поэтому пик берётся по минимуму свободной памяти с момента старта:
+    // если минимум опустился во время заливки, на пике она занимала heap_before - min_after байт,
+    // иначе её пик не ниже прежнего минимума и отдельно не виден (0)
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    size_t bytes = (size_t)hor_res * ver_res * sizeof(uint16_t);
+    size_t heap_after = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    size_t min_after = heap_caps_get_minimum_free_size(MALLOC_CAP_DMA);
+    int peak = min_after < min_before ? (int)heap_before - (int)min_after : 0;
+    ESP_LOGI(TAG, "Clear done: %u bytes in %" PRId64 " us (%" PRId64 " bytes/s), fill buffer %u bytes, "
+             "DMA heap peak %d bytes (min free %u), delta %d bytes",
+             (unsigned)bytes, elapsed_us, elapsed_us > 0 ? (int64_t)bytes * 1000000 / elapsed_us : (int64_t)0,
+             (unsigned)(LCD_FILL_BUF_PIXELS * sizeof(uint16_t)), peak, (unsigned)min_after,
+             (int)heap_before - (int)heap_after);
+
+    // Пример влияния: если не дождаться окончания DMA, следующая смена цвета перезапишет fill_buf
+    // во время передачи, и часть экрана будет залита новым цветом.
+
+    return ret;
+}
+
+esp_err_t lcd_panel_set_orientation(lcd_panel_t *panel, display_orientation_t orientation, bool sw_rotate) {
+    ESP_LOGI(TAG, "Setting display orientation: %d", orientation);
+    if ((unsigned)orientation >= LCD_ORIENTATIONS) {
+        ESP_LOGE(TAG, "Invalid orientation: %d", orientation);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // MADCTL, разрешение и смещения — из таблицы lcd_orientations. Регистр MADCTL управляет ориентацией
+    // и порядком сканирования: MY — инверсия строк, MX — инверсия столбцов, MV — обмен осей, BGR — порядок цветов
+    const lcd_orientation_desc_t *desc = &lcd_orientations[orientation];
+    const lcd_orientation_desc_t *scan = desc; // Строка таблицы, по которой панель пишет память
+    // В 0° и 180° панель всегда поворачивает сама
+    sw_rotate = sw_rotate && desc->landscape;
+    if (sw_rotate) {
+        // Программный поворот: панель в развёртке 0°, поворачивают set_draw_area и draw_area;
+        // для LVGL экран остаётся альбомным
+        scan = &lcd_orientations[DISPLAY_ORIENTATION_0];
+    }
+    uint8_t madctl = scan->madctl;
+
+    // Пример влияния: если установить madctl=0x00 (BGR=0), цвета будут в формате RGB, что может
+    // привести к неправильному отображению (например, красный станет синим).
+    // Неправильные x_gap/y_gap (например, x_gap=0 для 0°) сместят изображение влево или обрежут его.
+
+    // Отправка команды MADCTL для установки ориентации
+    esp_err_t ret = lcd_tx_param(panel, 0x36, &madctl, 1);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set MADCTL: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Установка смещений x_gap и y_gap в окне адресации; кэш CASET/RASET сбрасывается,
+    // так как после смены MADCTL те же адреса означают другую область панели
+    panel->window.x_gap = scan->x_gap;
+    panel->window.y_gap = scan->y_gap;
+    panel->window.col_valid = false;
+    panel->window.row_valid = false;
+    panel->window.sw_rotate = sw_rotate;
+    panel->window.map = sw_rotate ? lcd_window_map_rotated : lcd_window_map_madctl;
+    panel->window.write = sw_rotate ? draw_area_rotated : draw_area_direct;
+    ESP_LOGI(TAG, "Set display gap: x_gap=%d, y_gap=%d", scan->x_gap, scan->y_gap);
+
+    // Обновление текущей ориентации
+    panel->orientation = orientation;
+    panel->orient = desc;
+
+    return ESP_OK;
+}
+
+/**
+ * Callback завершения передачи по шине i80 (вызывается из ISR): считает передачу в color_done панели,
+ * возвращает кредит очереди шины, будит ожидающих в lcd_bus_take_credit и передаёт окончание
+ * обработчику приложения lcd_panel_t.on_trans_done (в том числе для заливок).
+ * @param panel_io Дескриптор интерфейса i80
+ * @param edata Данные события (не используются)
+ * @param user_ctx Панель, которой принадлежит интерфейс
+ * @return true, если разбуженная задача требует переключения контекста
+ */
+static bool lcd_trans_done_isr(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx) {
+    lcd_panel_t *panel = user_ctx;
+    panel->color_done++;
+    // Кредит очереди шины возвращается на каждое окончание передачи, в том числе заливок
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(lcd_bus.credits, &woken);
+    xSemaphoreGiveFromISR(lcd_bus.done_sem, &woken);
+    bool yield = woken == pdTRUE;
+    if (panel->on_trans_done && panel->on_trans_done(panel)) {
+        yield = true;
+    }
+    return yield;
+}
+
+void log_panel_stats(void) {
+    int64_t now = esp_timer_get_time();
+    int64_t period_us = now - lcd_bus.logged_us;
+    uint64_t bus_bytes = 0;
+    for (int i = 0; i < lcd_bus.users; i++) {
+        bus_bytes += lcd_bus.panels[i]->stats.color_bytes - lcd_bus.panels[i]->stats.logged_bytes;
+    }
+    for (int i = 0; i < lcd_bus.users; i++) {
+        lcd_panel_stats_t *stats = &lcd_bus.panels[i]->stats;
+        uint64_t bytes = stats->color_bytes - stats->logged_bytes;
+        ESP_LOGI(TAG, "Panel CS %d: color tx=%" PRIu32 ", color bytes=%" PRIu64 ", frames=%" PRIu32 ", %" PRIu64
+                 " KB/s over %" PRId64 " ms (%" PRIu64 "%% of bus bytes), queue share %d of %d, tx wait=%" PRIu64 " us, yields=%" PRIu32,
+                 lcd_bus.panels[i]->cs_gpio, stats->color_tx, stats->color_bytes, stats->frames,
+                 period_us > 0 ? bytes * 1000000 / (uint64_t)period_us / 1024 : (uint64_t)0, period_us / 1000,
+                 bus_bytes ? bytes * 100 / bus_bytes : (uint64_t)0, lcd_bus_share(), LCD_TRANS_QUEUE_DEPTH,
+                 stats->tx_cycles / LCD_PERF_CPU_MHZ, stats->yields);
+        stats->logged_bytes = stats->color_bytes;
+    }
+    lcd_bus.logged_us = now;
+}
+
+/**
+ * Создаёт интерфейс панели на шине i80 с заданной частотой пиксельного тактирования.
+ * @param panel Панель (шина и линия CS уже заданы)
+ * @param pclk_hz Частота pclk в Гц
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t create_panel_io(lcd_panel_t *panel, uint32_t pclk_hz) {
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = panel->cs_gpio, // Пин Chip Select
+        .pclk_hz = pclk_hz, // Частота тактирования
+        .trans_queue_depth = LCD_TRANS_QUEUE_DEPTH, // Глубина очереди передачи интерфейса панели
+        .on_color_trans_done = lcd_trans_done_isr, // Callback окончания DMA: кредит шины и lcd_panel_t.on_trans_done
+        .user_ctx = panel,                        // Панель: её счётчики передач и обработчик приложения
+        .dc_levels = {
+            .dc_idle_level = 0,
+            .dc_cmd_level = 0,  // Уровень для команд
+            .dc_dummy_level = 0,
+            .dc_data_level = 1, // Уровень для данных
+        },
+        .flags = {
+            .cs_active_high = 0, // CS активен на низком уровне
+            .reverse_color_bits = 0, // Без инверсии порядка бит
+            .swap_color_bytes = lcd_byte_order == LCD_BYTE_ORDER_DMA, // Перестановка байтов RGB565 при передаче (только политика DMA)
+            .pclk_active_neg = 0,    // Тактирование на положительном фронте
+        },
+        .lcd_cmd_bits = LCD_CMD_BITS,   // 8 бит для команд
+        .lcd_param_bits = LCD_PARAM_BITS // 8 бит для параметров
+    };
+    ESP_LOGI(TAG, "i80 config: swap_color_bytes=%d, reverse_color_bits=%d (byte order: %s)", io_config.flags.swap_color_bytes,
+             io_config.flags.reverse_color_bits, lcd_byte_order_name(lcd_byte_order));
+    esp_err_t ret = esp_lcd_new_panel_io_i80(panel->bus, &io_config, &panel->io);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create i80 panel IO at %" PRIu32 " Hz: %s", pclk_hz, esp_err_to_name(ret));
+        return ret;
+    }
+    panel->pclk_hz = pclk_hz;
+    return ESP_OK;
+}
+
+/**
+ * Создаёт дескриптор ST7789 поверх текущего интерфейса панели. Команд панели не отправляет.
+ * @param panel Панель (интерфейс и пин сброса уже заданы)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t create_panel_handle(lcd_panel_t *panel) {
+    esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = panel->reset_gpio, // Пин сброса
+        .color_space = ESP_LCD_COLOR_SPACE_RGB, // Цветовое пространство RGB
+        .bits_per_pixel = 16, // 16 бит на пиксель (RGB565)
+    };
+    return esp_lcd_new_panel_st7789(panel->io, &panel_config, &panel->panel);
+}
+
+/**
+ * Удаляет семафоры очереди шины (вместе с шиной или при ошибке её создания).
+ */
+static void lcd_bus_delete_sems(void) {
+    if (lcd_bus.credits) {
+        vSemaphoreDelete(lcd_bus.credits);
+        lcd_bus.credits = NULL;
+    }
+    if (lcd_bus.done_sem) {
+        vSemaphoreDelete(lcd_bus.done_sem);
+        lcd_bus.done_sem = NULL;
+    }
+}
+
+/**
+ * Подключает панель к общей шине i80: первая панель создаёт шину, следующие получают ту же.
+ * @param panel Панель
+ * @return ESP_OK при успехе, ESP_ERR_NO_MEM, если на шине уже LCD_BUS_MAX_PANELS панелей, иначе код ошибки
+ */
+static esp_err_t lcd_bus_attach(lcd_panel_t *panel) {
+    if (lcd_bus.users >= LCD_BUS_MAX_PANELS) {
+        ESP_LOGE(TAG, "No room for panel on CS %d: %d panels on the bus", panel->cs_gpio, lcd_bus.users);
+        return ESP_ERR_NO_MEM;
+    }
+    if (!lcd_bus.handle) {
+        esp_lcd_i80_bus_config_t bus_config = {
+            .clk_src = LCD_CLK_SRC_DEFAULT, // Источник тактирования (по умолчанию PLL)
+            .dc_gpio_num = LCD_PIN_DC,      // Пин для Data/Command
+            .wr_gpio_num = LCD_PIN_WR,      // Пин для записи
+            .data_gpio_nums = {
+                LCD_PIN_DATA0, LCD_PIN_DATA1, LCD_PIN_DATA2, LCD_PIN_DATA3,
+                LCD_PIN_DATA4, LCD_PIN_DATA5, LCD_PIN_DATA6, LCD_PIN_DATA7,
+            },
+            .bus_width = 8, // 8-битная шина
+            .max_transfer_bytes = LCD_H_RES * LCD_V_RES * sizeof(uint16_t), // Максимальный размер передачи
+            .psram_trans_align = LCD_PSRAM_TRANS_ALIGN, // Выравнивание для PSRAM
+            .sram_trans_align = 4,   // Выравнивание для SRAM
+        };
+        lcd_bus.credits = xSemaphoreCreateCounting(LCD_TRANS_QUEUE_DEPTH, LCD_TRANS_QUEUE_DEPTH);
+        lcd_bus.done_sem = xSemaphoreCreateBinary();
+        if (!lcd_bus.credits || !lcd_bus.done_sem) {
+            ESP_LOGE(TAG, "Failed to create i80 bus queue semaphores");
+            lcd_bus_delete_sems();
+            return ESP_ERR_NO_MEM;
+        }
+        esp_err_t ret = esp_lcd_new_i80_bus(&bus_config, &lcd_bus.handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create i80 bus: %s", esp_err_to_name(ret));
+            lcd_bus_delete_sems();
+            return ret;
+        }
+        lcd_bus.logged_us = esp_timer_get_time();
+    }
+    lcd_bus.panels[lcd_bus.users++] = panel;
+    panel->bus = lcd_bus.handle;
+    return ESP_OK;
+}
+
+/**
+ * Отключает панель от общей шины; шина удаляется вместе с последней панелью.
+ * Интерфейс панели к этому моменту должен быть удалён: шину с устройствами удалить нельзя.
+ * @param panel Панель
+ * @return ESP_OK при успехе, иначе код ошибки удаления шины
+ */
+static esp_err_t lcd_bus_detach(lcd_panel_t *panel) {
+    for (int i = 0; i < lcd_bus.users; i++) {
+        if (lcd_bus.panels[i] == panel) {
+            memmove(&lcd_bus.panels[i], &lcd_bus.panels[i + 1], (lcd_bus.users - i - 1) * sizeof(lcd_bus.panels[0]));
+            lcd_bus.users--;
+            break;
+        }
+    }
+    panel->bus = NULL;
+    if (lcd_bus.users > 0 || !lcd_bus.handle) {
+        return ESP_OK;
+    }
+    esp_err_t ret = esp_lcd_del_i80_bus(lcd_bus.handle);
+    lcd_bus.handle = NULL;
+    lcd_bus_delete_sems();
+    return ret;
+}
+
+esp_err_t lcd_panel_deinit(lcd_panel_t *panel) {
+    esp_err_t ret = ESP_OK;
+    if (panel->io) {
+        esp_lcd_panel_io_tx_param(panel->io, -1, NULL, 0); // Буферы нельзя освобождать, пока их читает DMA
+    }
+    if (panel->panel) {
+        ret = esp_lcd_panel_del(panel->panel);
+        panel->panel = NULL;
+    }
+    if (panel->io) {
+        esp_err_t err = esp_lcd_panel_io_del(panel->io);
+        ret = ret == ESP_OK ? err : ret;
+        panel->io = NULL;
+    }
+    if (panel->bus) {
+        esp_err_t err = lcd_bus_detach(panel);
+        ret = ret == ESP_OK ? err : ret;
+    }
+    heap_caps_free(panel->fill_buf);
+    panel->fill_buf = NULL;
+    panel->fill_valid = false;
+    panel->window.col_valid = false;
+    panel->window.row_valid = false;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Panel deinit failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t lcd_panel_init(lcd_panel_t *panel, int cs_gpio, int reset_gpio, uint32_t pclk_hz) {
+    if (panel->bus || panel->io || panel->panel || panel->fill_buf) {
+        ESP_LOGE(TAG, "Panel on CS %d is already initialized", panel->cs_gpio);
+        return ESP_ERR_INVALID_STATE;
+    }
+    panel->cs_gpio = cs_gpio;
+    panel->reset_gpio = reset_gpio;
+
+    // Шина i80, общая для панелей
+    esp_err_t ret = lcd_bus_attach(panel);
+    if (ret != ESP_OK) {
+        goto fail;
+    }
+
+    // Интерфейс i80 с линией CS панели
+    ret = create_panel_io(panel, pclk_hz);
+    if (ret != ESP_OK) {
+        goto fail;
+    }
+
+    // Постоянный буфер заливки (используется clear_screen вместо полнокадрового буфера)
+    panel->fill_buf = heap_caps_malloc(LCD_FILL_BUF_PIXELS * sizeof(uint16_t), MALLOC_CAP_DMA);
+    if (!panel->fill_buf) {
+        ESP_LOGE(TAG, "Failed to allocate fill buffer");
+        ret = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+    panel->fill_valid = false;
+
+    // Дескриптор ST7789 и сброс
+    ret = create_panel_handle(panel);
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_reset(panel->panel);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create and reset ST7789 panel: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+    // Пример влияния: после отпускания RESX панели нужно 5 мс до первой команды; esp_lcd_panel_reset
+    // уже выдерживает 10 мс, поэтому в быстром старте дополнительной паузы нет.
+    // Аппаратный сброс второй панели по общей линии RST стёр бы изображение первой, поэтому она сбрасывается SWRESET.
+
+    // После сброса в памяти панели MADCTL и окно по умолчанию; до lcd_panel_set_orientation — без поворота
+    panel->window.col_valid = false;
+    panel->window.row_valid = false;
+    panel->window.map = lcd_window_map_madctl;
+    panel->window.write = draw_area_direct;
+    return ESP_OK;
+
+fail:
+    lcd_panel_deinit(panel);
+    return ret;
+}
+
+esp_err_t recreate_panel_io(lcd_panel_t *panel, uint32_t pclk_hz) {
+    esp_lcd_panel_io_tx_param(panel->io, -1, NULL, 0); // Дождаться передач панели, как wait_lcd_transfers
+    esp_err_t ret = esp_lcd_panel_del(panel->panel);
+    panel->panel = NULL;
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_io_del(panel->io);
+        panel->io = NULL;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to delete i80 panel IO on CS %d: %s", panel->cs_gpio, esp_err_to_name(ret));
+        return ret;
+    }
+    ret = create_panel_io(panel, pclk_hz);
+    if (ret == ESP_OK) {
+        ret = create_panel_handle(panel);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to recreate panel on CS %d at %" PRIu32 " Hz: %s", panel->cs_gpio, pclk_hz, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t set_pixel_clock(uint32_t pclk_hz) {
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; ret == ESP_OK && i < lcd_bus.users; i++) {
+        ret = recreate_panel_io(lcd_bus.panels[i], pclk_hz);
+    }
+    return ret;
+}
+
+int64_t lcd_send_init_commands(lcd_panel_t *panel, bool fast_boot) {
+    int64_t sleep_out_us = esp_timer_get_time();
+    for (size_t i = 0; lcd_st7789v[i + 1] != LCD_INIT_END; i += 2 + (lcd_st7789v[i + 1] & ~LCD_INIT_SLEEP_OUT)) {
+        uint8_t cmd = lcd_st7789v[i];
+        uint8_t len = lcd_st7789v[i + 1] & ~LCD_INIT_SLEEP_OUT;
+        if (!fast_boot) {
+            ESP_LOGI(TAG, "Sending cmd 0x%02X, len=%d", cmd, len);
+        }
+        esp_err_t ret = lcd_tx_param(panel, cmd, len ? &lcd_st7789v[i + 2] : NULL, len);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Cmd 0x%02X failed: %s", cmd, esp_err_to_name(ret));
+        }
+        if (lcd_st7789v[i + 1] & LCD_INIT_SLEEP_OUT) {
+            wait_lcd_transfers(panel);
+            sleep_out_us = esp_timer_get_time();
+            // Регистры можно писать уже через 5 мс; остаток LCD_SLEEP_OUT_MS при быстром старте
+            // проходит параллельно с дальнейшей инициализацией (у приложения — init_lvgl и первый кадр)
+            if (fast_boot) {
+                esp_rom_delay_us(LCD_SLEEP_OUT_CMD_MS * 1000); // Пауза короче тика FreeRTOS
+            } else {
+                vTaskDelay(pdMS_TO_TICKS(LCD_SLEEP_OUT_MS));
+            }
+        }
+    }
+    return sleep_out_us;
+}
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/param.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_panel_ops.h"
+#include "lvgl.h"
+#include "lcd_perf.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "esp_lcd_mock.h"                     // Эмулятор ST7789 вместо панели (хост-сборка)
+#endif
+
+/**
+ * Драйвер панелей ST7789 на общей 8-битной шине i80: ориентация (MADCTL или программный поворот),
+ * окно адресации CASET/RASET, передачи пикселей с долей очереди шины на панель, заливки и команды
+ * инициализации. Жизненный цикл панели — lcd_panel_init/lcd_panel_deinit.
+ *
+ * Драйвер ничего не знает о LVGL и режимах приложения: окончание передачи сообщается приложению
+ * через lcd_panel_t.on_trans_done, замеры этапов — через гистограммы perf_set_area/perf_tx_color.
+ */
+
+// Конфигурация пинов и параметров дисплея T-Display-S3
+#define LCD_PIXEL_CLOCK_HZ  (2 * 1000 * 1000) // Частота пиксельного тактирования: 2 МГц
+                                              // Влияние: слишком высокая частота (>20 МГц) может вызвать артефакты,
+                                              // слишком низкая (<1 МГц) замедлит рендеринг.
+#define LCD_BK_LIGHT_ON_LEVEL 1               // Уровень для включения подсветки (1 = включено)
+#define LCD_PIN_BK_LIGHT    38                // Пин подсветки
+#define LCD_PIN_CS          6                 // Пин Chip Select (CS) для выбора дисплея
+#define LCD_PIN_DC          7                 // Пин Data/Command для переключения между данными и командами
+#define LCD_PIN_RST         5                 // Пин сброса дисплея
+#define LCD_PIN_WR          8                 // Пин записи (WR) для синхронизации данных
+#define LCD_PIN_RD          9                 // Пин чтения (не используется, но должен быть настроен)
+#define LCD_PIN_DATA0       39                // Пины данных для 8-битной шины i80
+#define LCD_PIN_DATA1       40
+#define LCD_PIN_DATA2       41
+#define LCD_PIN_DATA3       42
+#define LCD_PIN_DATA4       45
+#define LCD_PIN_DATA5       46
+#define LCD_PIN_DATA6       47
+#define LCD_PIN_DATA7       48
+#define LCD_H_RES           170               // Физическое горизонтальное разрешение дисплея (170 пикселей)
+#define LCD_V_RES           320               // Физическое вертикальное разрешение дисплея (320 пикселей)
+#define LCD_CMD_BITS        8                 // Количество бит для команд
+#define LCD_PARAM_BITS      8                 // Количество бит для параметров
+#define LCD_X_OFFSET        0                 // Смещение области отображения по X (логическое)
+#define LCD_Y_OFFSET        0                 // Смещение области отображения по Y (логическое)
+#define LCD_FILL_BUF_LINES  16                // Размер буфера заливки в строках максимальной ширины (320 пикселей)
+                                              // Влияние: 16 строк = 10 КБ DMA-памяти; меньшее значение увеличит число
+                                              // транзакций на заливку, большее — не ускорит её, так как шина уже загружена.
+#define LCD_FILL_BUF_PIXELS (LCD_V_RES * LCD_FILL_BUF_LINES) // Размер буфера заливки в пикселях
+#define LCD_TRANS_QUEUE_DEPTH 10              // Передач в очереди интерфейса i80 каждой панели (trans_queue_depth) и бюджет шины
+                                              // Влияние: бюджет делится между панелями поровну (lcd_bus_may_queue): панель держит
+                                              // в очереди не больше своей доли, а поставив долю подряд, ждёт, пока её очередь
+                                              // опустеет и драйвер i80 перейдёт к другой панели, — длинная заливка не задержит чужие области.
+#define LCD_BUS_MAX_PANELS  4                 // Наибольшее число панелей на шине (линий CS)
+#define LCD_BUS_WAIT_MS     100               // Максимальное ожидание окончания передачи шины (страховка от потерянного прерывания)
+#define LCD_PSRAM_TRANS_ALIGN 64              // Выравнивание буферов в PSRAM для DMA (psram_trans_align шины i80, строка кэша)
+#define LCD_SLEEP_OUT_MS    120               // Sleep Out (0x11) -> Display On: стабилизация преобразователей напряжения
+#define LCD_SLEEP_OUT_CMD_MS 5                // Sleep Out -> следующая команда: панель загружает заводские значения регистров
+#define LCD_FRCTRL2_DEFAULT 0x0F              // FRCTRL2 из lcd_st7789v: 59 Гц
+
+// Порядок байт RGB565 (Kconfig): ST7789 принимает старший байт пикселя первым, CPU хранит младший первым.
+// Переставляет ровно одно звено — периферия при DMA, рендерер LVGL или сама панель (RAMCTRL).
+#if CONFIG_DISPLAY_BYTE_ORDER_LVGL
+#define LCD_BYTE_ORDER      LCD_BYTE_ORDER_RENDERER // LVGL рисует в порядке шины (LV_COLOR_16_SWAP)
+#elif CONFIG_DISPLAY_BYTE_ORDER_PANEL
+#define LCD_BYTE_ORDER      LCD_BYTE_ORDER_PANEL // Панель принимает младший байт первым
+#else
+#define LCD_BYTE_ORDER      LCD_BYTE_ORDER_DMA // Байты переставляет LCD_CAM (swap_color_bytes)
+#endif
+// Пример влияния: LV_COLOR_16_SWAP вместе с swap_color_bytes переставляет байты дважды,
+// и красный 0xF800 приходит на панель как 0x00F8 (синий с примесью зелёного).
+#if !CONFIG_DISPLAY_BYTE_ORDER_LVGL != !CONFIG_LV_COLOR_16_SWAP
+#error "LV_COLOR_16_SWAP must be set exactly when DISPLAY_BYTE_ORDER_LVGL is selected"
+#endif
+#define LCD_RAMCTRL_ENDIAN  0x08              // RAMCTRL (0xB0), второй параметр: пиксель младшим байтом вперёд
+
+// Перечисление для режимов ориентации дисплея
+typedef enum {
+    DISPLAY_ORIENTATION_0,   // 0°: физический x=логический x, y=логический y
+    DISPLAY_ORIENTATION_90,  // 90°: физический x=логический y, y=логический x
+    DISPLAY_ORIENTATION_180, // 180°: физический x=инверсия логического x, y=инверсия логического y
+    DISPLAY_ORIENTATION_270  // 270°: физический x=инверсия логического y, y=инверсия логического x
+} display_orientation_t;
+
+// Всё, что зависит от ориентации: строка таблицы lcd_orientations выбирается один раз при смене ориентации
+// и пути вывода берут значения из неё, а не пересчитывают их на каждую область
+typedef struct {
+    uint8_t madctl;             // MADCTL при повороте контроллером (MY, MX, MV, BGR)
+    int16_t hor_res, ver_res;   // Логическое разрешение
+    int16_t x_gap, y_gap;       // Смещения видимой области в адресах памяти панели при этом MADCTL
+    bool landscape;             // 90°/270°: логические оси переставлены относительно стекла
+    bool mirror_rows;           // MY: логическому началу соответствует нижняя строка памяти (180°, 270°)
+    bool clockwise;             // Программный поворот области — по часовой стрелке (90°), иначе против (270°)
+    // Перевод в стекло: gx = gx0 + gx_lx * lx + gx_ly * ly, gy = gy0 + gy_lx * lx + gy_ly * ly
+    int16_t gx0, gy0;
+    int8_t gx_lx, gx_ly, gy_lx, gy_ly;
+} lcd_orientation_desc_t;
+
+#define LCD_ORIENTATIONS    (DISPLAY_ORIENTATION_270 + 1) // Строк в таблице lcd_orientations
+
+// Строки ориентаций 0°, 90°, 180° и 270° (lcd_panel.c)
+extern const lcd_orientation_desc_t lcd_orientations[LCD_ORIENTATIONS];
+
+/**
+ * Переводит логические координаты в координаты стекла по строке таблицы ориентации.
+ * @param o Ориентация
+ * @param lx Логический X
+ * @param ly Логический Y
+ * @param gx Столбец стекла
+ * @param gy Строка стекла
+ */
+static inline void lcd_orientation_to_glass(const lcd_orientation_desc_t *o, int lx, int ly, int *gx, int *gy) {
+    *gx = o->gx0 + o->gx_lx * lx + o->gx_ly * ly;
+    *gy = o->gy0 + o->gy_lx * lx + o->gy_ly * ly;
+}
+
+// Звено, которое переводит пиксель RGB565 из порядка CPU в порядок шины
+typedef enum {
+    LCD_BYTE_ORDER_DMA,      // Буферы в порядке CPU, LCD_CAM меняет байты местами при передаче
+    LCD_BYTE_ORDER_RENDERER, // LVGL рисует сразу в порядке шины, сырые заливки переставляются один раз на цвет
+    LCD_BYTE_ORDER_PANEL,    // Буферы в порядке CPU, панель принимает младший байт первым (RAMCTRL ENDIAN)
+} lcd_byte_order_t;
+
+extern lcd_byte_order_t lcd_byte_order; // Текущая политика порядка байт (по умолчанию LCD_BYTE_ORDER)
+
+// Прямоугольная область в логических координатах, границы включительно
+typedef struct {
+    int x_start, x_end;
+    int y_start, y_end;
+} lcd_area_t;
+
+typedef struct lcd_panel_t lcd_panel_t;
+
+// Окно адресации ST7789: смещения текущей ориентации и последние отправленные CASET/RASET.
+// Единственное место, где логические координаты переводятся в адреса памяти панели.
+// Перевод окна и передача пикселей выбираются в lcd_panel_set_orientation, а не на каждую область
+typedef struct {
+    int x_gap, y_gap;           // Смещения области отображения для текущей ориентации
+    uint16_t col_start, col_end; // Последний отправленный CASET
+    uint16_t row_start, row_end; // Последний отправленный RASET
+    bool col_valid, row_valid;  // Значения CASET/RASET в панели известны
+    bool sw_rotate;             // Окно и пиксели поворачиваются на CPU (программный поворот в 90°/270°)
+    void (*map)(lcd_panel_t *panel, const lcd_area_t *area, lcd_area_t *addr); // Окно в адреса памяти: lcd_window_map_madctl или _rotated
+    esp_err_t (*write)(lcd_panel_t *panel, const uint16_t *data, int stride, int w, int h); // RAMWR: draw_area_direct или draw_area_rotated
+} lcd_window_t;
+
+// Передачи пикселей одной панели: её доля общей шины
+typedef struct {
+    uint32_t color_tx;          // Передач пикселей (lcd_tx_color)
+    uint64_t color_bytes;       // Байт пикселей
+    uint64_t tx_cycles;         // Тактов CPU в постановке передачи: растёт, пока панель ждёт свою долю очереди шины
+    uint32_t yields;            // Постановок, отложенных, чтобы шина перешла к другой панели
+    uint32_t frames;            // Выведено кадров LVGL (ISR)
+    uint64_t logged_bytes;      // color_bytes на момент прошлой строки статистики
+} lcd_panel_stats_t;
+
+// Программный поворот: область LVGL целиком помещается в буфер поворота, поэтому flush остаётся одной передачей DMA
+typedef struct {
+    uint16_t *buf;              // Буфер поворота (владеет приложение; NULL — программный поворот недоступен)
+    size_t buf_pixels;          // Пикселей в buf
+    uint32_t busy_until;        // color_queued последней передачи из buf (свободен, когда color_done панели дошёл)
+    uint64_t cycles;            // Тактов CPU на поворот
+    uint64_t pixels;            // Повёрнуто пикселей
+} lcd_rotate_t;
+
+// Панель ST7789 на шине i80: дескрипторы esp_lcd, ориентация, окно адресации, буфер заливки и дисплей LVGL.
+// Создаётся lcd_panel_init и освобождается lcd_panel_deinit. Функции вывода получают панель параметром
+struct lcd_panel_t {
+    esp_lcd_i80_bus_handle_t bus;     // Общая шина i80 (lcd_bus; нужна для пересоздания интерфейса при смене pclk)
+    esp_lcd_panel_io_handle_t io;     // Интерфейс i80
+    esp_lcd_panel_handle_t panel;     // Дескриптор панели (сброс при инициализации; команды идут через io)
+    int cs_gpio;                      // Пин Chip Select
+    int reset_gpio;                   // Пин сброса (-1 — SWRESET); нужен для пересоздания дескриптора панели
+    uint32_t pclk_hz;                 // Текущая частота пиксельного тактирования
+    display_orientation_t orientation; // Текущая ориентация
+    const lcd_orientation_desc_t *orient; // Строка таблицы lcd_orientations для текущей ориентации
+    lcd_window_t window;              // Окно адресации
+    lcd_rotate_t rotate;              // Программный поворот
+    uint16_t *fill_buf;               // Постоянный DMA-буфер заливки: полоса пикселей одного цвета
+    uint16_t fill_color;              // Цвет, которым сейчас заполнен fill_buf (в порядке байт буфера, см. lcd_buffer_color)
+    bool fill_valid;                  // fill_buf заполнен цветом fill_color
+
+    // Передачи пикселей: DMA выполняет очередь интерфейса по порядку, поэтому буфер передачи номер N свободен,
+    // когда color_done >= N (так полосы заставки чередуют половины fill_buf без ожидания всей очереди).
+    // Счётчики у каждой панели свои: между интерфейсами шина переключается не в порядке постановки
+    uint32_t color_queued;            // Поставлено в очередь (lcd_tx_color)
+    volatile uint32_t color_done;     // Завершено (ISR окончания передачи)
+    uint32_t bus_burst;               // Передач, поставленных подряд с момента, когда очередь панели была пуста
+    lcd_panel_stats_t stats;          // Доля шины
+
+    // Связь с приложением: окончание передачи и замеры этапов draw_area
+    bool (*on_trans_done)(lcd_panel_t *panel); // Из ISR после возврата кредита шины; true — нужно переключение контекста (NULL — нет)
+    lcd_perf_hist_t *perf_set_area;   // Гистограмма CASET/RASET в draw_area (такты; NULL — без замера)
+    lcd_perf_hist_t *perf_tx_color;   // Гистограмма постановки RAMWR в draw_area (такты; NULL — без замера)
+
+    // Дисплей LVGL панели; у основной панели статистику областей ведёт приложение
+    lv_disp_t *disp;                  // Дескриптор дисплея (NULL, пока не зарегистрирован)
+    lv_disp_drv_t disp_drv;           // Драйвер дисплея (в панели, так как нужен в ISR завершения DMA)
+    lv_disp_draw_buf_t draw_buf;      // Описание буферов рендеринга
+    lv_color_t *lvgl_buf[2];          // Буферы рендеринга дополнительной панели (у основной — lvgl_buf_layout)
+    volatile bool lvgl_pending;       // Ожидается окончание DMA области LVGL (дополнительная панель)
+    volatile bool lvgl_last_area;     // Текущая область — последняя в кадре (дополнительная панель)
+};
+
+// Шина i80, общая для всех панелей: создаётся первой панелью и удаляется вместе с последней.
+// Очередь шины — LCD_TRANS_QUEUE_DEPTH кредитов: lcd_tx_color берёт кредит на каждую передачу,
+// ISR окончания передачи возвращает его
+typedef struct {
+    esp_lcd_i80_bus_handle_t handle;  // Шина (NULL, пока нет ни одной панели)
+    SemaphoreHandle_t credits;        // Счётный семафор кредитов очереди шины
+    SemaphoreHandle_t done_sem;       // Выдаётся на каждое окончание передачи; на нём ждёт lcd_bus_take_credit
+    lcd_panel_t *panels[LCD_BUS_MAX_PANELS]; // Панели на шине, в порядке инициализации
+    int users;                        // Панелей на шине
+    int64_t logged_us;                // Момент прошлой строки статистики панелей
+} lcd_bus_t;
+
+extern lcd_bus_t lcd_bus;
+
+// Счётчики транзакций шины i80 (для оценки накладных расходов на команды)
+typedef struct {
+    uint32_t cmd_tx;            // Командных транзакций (tx_param)
+    uint32_t color_tx;          // Транзакций с пиксельными данными (tx_color)
+    uint64_t cmd_bytes;         // Передано байт команд и их параметров (включая RAMWR перед пикселями)
+    uint32_t caset_skipped;     // Пропущенных CASET (окно не изменилось)
+    uint32_t raset_skipped;     // Пропущенных RASET (окно не изменилось)
+    uint64_t color_bytes;       // Передано байт пиксельных данных
+    uint32_t flush_tx;          // Транзакций, выполненных внутри lvgl_flush_cb
+} lcd_bus_stats_t;
+
+extern lcd_bus_stats_t bus_stats;
+
+// CRC32 пиксельных данных, поставленных в очередь DMA: считается в lcd_tx_color, пока включён.
+// Подтверждает только то, что отправлено, а не то, что панель приняла и сохранила
+extern bool push_crc_enabled;
+extern uint32_t push_crc;
+
+/**
+ * Шаг ожидания прерывания окончания DMA. На устройстве ничего не делает: передачи завершает периферия.
+ * На хосте эмулятор в режиме отложенного окончания выполняет передачи только по запросу,
+ * поэтому пока CPU ждёт, шина выполняет следующую передачу из очереди.
+ */
+static inline void lcd_dma_wait_step(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    esp_lcd_mock_pump(lcd_bus.handle, 1);
+#endif
+}
+
+/**
+ * @param panel Панель
+ * @return Передач панели в очереди шины: поставлены, но ещё не завершены
+ */
+static inline int lcd_panel_in_flight(const lcd_panel_t *panel) {
+    // color_done растёт в ISR и может обогнать color_queued, пока постановка ещё не вернулась
+    int32_t n = (int32_t)(panel->color_queued - panel->color_done);
+    return n > 0 ? n : 0;
+}
+
+/**
+ * @return Доля бюджета очереди шины на одну панель
+ */
+static inline int lcd_bus_share(void) {
+    return MAX(LCD_TRANS_QUEUE_DEPTH / MAX(lcd_bus.users, 1), 1);
+}
+
+/**
+ * Повёрнута ли текущая ориентация на CPU: программный поворот включён, и экран в 90° или 270°.
+ * Тогда панель работает в развёртке 0°, а set_draw_area и draw_area поворачивают окно и пиксели.
+ * Признак выбирается в lcd_panel_set_orientation; путь вывода областей его не проверяет,
+ * а вызывает выбранные там lcd_window_t.map и lcd_window_t.write.
+ * @param panel Панель
+ * @return true при программном повороте
+ */
+static inline bool lcd_rotate_active(lcd_panel_t *panel) {
+    return panel->window.sw_rotate;
+}
+
+/**
+ * Переводит цвет из порядка CPU в порядок, в котором его должен хранить буфер для DMA.
+ * Все пути вывода в обход LVGL (заливки, тестовые кадры) получают цвет только через эту функцию.
+ * Переставлять нужно лишь при LCD_BYTE_ORDER_RENDERER: DMA передаёт буфер как есть, а пиксели LVGL уже переставлены.
+ * @param color Цвет RGB565 в порядке CPU
+ * @return Цвет в порядке байт буфера
+ */
+static inline uint16_t lcd_buffer_color(uint16_t color) {
+    return lcd_byte_order == LCD_BYTE_ORDER_RENDERER ? (uint16_t)((color << 8) | (color >> 8)) : color;
+}
+
+/**
+ * Подключает панель к общей шине i80 (создаёт её для первой панели), создаёт интерфейс с линией CS,
+ * буфер заливки и дескриптор ST7789 и сбрасывает панель. Команды инициализации отправляет вызывающий
+ * (lcd_send_init_commands). Повторная инициализация без lcd_panel_deinit отвергается; при ошибке
+ * на любом шаге всё уже созданное освобождается, и панель остаётся пустой.
+ * @param panel Панель
+ * @param cs_gpio Пин Chip Select
+ * @param reset_gpio Пин сброса; -1 — сброс командой SWRESET (линия RST общая с уже работающей панелью)
+ * @param pclk_hz Частота pclk в Гц
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_STATE для уже инициализированной панели, иначе код ошибки
+ */
+esp_err_t lcd_panel_init(lcd_panel_t *panel, int cs_gpio, int reset_gpio, uint32_t pclk_hz);
+
+/**
+ * Освобождает всё, чем владеет панель: дескриптор панели, интерфейс, буфер заливки и место на шине
+ * (шина удаляется вместе с последней панелью). Дожидается окончания передач; после вызова дескрипторы обнулены,
+ * поэтому повторный вызов ничего не делает, а панель можно снова инициализировать.
+ * Подходит и для частично инициализированной панели. Дисплей LVGL панели должен быть уже удалён.
+ * @param panel Панель
+ * @return ESP_OK при успехе, иначе код первой ошибки освобождения
+ */
+esp_err_t lcd_panel_deinit(lcd_panel_t *panel);
+
+/**
+ * Отправляет панели команды инициализации lcd_st7789v. После Sleep Out при быстром старте
+ * выдерживается только LCD_SLEEP_OUT_CMD_MS: остаток LCD_SLEEP_OUT_MS проходит параллельно с дальнейшей
+ * инициализацией, и вызывающий дожидается его перед Display On.
+ * @param panel Панель
+ * @param fast_boot true — быстрый старт: короткая пауза после Sleep Out и без лога каждой команды
+ * @return Момент Sleep Out (esp_timer_get_time), от которого отсчитывается LCD_SLEEP_OUT_MS
+ */
+int64_t lcd_send_init_commands(lcd_panel_t *panel, bool fast_boot);
+
+/**
+ * Пересоздаёт интерфейс i80 панели с заданной частотой и текущей политикой порядка байт, а дескриптор панели —
+ * поверх нового интерфейса (он хранит указатель на интерфейс и иначе ссылался бы на удалённый).
+ * Панель не сбрасывается, поэтому MADCTL, окно CASET/RASET и содержимое памяти сохраняются.
+ * @param panel Панель на шине
+ * @param pclk_hz Частота pclk в Гц
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t recreate_panel_io(lcd_panel_t *panel, uint32_t pclk_hz);
+
+/**
+ * Меняет частоту пиксельного тактирования шины: линия WR общая, поэтому интерфейс пересоздаётся у каждой панели
+ * на шине (recreate_panel_io), и все панели остаются на одной частоте.
+ * @param pclk_hz Новая частота pclk в Гц
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t set_pixel_clock(uint32_t pclk_hz);
+
+/**
+ * Применяет ориентацию панели (0°, 90°, 180°, 270°) без очистки экрана: отправляет MADCTL из таблицы
+ * lcd_orientations, задаёт смещения (x_gap, y_gap) и выбирает перевод окна и передачу пикселей.
+ * Разрешение LVGL и режимы приложения не трогает.
+ * @param panel Панель
+ * @param orientation Режим ориентации (DISPLAY_ORIENTATION_0, 90, 180, 270)
+ * @param sw_rotate true — программный поворот: панель в развёртке 0°, окно и пиксели поворачиваются на CPU
+ *                  (только для альбомной ориентации и при заданном буфере поворота lcd_panel_t.rotate)
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_ARG для неизвестной ориентации, иначе код ошибки
+ */
+esp_err_t lcd_panel_set_orientation(lcd_panel_t *panel, display_orientation_t orientation, bool sw_rotate);
+
+/**
+ * Ожидает завершения всех поставленных в очередь передач шины i80.
+ * esp_lcd_panel_io_tx_param без команды и параметров дожидается окончания DMA и ничего не отправляет.
+ * @param panel Панель
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t wait_lcd_transfers(lcd_panel_t *panel);
+
+/**
+ * Отправляет команду с параметрами и учитывает её в счётчиках шины.
+ * @param panel Панель
+ * @param cmd Код команды ST7789
+ * @param params Параметры команды (может быть NULL)
+ * @param len Длина параметров в байтах
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t lcd_tx_param(lcd_panel_t *panel, int cmd, const void *params, size_t len);
+
+/**
+ * Ставит в очередь DMA пиксельные данные с командой (обычно RAMWR) и учитывает их в счётчиках шины.
+ * Сначала ждёт доли панели в очереди шины и берёт кредит (lcd_bus_take_credit).
+ * @param panel Панель
+ * @param cmd Код команды (0x2C — RAMWR, -1 — продолжение записи без команды)
+ * @param data Пиксельные данные (DMA-совместимая память)
+ * @param len Длина данных в байтах
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t lcd_tx_color(lcd_panel_t *panel, int cmd, const void *data, size_t len);
+
+/**
+ * @param order Политика порядка байт
+ * @return Название политики для лога
+ */
+const char *lcd_byte_order_name(lcd_byte_order_t order);
+
+/**
+ * Отправляет RAMCTRL (0xB0) для текущей политики: младшим байтом вперёд панель принимает пиксели
+ * только при LCD_BYTE_ORDER_PANEL, иначе — значение после сброса (старшим байтом вперёд).
+ * @param panel Панель
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t lcd_send_ramctrl(lcd_panel_t *panel);
+
+/**
+ * Устанавливает область рисования на дисплее ST7789.
+ * Переводит логические координаты в адреса памяти панели функцией lcd_window_t.map, выбранной
+ * для текущей ориентации (смещения x_gap/y_gap; поворот и отражение выполняет MADCTL или, при программном
+ * повороте, сам перевод), и отправляет CASET/RASET, только если они отличаются от последних отправленных.
+ * Окно ограничивается экраном здесь, и только здесь: вызывающий размер передачи берёт из clamped.
+ * @param panel Панель
+ * @param x_start Начальная координата X (логическая)
+ * @param x_end Конечная координата X (логическая)
+ * @param y_start Начальная координата Y (логическая)
+ * @param y_end Конечная координата Y (логическая)
+ * @param clamped Окно после ограничения, в тех же логических координатах (может быть NULL)
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_SIZE, если область целиком вне экрана, иначе код ошибки
+ */
+esp_err_t set_draw_area(lcd_panel_t *panel, int x_start, int x_end, int y_start, int y_end, lcd_area_t *clamped);
+
+/**
+ * Выводит пиксельные данные в прямоугольную область дисплея.
+ * Устанавливает окно через set_draw_area и ставит в очередь DMA одну транзакцию RAMWR с данными.
+ * Передача асинхронная: буфер должен оставаться неизменным до окончания DMA.
+ * Часть области за краем экрана не передаётся. Если обрезаны столбцы, строки буфера идут отдельными
+ * передачами, и функция дожидается их окончания (LVGL отмечает готовность по первой передаче области).
+ * @param panel Панель
+ * @param x_start Начальная координата X (логическая)
+ * @param x_end Конечная координата X (логическая, включительно)
+ * @param y_start Начальная координата Y (логическая)
+ * @param y_end Конечная координата Y (логическая, включительно)
+ * @param data Пиксельные данные RGB565 (DMA-совместимая память)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t draw_area(lcd_panel_t *panel, int x_start, int x_end, int y_start, int y_end, const void *data);
+
+/**
+ * Заливает прямоугольную область сплошным цветом без выделения памяти.
+ * Одна транзакция RAMWR и продолжение записи кусками из постоянного буфера fill_buf:
+ * куски ставятся в очередь DMA подряд (до доли панели в очереди шины), буфер перезаполняется только при смене цвета.
+ * Передача асинхронная; для ожидания окончания используйте wait_lcd_transfers.
+ * @param panel Панель
+ * @param x_start Начальная координата X (логическая)
+ * @param x_end Конечная координата X (логическая, включительно)
+ * @param y_start Начальная координата Y (логическая)
+ * @param y_end Конечная координата Y (логическая, включительно)
+ * @param color Цвет в формате RGB565
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t fill_area(lcd_panel_t *panel, int x_start, int x_end, int y_start, int y_end, uint16_t color);
+
+/**
+ * Очищает экран, заполняя его указанным цветом в формате RGB565.
+ * Учитывает текущую ориентацию для корректной установки области.
+ * Данные передаются потоком из постоянного буфера fill_buf (см. fill_area), без выделения памяти на кадр.
+ * @param panel Панель
+ * @param color Цвет в формате RGB565 (0x0000 = чёрный, 0xFFFF = белый)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+esp_err_t clear_screen(lcd_panel_t *panel, uint16_t color);
+
+/**
+ * Выводит в лог долю общей шины каждой панели: передачи и байты с начала работы, скорость и долю байт шины
+ * за период с прошлого вызова, долю очереди шины, время, которое постановка передач ждала места в ней,
+ * и сколько раз панель уступала шину другой.
+ */
+void log_panel_stats(void);
@@ -0,0 +1,55 @@
+#include <string.h>
+#include "lcd_perf.h"
+
+void lcd_perf_hist_read(const lcd_perf_hist_t *hist, lcd_perf_hist_t *copy) {
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&hist->seq, __ATOMIC_ACQUIRE);
+        memcpy(copy, (const void *)hist, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        // Нечётный счётчик — копия застала запись; изменившийся — запись прошла во время копирования
+    } while ((seq & 1) || __atomic_load_n(&hist->seq, __ATOMIC_RELAXED) != seq);
+    copy->seq = seq;
+}
+
+uint32_t lcd_perf_hist_percentile(const lcd_perf_hist_t *hist, unsigned percent) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint64_t target = ((uint64_t)hist->count * percent + 99) / 100;
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < LCD_PERF_BUCKETS - 1; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target) {
+            uint32_t upper = i == 0 ? 0 : (1u << i) - 1;
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+size_t lcd_perf_ring_read(const lcd_perf_ring_t *ring, lcd_perf_frame_t *out) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t count = head < LCD_PERF_RING_LEN ? head : LCD_PERF_RING_LEN;
+    uint32_t first = head - count;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = ring->frames[(first + i) % LCD_PERF_RING_LEN];
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // Писатель за время копирования занял ячейки head..now (последнюю — возможно, не дописав):
+    // копия кадра first + i испорчена, если first + i + LCD_PERF_RING_LEN <= now
+    uint32_t now = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    int32_t skip = (int32_t)(now - first) - LCD_PERF_RING_LEN + 1;
+    if (skip <= 0) {
+        return count;
+    }
+    if ((uint32_t)skip >= count) {
+        return 0;
+    }
+    memmove(out, out + skip, (count - skip) * sizeof(*out));
+    return count - skip;
+}
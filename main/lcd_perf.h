@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
+#else
+#include "esp_cpu.h"
+#endif
+
+/**
+ * Замеры вывода без блокировок: гистограммы длительностей и размеров и кольцо последних кадров.
+ * Запись — несколько десятков тактов без мьютексов и без запрета прерываний, поэтому замеры
+ * остаются включёнными и в релизной сборке.
+ *
+ * У каждой гистограммы и у кольца один писатель в каждый момент (задача рендеринга, задача под
+ * блокировкой LVGL или ISR завершения DMA). Писатель делает счётчик последовательности нечётным
+ * на время записи; читатель копирует данные и повторяет копию, если счётчик изменился.
+ */
+
+#define LCD_PERF_BUCKETS    32                // Корзина 0 — ноль, корзина i — значения от 2^(i-1) до 2^i - 1
+#define LCD_PERF_RING_LEN   16                // Кадров в кольце (степень двойки)
+#ifdef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define LCD_PERF_CPU_MHZ    CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ // Тактов в микросекунде (без динамической смены частоты)
+#else
+#define LCD_PERF_CPU_MHZ    240               // Хост: такты условного ядра 240 МГц
+#endif
+
+// Гистограмма по степеням двойки
+typedef struct {
+    volatile uint32_t seq;      // Нечётный, пока писатель обновляет гистограмму
+    uint32_t count;             // Количество значений
+    uint32_t max;               // Наибольшее значение
+    uint64_t sum;               // Сумма значений
+    uint32_t buckets[LCD_PERF_BUCKETS];
+} lcd_perf_hist_t;
+
+// Запись о выведенном кадре
+typedef struct {
+    uint32_t frame;             // Номер кадра с начала работы (с 1)
+    uint32_t render_cycles;     // Рисование LVGL до постановки последней области, без flush и ожидания буфера (такты)
+    uint32_t frame_us;          // От начала рендеринга до окончания DMA последней области
+    uint32_t interval_us;       // От окончания предыдущего кадра
+    uint32_t bytes;             // Байт пикселей за кадр
+    uint16_t flushes;           // Областей за кадр
+    uint16_t dropped;           // Периодов обновления, пропущенных из-за длительности кадра
+} lcd_perf_frame_t;
+
+// Кольцо последних кадров
+typedef struct {
+    volatile uint32_t head;     // Записано кадров всего; следующая запись — frames[head % LCD_PERF_RING_LEN]
+    lcd_perf_frame_t frames[LCD_PERF_RING_LEN];
+} lcd_perf_ring_t;
+
+/**
+ * Текущее значение счётчика тактов CPU. Счётчики ядер ESP32-S3 не согласованы между собой,
+ * поэтому разность имеет смысл только для двух отсчётов на одном ядре.
+ * На хосте счётчика нет: такты пересчитываются из esp_timer по LCD_PERF_CPU_MHZ.
+ */
+static inline uint32_t lcd_perf_cycles(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    return (uint32_t)(esp_timer_get_time() * LCD_PERF_CPU_MHZ);
+#else
+    return esp_cpu_get_cycle_count();
+#endif
+}
+
+/**
+ * Добавляет значение в гистограмму (безопасно в ISR).
+ * @param hist Гистограмма
+ * @param value Значение
+ */
+static inline void lcd_perf_hist_add(lcd_perf_hist_t *hist, uint32_t value) {
+    uint32_t seq = hist->seq;
+    __atomic_store_n(&hist->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    uint32_t bucket = value ? 32 - __builtin_clz(value) : 0;
+    hist->buckets[bucket < LCD_PERF_BUCKETS ? bucket : LCD_PERF_BUCKETS - 1]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    __atomic_store_n(&hist->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * Добавляет кадр в кольцо, вытесняя самый старый (безопасно в ISR).
+ * @param ring Кольцо
+ * @param frame Кадр
+ */
+static inline void lcd_perf_ring_push(lcd_perf_ring_t *ring, const lcd_perf_frame_t *frame) {
+    uint32_t head = ring->head;
+    ring->frames[head % LCD_PERF_RING_LEN] = *frame;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Копирует гистограмму целиком, без половины обновления от писателя.
+ * @param hist Гистограмма
+ * @param copy Копия
+ */
+void lcd_perf_hist_read(const lcd_perf_hist_t *hist, lcd_perf_hist_t *copy);
+
+/**
+ * Оценка перцентиля по гистограмме: верхняя граница корзины, в которую он попадает (не больше max).
+ * @param hist Гистограмма (копия из lcd_perf_hist_read)
+ * @param percent Перцентиль, 0..100
+ * @return Значение перцентиля; 0 для пустой гистограммы
+ */
+uint32_t lcd_perf_hist_percentile(const lcd_perf_hist_t *hist, unsigned percent);
+
+/**
+ * Копирует последние кадры кольца, от старых к новым: до LCD_PERF_RING_LEN - 1, так как самую старую ячейку
+ * писатель может переписывать прямо сейчас. Кадры, перезаписанные во время копирования, отбрасываются.
+ * @param ring Кольцо
+ * @param out Куда копировать (не меньше LCD_PERF_RING_LEN записей)
+ * @return Количество скопированных кадров
+ */
+size_t lcd_perf_ring_read(const lcd_perf_ring_t *ring, lcd_perf_frame_t *out);
@@ -0,0 +1,50 @@
+#include <string.h>
+#include "esp_rom_crc.h"
+#include "lcd_trace.h"
+
+size_t lcd_trace_pack(lcd_trace_ring_t *ring, uint32_t seq, uint8_t *out, size_t max_events) {
+    lcd_trace_event_t *events = (lcd_trace_event_t *)(out + sizeof(lcd_trace_header_t));
+    uint32_t tail = ring->tail;
+    size_t count = 0;
+    while (count < max_events &&
+           __atomic_load_n(&ring->slots[tail % LCD_TRACE_RING_LEN].seq, __ATOMIC_ACQUIRE) == tail + 1) {
+        memcpy(&events[count++], (const void *)&ring->slots[tail % LCD_TRACE_RING_LEN].event, sizeof(lcd_trace_event_t));
+        tail++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    // Ячейки освобождаются только после копирования: писатель не займёт их раньше
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+    lcd_trace_header_t header = {
+        .magic = LCD_TRACE_MAGIC,
+        .version = LCD_TRACE_VERSION,
+        .count = count,
+        .seq = seq,
+        .dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED),
+    };
+    memcpy(out, &header, sizeof(header));
+    size_t size = lcd_trace_packet_size(count);
+    uint32_t crc = esp_rom_crc32_le(0, out, size - sizeof(crc));
+    memcpy(out + size - sizeof(crc), &crc, sizeof(crc));
+    return size;
+}
+
+const lcd_trace_event_t *lcd_trace_unpack(const uint8_t *packet, size_t size, lcd_trace_header_t *header) {
+    if (size < lcd_trace_packet_size(0)) {
+        return NULL;
+    }
+    memcpy(header, packet, sizeof(*header));
+    if (header->magic != LCD_TRACE_MAGIC || header->version != LCD_TRACE_VERSION ||
+        lcd_trace_packet_size(header->count) > size) {
+        return NULL;
+    }
+    size_t body = lcd_trace_packet_size(header->count) - sizeof(uint32_t);
+    uint32_t crc;
+    memcpy(&crc, packet + body, sizeof(crc));
+    if (esp_rom_crc32_le(0, packet, body) != crc) {
+        return NULL;
+    }
+    return (const lcd_trace_event_t *)(packet + sizeof(*header));
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_cpu.h"
+#endif
+
+/**
+ * Двоичная трасса событий вывода: события по 16 байт копятся в кольце и уходят пакетами
+ * (заголовок, события, CRC32). Пакеты можно смешивать с текстом лога в одном потоке:
+ * tools/trace2perfetto.py ищет сигнатуру и отбрасывает всё, что не сошлось по CRC.
+ *
+ * Кольцо — много писателей (задачи и ISR на обоих ядрах) и один читатель (задача выгрузки).
+ * Писатель резервирует ячейку сравнением с обменом и публикует её номером последовательности;
+ * при заполненном кольце событие отбрасывается и учитывается в счётчике, а не затирает старые.
+ */
+
+#define LCD_TRACE_MAGIC     0x4352544C        // "LTRC"
+#define LCD_TRACE_VERSION   1                 // Версия формата пакета
+#define LCD_TRACE_RING_LEN  512               // Событий в кольце (степень двойки)
+
+// Типы событий; поля arg, a, b по типам
+typedef enum {
+    LCD_TRACE_TIMER_BEGIN = 1, // Начало lv_timer_handler
+    LCD_TRACE_TIMER_END,       // Конец lv_timer_handler; a — сон до следующего вызова (мс)
+    LCD_TRACE_REFR_BEGIN,      // Начало обновления дисплея (lvgl_refr_timer_cb)
+    LCD_TRACE_REFR_END,        // Конец обновления дисплея; a — областей после объединения
+    LCD_TRACE_FLUSH_BEGIN,     // Вход в lvgl_flush_cb; a — x1 | y1 << 16, b — x2 | y2 << 16, arg — 1 для последней области кадра
+    LCD_TRACE_FLUSH_END,       // Область поставлена в очередь DMA; a — байт пикселей, arg — 1 при ошибке
+    LCD_TRACE_DMA_DONE,        // Прерывание окончания DMA области LVGL; arg — 1 для последней области кадра
+    LCD_TRACE_TE,              // Импульс TE
+    LCD_TRACE_HEAP,            // Куча: a — свободно, b — минимум с начала работы (байт)
+} lcd_trace_type_t;
+
+// Событие (16 байт, little-endian)
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;           // Младшие 32 бита esp_timer_get_time()
+    uint8_t type;               // lcd_trace_type_t
+    uint8_t core;               // Ядро, на котором записано событие
+    uint16_t arg;
+    uint32_t a;
+    uint32_t b;
+} lcd_trace_event_t;
+
+// Заголовок пакета (16 байт, little-endian); за ним count событий и CRC32 заголовка с событиями
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // LCD_TRACE_MAGIC
+    uint8_t version;            // LCD_TRACE_VERSION
+    uint8_t reserved;           // 0
+    uint16_t count;             // Событий в пакете
+    uint32_t seq;               // Номер пакета: пропуск означает потерю пакета на стороне приёма
+    uint32_t dropped;           // Событий, отброшенных при заполненном кольце, с начала работы
+} lcd_trace_header_t;
+
+// Кольцо событий
+typedef struct {
+    volatile uint32_t head;     // Зарезервировано ячеек
+    volatile uint32_t tail;     // Прочитано ячеек
+    volatile uint32_t dropped;  // Отброшено событий
+    struct {
+        volatile uint32_t seq;  // Номер ячейки + 1, когда событие записано
+        lcd_trace_event_t event;
+    } slots[LCD_TRACE_RING_LEN];
+} lcd_trace_ring_t;
+
+/**
+ * Записывает событие в кольцо (безопасно в ISR и на любом ядре; всегда встраивается, в том числе в IRAM-обработчики).
+ * @param ring Кольцо
+ * @param type Тип события
+ * @param arg, a, b Поля события (см. lcd_trace_type_t)
+ * @return false, если кольцо заполнено и событие отброшено
+ */
+static inline __attribute__((always_inline)) bool lcd_trace_push(lcd_trace_ring_t *ring, lcd_trace_type_t type, uint16_t arg,
+                                                                 uint32_t a, uint32_t b) {
+    uint32_t time_us = (uint32_t)esp_timer_get_time();
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    do {
+        if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LCD_TRACE_RING_LEN) {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    // Ячейка head свободна: читатель уже прошёл head - LCD_TRACE_RING_LEN
+    lcd_trace_event_t *event = (lcd_trace_event_t *)&ring->slots[head % LCD_TRACE_RING_LEN].event;
+    event->time_us = time_us;
+    event->type = type;
+#if CONFIG_IDF_TARGET_LINUX
+    event->core = 0;
+#else
+    event->core = esp_cpu_get_core_id();
+#endif
+    event->arg = arg;
+    event->a = a;
+    event->b = b;
+    __atomic_store_n(&ring->slots[head % LCD_TRACE_RING_LEN].seq, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Собирает пакет из событий кольца (только задача выгрузки).
+ * События, ячейки которых ещё дописываются, остаются в кольце до следующего пакета.
+ * @param ring Кольцо
+ * @param seq Номер пакета
+ * @param out Буфер пакета
+ * @param max_events Наибольшее число событий в пакете (out — не меньше lcd_trace_packet_size(max_events) байт)
+ * @return Размер пакета в байтах; 0, если событий нет
+ */
+size_t lcd_trace_pack(lcd_trace_ring_t *ring, uint32_t seq, uint8_t *out, size_t max_events);
+
+/**
+ * Размер пакета.
+ * @param events Событий в пакете
+ * @return Байт: заголовок, события и CRC32
+ */
+static inline size_t lcd_trace_packet_size(size_t events) {
+    return sizeof(lcd_trace_header_t) + events * sizeof(lcd_trace_event_t) + sizeof(uint32_t);
+}
+
+/**
+ * Проверяет пакет и возвращает его события (обратная операция к lcd_trace_pack, для проверок на хосте).
+ * @param packet Пакет
+ * @param size Байт в буфере (не меньше пакета)
+ * @param header Копия заголовка
+ * @return Указатель на события или NULL при неверной сигнатуре, версии, длине или CRC
+ */
+const lcd_trace_event_t *lcd_trace_unpack(const uint8_t *packet, size_t size, lcd_trace_header_t *header);
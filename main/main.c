@@ -1,15 +1,35 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "esp_lcd_panel_io.h"
-#include "esp_lcd_panel_vendor.h"
-#include "esp_lcd_panel_ops.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_attr.h"
 #include "driver/gpio.h"
 #include "lvgl.h"
+#include "demos/lv_demos.h"
+#include "rgb565.h"
+#include "splash.h"
+#include "lcd_perf.h"
+#include "lcd_trace.h"
+#include "lcd_panel.h"
+#include "display.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "esp_lcd_mock.h"                     // Эмулятор ST7789 вместо панели (хост-сборка)
+#include "host_checks.h"
+#else
+#include "esp_partition.h"
+#include "esp_app_desc.h"
+#include "driver/usb_serial_jtag.h"
+#include "driver/usb_serial_jtag_vfs.h"
+#endif
 
 // Макросы для удобной работы с минимальным и максимальным значениями
 #ifndef MIN
@@ -19,178 +39,149 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif
 
-// Конфигурация пинов и параметров дисплея T-Display-S3
-#define LCD_PIXEL_CLOCK_HZ  (2 * 1000 * 1000) // Частота пиксельного тактирования: 2 МГц
-                                              // Влияние: слишком высокая частота (>20 МГц) может вызвать артефакты,
-                                              // слишком низкая (<1 МГц) замедлит рендеринг.
-#define LCD_BK_LIGHT_ON_LEVEL 1               // Уровень для включения подсветки (1 = включено)
-#define LCD_PIN_BK_LIGHT    38                // Пин подсветки
-#define LCD_PIN_CS          6                 // Пин Chip Select (CS) для выбора дисплея
-#define LCD_PIN_DC          7                 // Пин Data/Command для переключения между данными и командами
-#define LCD_PIN_RST         5                 // Пин сброса дисплея
-#define LCD_PIN_WR          8                 // Пин записи (WR) для синхронизации данных
-#define LCD_PIN_RD          9                 // Пин чтения (не используется, но должен быть настроен)
-#define LCD_PIN_DATA0       39                // Пины данных для 8-битной шины i80
-#define LCD_PIN_DATA1       40
-#define LCD_PIN_DATA2       41
-#define LCD_PIN_DATA3       42
-#define LCD_PIN_DATA4       45
-#define LCD_PIN_DATA5       46
-#define LCD_PIN_DATA6       47
-#define LCD_PIN_DATA7       48
-#define LCD_H_RES           170               // Физическое горизонтальное разрешение дисплея (170 пикселей)
-#define LCD_V_RES           320               // Физическое вертикальное разрешение дисплея (320 пикселей)
-#define LCD_CMD_BITS        8                 // Количество бит для команд
-#define LCD_PARAM_BITS      8                 // Количество бит для параметров
-#define LCD_X_OFFSET        0                 // Смещение области отображения по X (логическое)
-#define LCD_Y_OFFSET        0                 // Смещение области отображения по Y (логическое)
-
-// Конфигурация буфера LVGL для рендеринга
-#define LVGL_BUFFER_LINES   40                // Количество строк в буфере LVGL
-                                              // Влияние: меньшее значение (например, 10) снижает потребление памяти,
-                                              // но увеличивает количество операций рендеринга, что может замедлить вывод.
-                                              // Большое значение (например, 170) увеличивает память, но ускоряет рендеринг.
-#define LVGL_BUFFER_SIZE    (LCD_H_RES * LVGL_BUFFER_LINES * sizeof(lv_color_t)) // Размер буфера в байтах
-
-// Перечисление для режимов ориентации дисплея
-typedef enum {
-    DISPLAY_ORIENTATION_0,   // 0°: физический x=логический x, y=логический y
-    DISPLAY_ORIENTATION_90,  // 90°: физический x=логический y, y=логический x
-    DISPLAY_ORIENTATION_180, // 180°: физический x=инверсия логического x, y=инверсия логического y
-    DISPLAY_ORIENTATION_270  // 270°: физический x=инверсия логического y, y=инверсия логического x
-} display_orientation_t;
-
 // Глобальные переменные
 static const char *TAG = "example";           // Тег для логирования
-static esp_lcd_panel_handle_t panel_handle = NULL; // Дескриптор панели дисплея
-static esp_lcd_panel_io_handle_t io_handle = NULL; // Дескриптор интерфейса i80
-static lv_disp_t *lvgl_disp = NULL;           // Дескриптор дисплея LVGL
-static display_orientation_t current_orientation = DISPLAY_ORIENTATION_90; // Текущая ориентация (по умолчанию 90°)
+static lcd_rotation_mode_t lcd_rotation_mode = LCD_ROTATION_MADCTL; // Текущий способ поворота: до init_lvgl (заставка) — MADCTL
+lcd_power_mode_t lcd_power = {.frctrl2 = LCD_FRCTRL2_DEFAULT}; // Текущий режим отображения
+uint64_t lcd_power_clipped_bytes = 0;         // Байт пикселей LVGL, не отрисованных вне полосы частичного показа
+lv_disp_t *lvgl_disp = NULL;                  // Дескриптор дисплея LVGL основной панели (lcd_panel_main.disp)
 
-// Структура для инициализационных команд ST7789
-typedef struct {
-    uint8_t addr;          // Адрес команды (например, 0x11 для Sleep Out)
-    uint8_t param[16];     // Параметры команды (до 16 байт)
-    uint8_t len;           // Длина параметров и флаг задержки (бит 7: 1 = задержка 120 мс)
-} lcd_cmd_t;
-
-// Список команд инициализации ST7789
-// Команда 0x36 (MADCTL) исключена, так как она задаётся в set_display_orientation
-static lcd_cmd_t lcd_st7789v[] = {
-    {0x11, {0}, 0 | 0x80},                             // Sleep Out: выход из спящего режима, задержка 120 мс
-    {0x21, {0}, 0},                                    // INVON: включение инверсии цветов
-                                                        // Влияние: без INVON цвета могут быть инвертированы (например, белый станет чёрным).
-    {0x35, {0x00}, 1},                                 // TEON: включение tearing effect для синхронизации
-    {0x3A, {0x55}, 1},                                 // Pixel Format: RGB565 (16 бит на пиксель)
-                                                        // Влияние: установка 0x66 (RGB666) увеличит размер данных, что не поддерживается шиной i80 в данном коде.
-    {0xB2, {0x0C, 0x0C, 0x00, 0x33, 0x33}, 5},        // Porch Setting: настройка временных интервалов
-    {0xB7, {0x35}, 1},                                 // Gate Control: управление затвором
-    {0xBB, {0x19}, 1},                                 // VCOM Setting: настройка напряжения
-    {0xC0, {0x2C}, 1},                                 // LCM Control: управление модулем
-    {0xC2, {0x01}, 1},                                 // VDV/VRH Enable: включение VDV/VRH
-    {0xC3, {0x12}, 1},                                 // VRH Set: установка VRH
-    {0xC4, {0x20}, 1},                                 // VDV Set: установка VDV
-    {0xC6, {0x0F}, 1},                                 // Frame Rate Control: частота обновления 60 Гц
-                                                        // Влияние: установка 0x05 (120 Гц) может вызвать мерцание на некоторых дисплеях.
-    {0xD0, {0xA4, 0xA1}, 2},                           // Power Control: управление питанием
-    {0xE0, {0xD0, 0x08, 0x11, 0x08, 0x09, 0x15, 0x31, 0x33, 0x48, 0x17, 0x14, 0x15, 0x31, 0x34}, 14}, // Positive Gamma
-    {0xE1, {0xD0, 0x08, 0x11, 0x08, 0x09, 0x15, 0x31, 0x33, 0x48, 0x17, 0x14, 0x15, 0x31, 0x34}, 14}, // Negative Gamma
-    {0x2A, {0x00, 0x00, 0x01, 0x3F}, 4},              // CASET: задание столбцов 0-319 (320 пикселей по физическому Y)
-    {0x2B, {0x00, 0x00, 0x00, 0xA9}, 4},              // RASET: задание строк 0-169 (170 пикселей по физическому X)
-                                                        // Влияние: неправильные значения (например, 0x00, 0xA9 для CASET) обрежут изображение.
-    {0x29, {0}, 0 | 0x80},                             // Display On: включение дисплея, задержка 120 мс
-    {0, {0}, 0xff},                                    // Конец списка команд
+lvgl_flush_stats_t flush_stats = {0};
+
+#if LCD_PERF
+static lcd_perf_t lcd_perf = {0};
+#endif
+
+// Окончание передачи панели (lcd_panel_t.on_trans_done): готовность буфера LVGL и статистика кадров
+static bool lvgl_flush_done_cb(lcd_panel_t *panel);
+
+lcd_panel_t lcd_panel_main = {
+    .cs_gpio = LCD_PIN_CS,
+    .pclk_hz = LCD_PIXEL_CLOCK_HZ,
+    .orientation = DISPLAY_ORIENTATION_90, // По умолчанию 90°
+    .orient = &lcd_orientations[DISPLAY_ORIENTATION_90],
+    .on_trans_done = lvgl_flush_done_cb,
+#if LCD_PERF
+    .perf_set_area = &lcd_perf.hist[LCD_PERF_SET_AREA],
+    .perf_tx_color = &lcd_perf.hist[LCD_PERF_TX_COLOR],
+#endif
+};
+#if LCD_PANEL2_ENABLE
+static lcd_panel_t lcd_panel2 = {
+    .cs_gpio = LCD_PANEL2_PIN_CS,
+    .pclk_hz = LCD_PIXEL_CLOCK_HZ,
+    .orientation = LCD_PANEL2_ORIENTATION,
+    .orient = &lcd_orientations[LCD_PANEL2_ORIENTATION],
 };
+#endif
+
+#if LCD_TRACE
+static lcd_trace_ring_t lcd_trace_ring = {0}; // События трассы до выгрузки задачей lcd_trace_task
+#if CONFIG_IDF_TARGET_LINUX
+static FILE *lcd_trace_file = NULL;           // Файл трассы (хост)
+#endif
+#define LCD_TRACE_EVENT(type, arg, a, b) lcd_trace_push(&lcd_trace_ring, (type), (arg), (a), (b))
+#else
+#define LCD_TRACE_EVENT(type, arg, a, b) ((void)0)
+#endif
+
+static lcd_te_t lcd_te = {.nominal_period_us = LCD_TE_PERIOD_US};
+
+static lvgl_render_t lvgl_render = {0};
+
+lvgl_coalesce_t lvgl_coalesce = {.enabled = LVGL_COALESCE};
+console_t console = {0};
+
+static lvgl_buf_layout_t lvgl_buf_layout = {0};
 
-// Прототип функции clear_screen для устранения ошибок компиляции
-static esp_err_t clear_screen(uint16_t color);
+// Этапы старта панели (время по esp_timer) для отложенного включения и отчёта о времени до первого пикселя
+static struct {
+    int64_t app_start_us;       // Вход в app_main
+    int64_t sleep_out_us;       // Отправка Sleep Out
+    int64_t display_on_us;      // Включение подсветки (первый видимый кадр)
+    bool display_on;            // Display On отправлена, подсветка включена
+} lcd_boot;
+
+// Прототипы функций lvgl_refr_now и lcd_panel_start для устранения ошибок компиляции
+
+void lcd_power_active_area(const lcd_power_mode_t *mode, lv_area_t *area) {
+    area->x1 = 0;
+    area->y1 = 0;
+    area->x2 = lcd_panel_main.orient->hor_res - 1;
+    area->y2 = lcd_panel_main.orient->ver_res - 1;
+    if (!mode->partial) {
+        return;
+    }
+    if (!lcd_panel_main.orient->landscape) {
+        area->y1 = mode->partial_start;
+        area->y2 = mode->partial_end;
+    } else {
+        area->x1 = mode->partial_start;
+        area->x2 = mode->partial_end;
+    }
+}
 
 /**
- * Устанавливает ориентацию дисплея (0°, 90°, 180°, 270°).
- * Обновляет параметр MADCTL, разрешение LVGL, смещения (x_gap, y_gap) и очищает экран.
- * @param orientation Режим ориентации (DISPLAY_ORIENTATION_0, 90, 180, 270)
+ * Отправляет PTLAR (0x30) для полосы частичного показа в текущей ориентации.
+ * PTLAR задаётся в строках памяти (ось 320 пикселей): при MY (180° и 270°) полоса отражается.
+ * @param panel Панель
  * @return ESP_OK при успехе, иначе код ошибки
  */
-static esp_err_t set_display_orientation(display_orientation_t orientation) {
-    ESP_LOGI(TAG, "Setting display orientation: %d", orientation);
-
-    // Определение параметров MADCTL, разрешения и смещений
-    uint8_t madctl; // Регистр MADCTL управляет ориентацией и порядком сканирования
-                    // MY: инверсия строк, MX: инверсия столбцов, MV: обмен осей, BGR: порядок цветов
-    int hor_res, ver_res; // Логическое разрешение (зависит от ориентации)
-    int x_gap, y_gap;     // Смещения области отображения для компенсации физического расположения пикселей
-    switch (orientation) {
-        case DISPLAY_ORIENTATION_0:
-            madctl = 0x08; // MY=0, MX=0, MV=0, BGR=1
-                           // Логический X = физический X, Y = физический Y
-            hor_res = LCD_H_RES; // 170 пикселей
-            ver_res = LCD_V_RES; // 320 пикселей
-            x_gap = 35;          // Смещение по X для выравнивания
-            y_gap = 0;           // Без смещения по Y
-            break;
-        case DISPLAY_ORIENTATION_90:
-            madctl = 0x68; // MY=0, MX=1, MV=1, BGR=1
-                           // Логический X = физический Y, Y = физический X
-            hor_res = LCD_V_RES; // 320 пикселей
-            ver_res = LCD_H_RES; // 170 пикселей
-            x_gap = 0;           // Без смещения по X
-            y_gap = 35;          // Смещение по Y для выравнивания
-            break;
-        case DISPLAY_ORIENTATION_180:
-            madctl = 0xC8; // MY=1, MX=1, MV=0, BGR=1
-                           // Логический X = инверсия физического X, Y = инверсия физического Y
-            hor_res = LCD_H_RES; // 170 пикселей
-            ver_res = LCD_V_RES; // 320 пикселей
-            x_gap = 35;          // Смещение по X
-            y_gap = 0;           // Без смещения по Y
-            break;
-        case DISPLAY_ORIENTATION_270:
-            madctl = 0xA8; // MY=1, MX=0, MV=1, BGR=1
-                           // Логический X = инверсия физического Y, Y = инверсия физического X
-            hor_res = LCD_V_RES; // 320 пикселей
-            ver_res = LCD_H_RES; // 170 пикселей
-            x_gap = 0;           // Без смещения по X
-            y_gap = 35;          // Смещение по Y
-            break;
-        default:
-            ESP_LOGE(TAG, "Invalid orientation: %d", orientation);
-            return ESP_ERR_INVALID_ARG;
+static esp_err_t lcd_send_ptlar(lcd_panel_t *panel) {
+    int start = lcd_power.partial_start;
+    int end = lcd_power.partial_end;
+    if (panel->orient->mirror_rows) {
+        start = LCD_V_RES - 1 - lcd_power.partial_end;
+        end = LCD_V_RES - 1 - lcd_power.partial_start;
     }
+    uint8_t ptlar[4] = {start >> 8, start & 0xFF, end >> 8, end & 0xFF};
+    return lcd_tx_param(panel, 0x30, ptlar, sizeof(ptlar));
+}
 
-    // Пример влияния: если установить madctl=0x00 (BGR=0), цвета будут в формате RGB, что может
-    // привести к неправильному отображению (например, красный станет синим).
-    // Неправильные x_gap/y_gap (например, x_gap=0 для 0°) сместят изображение влево или обрежут его.
-
-    // Отправка команды MADCTL для установки ориентации
-    esp_err_t ret = esp_lcd_panel_io_tx_param(io_handle, 0x36, &madctl, 1);
+esp_err_t apply_display_orientation(lcd_panel_t *panel, display_orientation_t orientation) {
+    // Буфер поворота, частичный показ и TE есть только у основной панели
+    bool main_panel = panel == &lcd_panel_main;
+    esp_err_t ret = lcd_panel_set_orientation(panel, orientation,
+                                              main_panel && lcd_rotation_mode == LCD_ROTATION_SOFTWARE);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set MADCTL: %s", esp_err_to_name(ret));
         return ret;
     }
+    const lcd_orientation_desc_t *desc = panel->orient;
 
-    // Установка смещений x_gap и y_gap
-    ret = esp_lcd_panel_set_gap(panel_handle, x_gap, y_gap);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set gap (x_gap=%d, y_gap=%d): %s", x_gap, y_gap, esp_err_to_name(ret));
-        return ret;
+    // Полоса частичного показа задана вдоль оси развёртки, её строки памяти зависят от MY
+    if (main_panel && lcd_power.partial) {
+        ret = lcd_send_ptlar(panel);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to update partial area: %s", esp_err_to_name(ret));
+            return ret;
+        }
     }
-    ESP_LOGI(TAG, "Set display gap: x_gap=%d, y_gap=%d", x_gap, y_gap);
 
-    // Обновление текущей ориентации
-    current_orientation = orientation;
+    // Обновление разрешения в драйвере LVGL. Поворот выполняет MADCTL, поэтому для LVGL это только смена
+    // разрешения: rotated остаётся LV_DISP_ROT_NONE, иначе LVGL переставит hor_res/ver_res ещё раз и повернёт
+    // координаты устройств ввода. lv_disp_drv_update растягивает экраны и слои на новое разрешение и помечает
+    // разметку всех объектов, так что выравненные объекты встают по местам без пересоздания.
+    if (panel->disp) {
+        lv_disp_drv_t *disp_drv = panel->disp->driver;
+        disp_drv->hor_res = desc->hor_res;
+        disp_drv->ver_res = desc->ver_res;
+        disp_drv->rotated = LV_DISP_ROT_NONE;
+        lv_disp_drv_update(panel->disp, disp_drv);
+        // Пример влияния: прежний вызов lv_disp_set_rotation(disp, 90) записывал градусы в двухбитное поле
+        // lv_disp_rot_t, и при 90° и 270° LVGL считал экран повёрнутым на 180°.
+        ESP_LOGI(TAG, "Updated LVGL resolution: %dx%d", desc->hor_res, desc->ver_res);
+    }
+    return ESP_OK;
+}
 
-    // Обновление разрешения в драйвере LVGL
-    if (lvgl_disp) {
-        lv_disp_drv_t *disp_drv = lvgl_disp->driver;
-        disp_drv->hor_res = hor_res;
-        disp_drv->ver_res = ver_res;
-        lv_disp_set_rotation(lvgl_disp, orientation * 90); // Уведомление LVGL о повороте
-                                                           // Влияние: без этого текст LVGL может быть повёрнут неправильно.
-        ESP_LOGI(TAG, "Updated LVGL resolution: %dx%d", hor_res, ver_res);
+esp_err_t set_display_orientation(lcd_panel_t *panel, display_orientation_t orientation) {
+    esp_err_t ret = apply_display_orientation(panel, orientation);
+    if (ret != ESP_OK) {
+        return ret;
     }
 
     // Очистка экрана для устранения артефактов от предыдущей ориентации
-    ret = clear_screen(0x0000); // Чёрный фон
+    ret = clear_screen(panel, 0x0000); // Чёрный фон
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to clear screen after orientation change: %s", esp_err_to_name(ret));
         return ret;
@@ -200,143 +191,182 @@ static esp_err_t set_display_orientation(display_orientation_t orientation) {
 }
 
 /**
- * Устанавливает область рисования на дисплее ST7789.
- * Преобразует логические координаты в физические с учётом текущей ориентации.
- * @param x_start Начальная координата X (логическая)
- * @param x_end Конечная координата X (логическая)
- * @param y_start Начальная координата Y (логическая)
- * @param y_end Конечная координата Y (логическая)
- * @return ESP_OK при успехе, иначе код ошибки
+ * Поворачивает экран LVGL без очистки панели и без пересоздания объектов: MADCTL и смещения меняются,
+ * как в apply_display_orientation, и весь экран перерисовывается одним кадром в новой ориентации.
+ * Чёрного промежуточного кадра нет: MADCTL меняет только порядок записи в память панели, поэтому до прихода
+ * новых пикселей на стекле остаётся прежнее изображение.
+ * Вызывается под lvgl_lock или до запуска задачи рендеринга; кадр ставится в очередь DMA, но не ожидается.
+ * @param orientation Режим ориентации (DISPLAY_ORIENTATION_0, 90, 180, 270)
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_STATE до init_lvgl, иначе код ошибки
  */
-static esp_err_t set_draw_area(int x_start, int x_end, int y_start, int y_end) {
-    ESP_LOGD(TAG, "Setting draw area: x=%d-%d, y=%d-%d (before offset, orientation=%d)", 
-             x_start, x_end, y_start, y_end, current_orientation);
-
-    // Применение логических смещений (LCD_X_OFFSET, LCD_Y_OFFSET)
-    x_start += LCD_X_OFFSET;
-    x_end += LCD_X_OFFSET;
-    y_start += LCD_Y_OFFSET;
-    y_end += LCD_Y_OFFSET;
-
-    // Ограничение координат в зависимости от текущей ориентации
-    int max_x = (current_orientation == DISPLAY_ORIENTATION_0 || current_orientation == DISPLAY_ORIENTATION_180) ? LCD_H_RES - 1 : LCD_V_RES - 1;
-    int max_y = (current_orientation == DISPLAY_ORIENTATION_0 || current_orientation == DISPLAY_ORIENTATION_180) ? LCD_V_RES - 1 : LCD_H_RES - 1;
-    x_start = MAX(x_start, 0);
-    x_end = MIN(x_end, max_x);
-    y_start = MAX(y_start, 0);
-    y_end = MIN(y_end, max_y);
-
-    // Преобразование логических координат в физические
-    uint16_t col_start, col_end, row_start, row_end;
-    switch (current_orientation) {
-        case DISPLAY_ORIENTATION_0:
-            col_start = x_start; col_end = x_end; // Физический X
-            row_start = y_start; row_end = y_end; // Физический Y
-            break;
-        case DISPLAY_ORIENTATION_90:
-            col_start = y_start; col_end = y_end; // Физический Y
-            row_start = x_start; row_end = x_end; // Физический X
-            break;
-        case DISPLAY_ORIENTATION_180:
-            col_start = LCD_H_RES - 1 - x_end; col_end = LCD_H_RES - 1 - x_start; // Инверсия X
-            row_start = LCD_V_RES - 1 - y_end; row_end = LCD_V_RES - 1 - y_start; // Инверсия Y
-            break;
-        case DISPLAY_ORIENTATION_270:
-            col_start = LCD_H_RES - 1 - y_end; col_end = LCD_H_RES - 1 - y_start; // Инверсия Y
-            row_start = LCD_V_RES - 1 - x_end; row_end = LCD_V_RES - 1 - x_start; // Инверсия X
-            break;
-        default:
-            ESP_LOGE(TAG, "Invalid orientation state: %d", current_orientation);
-            return ESP_ERR_INVALID_STATE;
+static esp_err_t rotate_display(display_orientation_t orientation) {
+    if (!lvgl_disp) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = apply_display_orientation(&lcd_panel_main, orientation);
+    if (ret != ESP_OK) {
+        return ret;
     }
 
-    ESP_LOGD(TAG, "Physical draw area: cols=%d-%d, rows=%d-%d", col_start, col_end, row_start, row_end);
-
-    // Пример влияния: если не учесть инверсию в 180° или 270°, изображение будет перевёрнуто.
-    // Например, установка col_start=x_start для 180° сдвинет изображение в противоположную сторону.
+    // Области, помеченные до поворота, заданы в прежних координатах и могут выходить за новый экран;
+    // новый кадр всё равно покрывает экран целиком
+    lvgl_disp->inv_p = 0;
+    lv_obj_invalidate(lv_scr_act());
+    lvgl_refr_now();
+    return ESP_OK;
+}
 
-    uint8_t params[4];
-    esp_err_t ret;
+esp_err_t rotate_display_measured(display_orientation_t orientation, int64_t *latency_us, uint64_t *color_bytes) {
+    uint64_t bytes_before = bus_stats.color_bytes;
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = rotate_display(orientation);
+    if (ret == ESP_OK) {
+        ret = wait_lcd_transfers(&lcd_panel_main);
+    }
+    *latency_us = esp_timer_get_time() - start_us;
+    *color_bytes = bus_stats.color_bytes - bytes_before;
+    return ret;
+}
 
-    // Установка CASET (столбцы, физический Y)
-    params[0] = (col_start >> 8) & 0xFF;
-    params[1] = col_start & 0xFF;
-    params[2] = (col_end >> 8) & 0xFF;
-    params[3] = col_end & 0xFF;
-    ret = esp_lcd_panel_io_tx_param(io_handle, 0x2A, params, 4);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "CASET failed: %s", esp_err_to_name(ret));
-        return ret;
+esp_err_t splash_draw(const void *image, size_t size) {
+    splash_header_t header;
+    splash_decoder_t decoder;
+    if (!lcd_panel_main.fill_buf || lcd_rotate_active(&lcd_panel_main)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!splash_open(image, size, &header, &decoder)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int hor_res = lcd_panel_main.orient->hor_res;
+    int ver_res = lcd_panel_main.orient->ver_res;
+    if (header.width > hor_res || header.height > ver_res) {
+        ESP_LOGE(TAG, "Splash %ux%u does not fit %dx%d", header.width, header.height, hor_res, ver_res);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    int64_t start_us = esp_timer_get_time();
+    int x0 = (hor_res - header.width) / 2;
+    int y0 = (ver_res - header.height) / 2;
+    int x1 = x0 + header.width - 1;
+    int y1 = y0 + header.height - 1;
+
+    // Поля вокруг изображения меньше экрана
+    esp_err_t ret = ESP_OK;
+    if (y0 > 0) {
+        ret = fill_area(&lcd_panel_main, 0, hor_res - 1, 0, y0 - 1, header.background);
+    }
+    if (ret == ESP_OK && y1 < ver_res - 1) {
+        ret = fill_area(&lcd_panel_main, 0, hor_res - 1, y1 + 1, ver_res - 1, header.background);
+    }
+    if (ret == ESP_OK && x0 > 0) {
+        ret = fill_area(&lcd_panel_main, 0, x0 - 1, y0, y1, header.background);
+    }
+    if (ret == ESP_OK && x1 < hor_res - 1) {
+        ret = fill_area(&lcd_panel_main, x1 + 1, hor_res - 1, y0, y1, header.background);
+    }
+    if (ret == ESP_OK) {
+        ret = wait_lcd_transfers(&lcd_panel_main); // Дальше fill_buf занят полосами изображения
+    }
+    lcd_panel_main.fill_valid = false;
+    if (ret == ESP_OK) {
+        ret = set_draw_area(&lcd_panel_main, x0, x1, y0, y1, NULL);
     }
 
-    // Установка RASET (строки, физический X)
-    params[0] = (row_start >> 8) & 0xFF;
-    params[1] = row_start & 0xFF;
-    params[2] = (row_end >> 8) & 0xFF;
-    params[3] = row_end & 0xFF;
-    ret = esp_lcd_panel_io_tx_param(io_handle, 0x2B, params, 4);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "RASET failed: %s", esp_err_to_name(ret));
-        return ret;
+    // Полосы чередуют половины fill_buf; половина свободна, когда завершилась её предыдущая передача
+    const size_t stripe = LCD_FILL_BUF_PIXELS / 2;
+    uint16_t *half[2] = {lcd_panel_main.fill_buf, lcd_panel_main.fill_buf + stripe};
+    uint32_t half_busy_until[2] = {lcd_panel_main.color_done, lcd_panel_main.color_done};
+    size_t remaining = (size_t)header.width * header.height;
+    int cmd = 0x2C;
+    for (int k = 0; ret == ESP_OK && remaining > 0; k ^= 1) {
+        while ((int32_t)(lcd_panel_main.color_done - half_busy_until[k]) < 0) {
+            lcd_dma_wait_step();
+            esp_rom_delay_us(10); // Полоса передаётся за единицы мс, а задач, которым нужно ядро, при старте нет
+        }
+        size_t n = MIN(remaining, stripe);
+        size_t decoded = splash_decode(&decoder, half[k], n);
+        if (decoded != n) {
+            ESP_LOGE(TAG, "Splash data ends %u pixels early", (unsigned)(remaining - decoded));
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        if (lcd_byte_order == LCD_BYTE_ORDER_RENDERER) {
+            rgb565_copy_swap(half[k], half[k], n); // Образ хранится в порядке CPU
+        }
+        ret = lcd_tx_color(&lcd_panel_main, cmd, half[k], n * sizeof(uint16_t));
+        half_busy_until[k] = lcd_panel_main.color_queued;
+        cmd = -1;
+        remaining -= n;
     }
+    esp_err_t wait_ret = wait_lcd_transfers(&lcd_panel_main);
+    if (ret == ESP_OK) {
+        ret = wait_ret;
+    }
+    ESP_LOGI(TAG, "Splash %ux%u %s (%" PRIu32 " bytes) at (%d,%d): %s in %" PRId64 " us",
+             header.width, header.height, header.encoding == SPLASH_ENCODING_RLE ? "RLE" : "raw", header.data_size,
+             x0, y0, esp_err_to_name(ret), esp_timer_get_time() - start_us);
+    return ret;
+}
 
-    // Начало записи в память (RAMWR)
-    ret = esp_lcd_panel_io_tx_param(io_handle, 0x2C, NULL, 0);
+#if !CONFIG_IDF_TARGET_LINUX
+/**
+ * Выводит заставку из раздела SPLASH_PARTITION: раздел отображается в адресное пространство (esp_partition_mmap)
+ * и декодируется прямо оттуда.
+ * @return ESP_OK при успехе, ESP_ERR_NOT_FOUND без раздела, иначе код ошибки splash_draw
+ */
+static esp_err_t splash_show(void) {
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                                SPLASH_PARTITION);
+    if (!partition) {
+        ESP_LOGW(TAG, "No \"%s\" partition, splash skipped", SPLASH_PARTITION);
+        return ESP_ERR_NOT_FOUND;
+    }
+    const void *image;
+    esp_partition_mmap_handle_t mmap_handle;
+    esp_err_t ret = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &image, &mmap_handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "RAMWR failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to map splash partition: %s", esp_err_to_name(ret));
         return ret;
     }
-
-    return ESP_OK;
+    ret = splash_draw(image, partition->size);
+    esp_partition_munmap(mmap_handle);
+    return ret;
 }
+#endif
 
 /**
- * Очищает экран, заполняя его указанным цветом в формате RGB565.
- * Учитывает текущую ориентацию для корректной установки области.
- * @param color Цвет в формате RGB565 (0x0000 = чёрный, 0xFFFF = белый)
- * @return ESP_OK при успехе, иначе код ошибки
+ * Заполняет буфер тестовым кадром с цветными полосами по краям (в порядке байт буфера, см. lcd_buffer_color).
+ * @param buffer Буфер кадра hor_res x ver_res пикселей
+ * @param hor_res Ширина кадра
+ * @param ver_res Высота кадра
  */
-static esp_err_t clear_screen(uint16_t color) {
-    ESP_LOGI(TAG, "Clearing screen with color 0x%04X, free heap: %" PRIu32, color, esp_get_free_heap_size());
+static void fill_edge_strips(uint16_t *buffer, int hor_res, int ver_res) {
+    int middle = ver_res - 2 * EDGE_STRIP_WIDTH; // Строки между верхней и нижней полосами
+    rgb565_fill(buffer, lcd_buffer_color(0x0000), (size_t)hor_res * ver_res); // Чёрный фон
+    rgb565_fill_rect(buffer, hor_res, 0, 0, hor_res, EDGE_STRIP_WIDTH, lcd_buffer_color(0xF800)); // Красная полоса сверху
+    rgb565_fill_rect(buffer, hor_res, 0, ver_res - EDGE_STRIP_WIDTH, hor_res, EDGE_STRIP_WIDTH, lcd_buffer_color(0x001F)); // Синяя полоса снизу
+    rgb565_fill_rect(buffer, hor_res, 0, EDGE_STRIP_WIDTH, EDGE_STRIP_WIDTH, middle, lcd_buffer_color(0x07E0)); // Зелёная полоса слева
+    rgb565_fill_rect(buffer, hor_res, hor_res - EDGE_STRIP_WIDTH, EDGE_STRIP_WIDTH, EDGE_STRIP_WIDTH, middle, lcd_buffer_color(0xFFFF)); // Белая полоса справа
+}
 
-    // Определение размеров области в зависимости от ориентации
-    int hor_res = (current_orientation == DISPLAY_ORIENTATION_0 || current_orientation == DISPLAY_ORIENTATION_180) ? LCD_H_RES : LCD_V_RES;
-    int ver_res = (current_orientation == DISPLAY_ORIENTATION_0 || current_orientation == DISPLAY_ORIENTATION_180) ? LCD_V_RES : LCD_H_RES;
+esp_err_t draw_edge_strips(void) {
+    int hor_res = lcd_panel_main.orient->hor_res;
+    int ver_res = lcd_panel_main.orient->ver_res;
 
-    // Выделение буфера для заливки
+    // Выделение буфера для полос
     uint16_t *buffer = heap_caps_malloc(hor_res * ver_res * sizeof(uint16_t), MALLOC_CAP_DMA);
     if (!buffer) {
-        ESP_LOGE(TAG, "Failed to allocate clear buffer");
+        ESP_LOGE(TAG, "Failed to allocate buffer for edge test");
         return ESP_ERR_NO_MEM;
     }
+    fill_edge_strips(buffer, hor_res, ver_res);
 
-    // Заполнение буфера указанным цветом
-    for (int i = 0; i < hor_res * ver_res; i++) {
-        buffer[i] = color;
-    }
-
-    // Установка области рисования для всего экрана
-    esp_err_t ret = set_draw_area(0, hor_res - 1, 0, ver_res - 1);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Set draw area failed: %s", esp_err_to_name(ret));
-        free(buffer);
-        return ret;
-    }
-
-    // Отрисовка буфера на дисплее
-    ESP_LOGI(TAG, "Drawing bitmap: x=0-%d, y=0-%d", hor_res - 1, ver_res - 1);
-    ret = esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, hor_res, ver_res, buffer);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Draw bitmap failed: %s", esp_err_to_name(ret));
-    }
+    // Установка области рисования и отрисовка полос
+    ESP_LOGI(TAG, "Drawing edge test: x=0-%d, y=0-%d", hor_res - 1, ver_res - 1);
+    esp_err_t ret = draw_area(&lcd_panel_main, 0, hor_res - 1, 0, ver_res - 1, buffer);
 
-    // Завершение передачи данных
-    esp_lcd_panel_io_tx_color(io_handle, -1, NULL, 0);
+    // Буфер освобождается только после окончания DMA
+    wait_lcd_transfers(&lcd_panel_main);
     free(buffer);
-
-    // Пример влияния: если не вызвать esp_lcd_panel_io_tx_color, данные могут остаться в буфере,
-    // что приведёт к частичному обновлению экрана или артефактам.
-
     return ret;
 }
 
@@ -362,60 +392,446 @@ static void test_fill_screen(void) {
 
     // Заливка экрана каждым цветом с задержкой 2 секунды
     for (size_t i = 0; i < sizeof(colors) / sizeof(colors[0]); i++) {
-        ret = clear_screen(colors[i].color);
+        ret = clear_screen(&lcd_panel_main, colors[i].color);
         ESP_LOGI(TAG, "%s clear (0x%04X) returned: %s", colors[i].name, colors[i].color, esp_err_to_name(ret));
-        vTaskDelay(pdMS_TO_TICKS(2000));
+        vTaskDelay(pdMS_TO_TICKS(2000 / DEMO_PAUSE_DIV));
     }
 
     // Тест цветных полос по краям экрана
     ESP_LOGI(TAG, "Testing edges with colored strips...");
-    int hor_res = (current_orientation == DISPLAY_ORIENTATION_0 || current_orientation == DISPLAY_ORIENTATION_180) ? LCD_H_RES : LCD_V_RES;
-    int ver_res = (current_orientation == DISPLAY_ORIENTATION_0 || current_orientation == DISPLAY_ORIENTATION_180) ? LCD_V_RES : LCD_H_RES;
+    ret = draw_edge_strips();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Edge test draw failed: %s", esp_err_to_name(ret));
+    }
+    vTaskDelay(pdMS_TO_TICKS(5000 / DEMO_PAUSE_DIV));
 
-    // Выделение буфера для полос
-    uint16_t *buffer = heap_caps_malloc(hor_res * ver_res * sizeof(uint16_t), MALLOC_CAP_DMA);
-    if (!buffer) {
-        ESP_LOGE(TAG, "Failed to allocate buffer for edge test");
-        return;
+    // Пример влияния: если задать неправильные границы (например, x=0-100 вместо 0-319 для 90°),
+    // полосы будут обрезаны, и только часть экрана обновится.
+}
+
+#if LCD_PERF
+/**
+ * Завершает кадр в замерах (из ISR окончания DMA последней области кадра): длительность, интервал
+ * от предыдущего кадра, пропущенные периоды обновления LVGL и запись в кольцо.
+ * @param now Момент окончания DMA (мкс)
+ */
+static void lcd_perf_frame_done(int64_t now) {
+    lcd_perf_frame_t *frame = &lcd_perf.last;
+    frame->frame = ++lcd_perf.frames;
+    frame->frame_us = now - lcd_perf.last_start_us;
+    frame->interval_us = lcd_perf.last_done_us ? now - lcd_perf.last_done_us : 0;
+    // Кадр дольше периода обновления сдвигает следующий: каждый начатый сверх первого период пропущен
+    frame->dropped = lcd_perf.period_us && frame->frame_us > lcd_perf.period_us ? (frame->frame_us - 1) / lcd_perf.period_us : 0;
+    lcd_perf.dropped += frame->dropped;
+    lcd_perf_hist_add(&lcd_perf.hist[LCD_PERF_FRAME], frame->frame_us);
+    if (lcd_perf.last_done_us) {
+        lcd_perf_hist_add(&lcd_perf.hist[LCD_PERF_INTERVAL], frame->interval_us);
+    }
+    lcd_perf_ring_push(&lcd_perf.ring, frame);
+    lcd_perf.last_done_us = now;
+}
+#endif
+
+esp_err_t lcd_perf_get(lcd_perf_snapshot_t *snapshot) {
+#if LCD_PERF
+    for (int i = 0; i < LCD_PERF_HIST_COUNT; i++) {
+        lcd_perf_hist_read(&lcd_perf.hist[i], &snapshot->hist[i]);
+    }
+    snapshot->recent_count = lcd_perf_ring_read(&lcd_perf.ring, snapshot->recent);
+    snapshot->frames = lcd_perf.frames;
+    snapshot->dropped = lcd_perf.dropped;
+    return ESP_OK;
+#else
+    memset(snapshot, 0, sizeof(*snapshot));
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * Перцентиль гистограммы снимка в микросекундах (гистограммы в тактах пересчитываются по LCD_PERF_CPU_MHZ).
+ * @param snapshot Снимок lcd_perf_get
+ * @param id Гистограмма длительности
+ * @param percent Перцентиль, 0..100
+ * @return Значение в мкс
+ */
+static uint32_t lcd_perf_percentile_us(const lcd_perf_snapshot_t *snapshot, lcd_perf_hist_id_t id, unsigned percent) {
+    uint32_t value = lcd_perf_hist_percentile(&snapshot->hist[id], percent);
+    return id <= LCD_PERF_TX_COLOR ? value / LCD_PERF_CPU_MHZ : value;
+}
+
+/**
+ * Окончание передачи по шине i80 (lcd_panel_t.on_trans_done, вызывается из ISR драйвера после того,
+ * как он учёл передачу в color_done и вернул кредит очереди шины).
+ * В асинхронном режиме сообщает LVGL, что буфер свободен, и обновляет статистику кадров.
+ * Передачи clear_screen и test_fill_screen игнорируются по флагу pending.
+ * Статистику областей и кадров (flush_stats, lcd_perf) ведёт только основная панель.
+ * @param panel Панель, передача которой завершилась
+ * @return true, если разбуженная задача требует переключения контекста
+ */
+static bool lvgl_flush_done_cb(lcd_panel_t *panel) {
+    BaseType_t woken = pdFALSE;
+    if (panel != &lcd_panel_main) {
+        if (!panel->lvgl_pending) {
+            return false;
+        }
+        panel->lvgl_pending = false;
+        if (panel->lvgl_last_area) {
+            panel->stats.frames++;
+        }
+    } else {
+        if (!flush_stats.pending) {
+            return false;
+        }
+        int64_t now = esp_timer_get_time();
+        flush_stats.pending = false;
+        flush_stats.done_us = now;
+        flush_stats.xfer_us += now - flush_stats.submit_us;
+#if LCD_PERF
+        lcd_perf_hist_add(&lcd_perf.hist[LCD_PERF_DMA], now - flush_stats.submit_us);
+#endif
+        LCD_TRACE_EVENT(LCD_TRACE_DMA_DONE, flush_stats.last_area, 0, 0);
+        if (flush_stats.last_area) {
+            flush_stats.last_frame_us = now - flush_stats.frame_start_us;
+            flush_stats.frame_start_us = 0;
+            flush_stats.frames++;
+            panel->stats.frames++;
+#if LCD_PERF
+            lcd_perf_frame_done(now);
+#endif
+        }
+    }
+#if LVGL_FLUSH_ASYNC
+    lv_disp_flush_ready(&panel->disp_drv);
+#endif
+    // Пробуждение задачи рендеринга, ожидающей в lvgl_wait_cb
+    if (lvgl_render.flush_sem) {
+        xSemaphoreGiveFromISR(lvgl_render.flush_sem, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * Callback ожидания LVGL: вызывается в цикле, пока предыдущая область ещё передаётся.
+ * Фиксирует момент окончания рендеринга для подсчёта перекрытия с DMA и усыпляет задачу
+ * до окончания передачи вместо холостого опроса флага.
+ * @param disp_drv Драйвер дисплея LVGL
+ */
+static void lvgl_wait_cb(lv_disp_drv_t *disp_drv) {
+    if (flush_stats.wait_us == 0) {
+        flush_stats.wait_us = esp_timer_get_time();
+    }
+#if LCD_PERF
+    if (!lcd_perf.waiting) {
+        lcd_perf.waiting = true;
+        lcd_perf.wait_start = lcd_perf_cycles();
+    }
+#endif
+    // Лишняя выдача семафора (от уже завершённой передачи) безопасна: LVGL проверит флаг и вызовет нас снова
+    lcd_dma_wait_step();
+    xSemaphoreTake(lvgl_render.flush_sem, pdMS_TO_TICKS(LVGL_FLUSH_WAIT_MS));
+}
+
+/**
+ * Выводит в лог статистику кадров LVGL, долю рендеринга, перекрытого передачей DMA,
+ * и счётчики транзакций шины (сколько команд приходится на одну область LVGL).
+ */
+static void log_flush_stats(void) {
+    int64_t xfer_us = flush_stats.xfer_us;
+    ESP_LOGI(TAG, "Flush stats: frames=%" PRIu32 ", flushes=%" PRIu32 ", last frame=%" PRId64 " us, DMA busy=%" PRId64 " us, "
+             "render/DMA overlap=%" PRId64 " us (%" PRId64 "%%)",
+             flush_stats.frames, flush_stats.flushes, flush_stats.last_frame_us, xfer_us, flush_stats.overlap_us,
+             xfer_us > 0 ? flush_stats.overlap_us * 100 / xfer_us : (int64_t)0);
+    ESP_LOGI(TAG, "Bus stats: cmd tx=%" PRIu32 ", color tx=%" PRIu32 ", CASET skipped=%" PRIu32 ", RASET skipped=%" PRIu32
+             ", color bytes=%" PRIu64 ", tx per flush=%.2f",
+             bus_stats.cmd_tx, bus_stats.color_tx, bus_stats.caset_skipped, bus_stats.raset_skipped,
+             bus_stats.color_bytes, flush_stats.flushes ? (double)bus_stats.flush_tx / flush_stats.flushes : 0.0);
+    if (lcd_bus.users > 1) {
+        log_panel_stats();
     }
+    // Выигрыш по модели: пиксели и накладные расходы flush в пересчёте на байты шины (байт за такт pclk)
+    ESP_LOGI(TAG, "Coalesce: %s, frames=%" PRIu32 ", areas in=%" PRIu32 ", out=%" PRIu32 ", merges=%" PRIu32 ", splits=%" PRIu32
+             ", LVGL joins=%" PRIu32 ", pixel bytes in=%" PRIu64 ", out=%" PRIu64 ", saved=%" PRId64 " bus bytes (%" PRId64 " us)",
+             lvgl_coalesce.enabled ? "on" : "off", lvgl_coalesce.frames, lvgl_coalesce.areas_in, lvgl_coalesce.areas_out,
+             lvgl_coalesce.merges, lvgl_coalesce.splits, lvgl_coalesce.lvgl_joins, lvgl_coalesce.pixel_bytes_in, lvgl_coalesce.pixel_bytes_out,
+             lvgl_coalesce.bytes_saved, lvgl_coalesce.bytes_saved * 1000000 / (int64_t)lcd_panel_main.pclk_hz);
+    uint32_t wakeups = lvgl_render.wakeups_timer + lvgl_render.wakeups_post;
+    ESP_LOGI(TAG, "Render task: wakeups timer=%" PRIu32 ", posted=%" PRIu32 ", avg sleep=%" PRId64 " ms, updates=%" PRIu32
+             " (dropped %" PRIu32 "), update-to-flush avg=%" PRId64 " max=%" PRId64 " us",
+             lvgl_render.wakeups_timer, lvgl_render.wakeups_post, wakeups ? lvgl_render.sleep_ms / wakeups : (int64_t)0,
+             lvgl_render.posts, lvgl_render.posts_dropped,
+             lvgl_render.wakeups_post ? lvgl_render.post_latency_sum_us / lvgl_render.wakeups_post : (int64_t)0,
+             lvgl_render.post_latency_max_us);
+#if LCD_TE_SYNC
+    // Jitter — разброс интервалов между импульсами TE; latency — задержка начала RAMWR после импульса
+    uint32_t pulses = lcd_te.pulses;
+    ESP_LOGI(TAG, "TE stats: pulses=%" PRIu32 ", period=%" PRId64 " us, jitter=%" PRId64 " us (min %" PRId64 ", max %" PRId64
+             "), synced frames=%" PRIu32 ", timeouts=%" PRIu32 ", wait=%" PRId64 " us, latency avg=%" PRId64 " max=%" PRId64
+             " us, beam waits=%" PRIu32 ", beam late=%" PRIu32,
+             pulses, pulses > 1 ? lcd_te.period_sum_us / (pulses - 1) : (int64_t)0, pulses > 2 ? lcd_te.period_max_us - lcd_te.period_min_us : (int64_t)0,
+             lcd_te.period_min_us, lcd_te.period_max_us, lcd_te.synced_frames, lcd_te.timeouts, lcd_te.wait_sum_us,
+             lcd_te.synced_frames ? lcd_te.latency_sum_us / lcd_te.synced_frames : (int64_t)0, lcd_te.latency_max_us,
+             lcd_te.beam_waits, lcd_te.beam_late);
+#endif
+#if LCD_PERF
+    // Одна строка на период: FPS за период, пропуски с начала работы, p50/p99 этапов
+    static lcd_perf_snapshot_t perf;          // Статический: снимок больше запаса стека главной задачи
+    static uint32_t prev_frames = 0;
+    static int64_t prev_us = 0;
+    lcd_perf_get(&perf);
+    int64_t now = esp_timer_get_time();
+    int64_t fps_x10 = prev_us ? (int64_t)(perf.frames - prev_frames) * 10000000 / (now - prev_us) : 0;
+    prev_frames = perf.frames;
+    prev_us = now;
+    const lcd_perf_hist_t *bytes = &perf.hist[LCD_PERF_BYTES];
+    ESP_LOGI(TAG, "Perf: %" PRId64 ".%" PRId64 " fps, dropped %" PRIu32 ", p50/p99 us: render %" PRIu32 "/%" PRIu32
+             ", flush %" PRIu32 "/%" PRIu32 ", area %" PRIu32 "/%" PRIu32 ", tx %" PRIu32 "/%" PRIu32 ", DMA %" PRIu32
+             "/%" PRIu32 ", frame %" PRIu32 "/%" PRIu32 ", %" PRIu64 " B/flush",
+             fps_x10 / 10, fps_x10 % 10, perf.dropped,
+             lcd_perf_percentile_us(&perf, LCD_PERF_RENDER, 50), lcd_perf_percentile_us(&perf, LCD_PERF_RENDER, 99),
+             lcd_perf_percentile_us(&perf, LCD_PERF_FLUSH, 50), lcd_perf_percentile_us(&perf, LCD_PERF_FLUSH, 99),
+             lcd_perf_percentile_us(&perf, LCD_PERF_SET_AREA, 50), lcd_perf_percentile_us(&perf, LCD_PERF_SET_AREA, 99),
+             lcd_perf_percentile_us(&perf, LCD_PERF_TX_COLOR, 50), lcd_perf_percentile_us(&perf, LCD_PERF_TX_COLOR, 99),
+             lcd_perf_percentile_us(&perf, LCD_PERF_DMA, 50), lcd_perf_percentile_us(&perf, LCD_PERF_DMA, 99),
+             lcd_perf_percentile_us(&perf, LCD_PERF_FRAME, 50), lcd_perf_percentile_us(&perf, LCD_PERF_FRAME, 99),
+             bytes->count ? bytes->sum / bytes->count : (uint64_t)0);
+#endif
+}
 
-    // Заполнение буфера для отображения полос
-    for (int y = 0; y < ver_res; y++) {
-        for (int x = 0; x < hor_res; x++) {
-            int idx = y * hor_res + x;
-            buffer[idx] = 0x0000; // Чёрный фон
-            if (y < 30) buffer[idx] = 0xF800; // Красная полоса сверху
-            else if (y >= ver_res - 30) buffer[idx] = 0x001F; // Синяя полоса снизу
-            else if (x < 30) buffer[idx] = 0x07E0; // Зелёная полоса слева
-            else if (x >= hor_res - 30) buffer[idx] = 0xFFFF; // Белая полоса справа
+#if LCD_TE_SYNC
+/**
+ * Учитывает импульс TE: интервал от предыдущего импульса и его разброс (jitter).
+ * @param now Момент импульса (мкс)
+ */
+static void IRAM_ATTR lcd_te_pulse(int64_t now) {
+    if (lcd_te.pulses > 0) {
+        int64_t period = now - lcd_te.last_us;
+        lcd_te.period_sum_us += period;
+        if (lcd_te.pulses == 1 || period < lcd_te.period_min_us) {
+            lcd_te.period_min_us = period;
+        }
+        if (period > lcd_te.period_max_us) {
+            lcd_te.period_max_us = period;
         }
     }
+    lcd_te.last_us = now;
+    lcd_te.pulses++;
+    LCD_TRACE_EVENT(LCD_TRACE_TE, 0, 0, 0);
+}
 
-    // Установка области рисования и отрисовка полос
-    ret = set_draw_area(0, hor_res - 1, 0, ver_res - 1);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Set draw area failed: %s", esp_err_to_name(ret));
-        free(buffer);
-        return;
+/**
+ * Обработчик прерывания по фронту TE (начало вертикального гашения панели).
+ * @param arg Не используется
+ */
+static void IRAM_ATTR lcd_te_isr(void *arg) {
+    BaseType_t woken = pdFALSE;
+    lcd_te_pulse(esp_timer_get_time());
+    xSemaphoreGiveFromISR(lcd_te.sem, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
     }
+}
 
-    ESP_LOGI(TAG, "Drawing edge test: x=0-%d, y=0-%d", hor_res - 1, ver_res - 1);
-    ret = esp_lcd_panel_draw_bitmap(panel_handle, 0, 0, hor_res, ver_res, buffer);
+/**
+ * Callback таймера, заменяющего TE, когда пин не подключён (и на хосте).
+ * @param arg Не используется
+ */
+static void lcd_te_timer_cb(void *arg) {
+    lcd_te_pulse(esp_timer_get_time());
+    xSemaphoreGive(lcd_te.sem);
+}
+
+/**
+ * Запускает источник импульсов TE: прерывание по LCD_PIN_TE или, только на хосте без вывода TE,
+ * периодический таймер LCD_TE_PERIOD_US. Панель выдаёт TE после команды TEON (0x35) из lcd_st7789v.
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t init_te(void) {
+    lcd_te.sem = xSemaphoreCreateBinary();
+    if (!lcd_te.sem) {
+        ESP_LOGE(TAG, "Failed to create TE semaphore");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret;
+    if (LCD_PIN_TE >= 0) {
+        gpio_config_t te_gpio_config = {
+            .pin_bit_mask = 1ULL << (LCD_PIN_TE >= 0 ? LCD_PIN_TE : 0),
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_ENABLE, // Без панели вход не должен плавать и давать ложные импульсы
+            .intr_type = GPIO_INTR_POSEDGE,
+        };
+        ret = gpio_config(&te_gpio_config);
+        if (ret == ESP_OK) {
+            ret = gpio_install_isr_service(0);
+            if (ret == ESP_ERR_INVALID_STATE) {
+                ret = ESP_OK; // Служба уже установлена другим модулем
+            }
+        }
+        if (ret == ESP_OK) {
+            ret = gpio_isr_handler_add(LCD_PIN_TE, lcd_te_isr, NULL);
+        }
+        ESP_LOGI(TAG, "TE source: GPIO %d", LCD_PIN_TE);
+    } else {
+        const esp_timer_create_args_t timer_args = {
+            .callback = lcd_te_timer_cb,
+            .name = "lcd_te",
+        };
+        ret = esp_timer_create(&timer_args, &lcd_te.timer);
+        if (ret == ESP_OK) {
+            ret = esp_timer_start_periodic(lcd_te.timer, LCD_TE_PERIOD_US);
+        }
+        ESP_LOGI(TAG, "TE source: timer, period %d us (host emulation, no phase relation to the scan)", LCD_TE_PERIOD_US);
+    }
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Edge test draw failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to start TE source: %s", esp_err_to_name(ret));
     }
+    return ret;
+}
 
-    esp_lcd_panel_io_tx_color(io_handle, -1, NULL, 0);
-    free(buffer);
-    vTaskDelay(pdMS_TO_TICKS(5000));
+/**
+ * Ждёт следующего импульса TE. Импульс, пришедший до вызова, не учитывается:
+ * вывод начинается в начале гашения, а не в середине развёртки.
+ * @return ESP_OK после импульса, ESP_ERR_TIMEOUT если импульса не было LCD_TE_TIMEOUT_MS
+ */
+static esp_err_t lcd_te_wait(void) {
+    int64_t start_us = esp_timer_get_time();
+    xSemaphoreTake(lcd_te.sem, 0);
+    bool ok = xSemaphoreTake(lcd_te.sem, pdMS_TO_TICKS(LCD_TE_TIMEOUT_MS)) == pdTRUE;
+    lcd_te.wait_sum_us += esp_timer_get_time() - start_us;
+    if (!ok) {
+        lcd_te.timeouts++;
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
 
-    // Пример влияния: если задать неправильные границы (например, x=0-100 вместо 0-319 для 90°),
-    // полосы будут обрезаны, и только часть экрана обновится.
+/**
+ * Период кадра панели: средний измеренный интервал TE или номинальный, пока импульсов мало.
+ * @return Период в мкс
+ */
+static int64_t lcd_te_period_us(void) {
+    uint32_t pulses = lcd_te.pulses;
+    return pulses > 1 ? lcd_te.period_sum_us / (pulses - 1) : lcd_te.nominal_period_us;
 }
 
+/**
+ * Новый номинальный период кадра после смены частоты развёртки (FRCTRL2): статистика периода
+ * начинается заново, таймер, заменяющий неразведённый вывод TE, перезапускается.
+ * @param period_us Период кадра в мкс
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t lcd_te_set_period(int64_t period_us) {
+    lcd_te.nominal_period_us = period_us;
+    lcd_te.pulses = 0;
+    lcd_te.period_sum_us = 0;
+    lcd_te.period_min_us = 0;
+    lcd_te.period_max_us = 0;
+    if (!lcd_te.timer) {
+        return ESP_OK;
+    }
+    esp_timer_stop(lcd_te.timer);
+    return esp_timer_start_periodic(lcd_te.timer, period_us);
+}
+
+/**
+ * Суммарная площадь областей, которые LVGL перерисовывает в текущем кадре.
+ * @return Количество пикселей
+ */
+static uint32_t lvgl_frame_dirty_pixels(void) {
+    uint32_t pixels = 0;
+    if (lvgl_disp) {
+        for (uint16_t i = 0; i < lvgl_disp->inv_p; i++) {
+            if (!lvgl_disp->inv_area_joined[i]) {
+                pixels += lv_area_get_size(&lvgl_disp->inv_areas[i]);
+            }
+        }
+    }
+    return pixels;
+}
+
+/**
+ * Задерживает вывод полосы, пока строка развёртки не пройдёт её последнюю строку стекла
+ * ("racing the beam": запись идёт позади развёртки и попадает целиком в следующий кадр).
+ * Возможно, когда область пишется вдоль строк развёртки: в 0° и 180°, а при программном повороте и в 90°/270°.
+ * Полоса LVGL в 90°/270° (логические строки) занимает все строки стекла, поэтому выигрыш там даёт
+ * только полнокадровый буфер.
+ * @param area Область LVGL (логические координаты)
+ */
+static void lcd_te_follow_beam(const lv_area_t *area) {
+    // Строки стекла, занятые полосой (в 180° порядок строк обратный, в 90°/270° строки стекла — логические столбцы)
+    int gx, gy1, gy2;
+    lcd_orientation_to_glass(lcd_panel_main.orient, area->x1, area->y1, &gx, &gy1);
+    lcd_orientation_to_glass(lcd_panel_main.orient, area->x2, area->y2, &gx, &gy2);
+    int gy_first = MIN(gy1, gy2);
+    int gy_last = MAX(gy1, gy2);
+
+    int64_t period = lcd_te_period_us();
+    int64_t frame_start = lcd_te.last_us;
+    int64_t now = esp_timer_get_time();
+    while (frame_start + period <= now) {
+        frame_start += period; // Импульс мог быть пропущен: фаза развёртки продолжается от последнего
+    }
+    int64_t line_us = period / LCD_V_RES;
+    int64_t passed_us = frame_start + (gy_last + 1) * line_us;
+    if (passed_us > now) {
+        int64_t delay_us = passed_us - now;
+        lcd_te.beam_waits++;
+        if (delay_us >= portTICK_PERIOD_MS * 1000) {
+            vTaskDelay(delay_us / (portTICK_PERIOD_MS * 1000));
+        }
+        now = esp_timer_get_time();
+        if (passed_us > now) {
+            esp_rom_delay_us(passed_us - now);
+        }
+        now = passed_us;
+    }
+
+    // Разрыв возможен, если передача закончится после того, как развёртка вернётся к первой строке полосы
+    int64_t xfer_us = (int64_t)lv_area_get_size(area) * sizeof(uint16_t) * 1000000 / lcd_panel_main.pclk_hz;
+    if (now + xfer_us > frame_start + period + gy_first * line_us) {
+        lcd_te.beam_late++;
+    }
+}
+
+/**
+ * Планирование вывода области LVGL относительно развёртки панели.
+ * Первая область крупного кадра (LCD_TE_SYNC_MIN_PIXELS) ждёт импульса TE; при LCD_TE_RACE_BEAM
+ * в ориентациях 0°/180° (и в 90°/270° при программном повороте) каждая полоса вместо этого
+ * выводится вслед за строкой развёртки.
+ * @param area Область LVGL, которая сейчас будет передана
+ * @param first_area Область первая в кадре
+ */
+static void lcd_te_schedule(const lv_area_t *area, bool first_area) {
+    bool race_beam = LCD_TE_RACE_BEAM && (!lcd_panel_main.orient->landscape || lcd_rotate_active(&lcd_panel_main));
+    if (first_area) {
+        lcd_te.frame_synced = false;
+        if (lvgl_frame_dirty_pixels() >= LCD_TE_SYNC_MIN_PIXELS) {
+            lcd_te.frame_synced = race_beam || lcd_te_wait() == ESP_OK;
+        }
+    }
+    if (!lcd_te.frame_synced) {
+        return;
+    }
+    if (race_beam) {
+        lcd_te_follow_beam(area);
+    }
+    if (first_area) {
+        int64_t latency = esp_timer_get_time() - lcd_te.last_us;
+        lcd_te.synced_frames++;
+        lcd_te.latency_sum_us += latency;
+        if (latency > lcd_te.latency_max_us) {
+            lcd_te.latency_max_us = latency;
+        }
+    }
+}
+#endif
+
 /**
  * Callback-функция для рендеринга LVGL на дисплей ST7789.
  * Передаёт пиксельные данные в дисплей с учётом текущей ориентации.
+ * В асинхронном режиме (LVGL_FLUSH_ASYNC) только ставит передачу в очередь DMA,
+ * а lv_disp_flush_ready вызывается из lvgl_flush_done_cb по окончании передачи.
  * @param disp_drv Драйвер дисплея LVGL
  * @param area Область для рендеринга (координаты x1, x2, y1, y2)
  * @param color_p Буфер с данными цвета (RGB565)
@@ -427,64 +843,883 @@ static void lvgl_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_col
     int y_end = area->y2;
 
     ESP_LOGD(TAG, "LVGL flush: x=%d-%d, y=%d-%d", x_start, x_end, y_start, y_end);
-
-    // Установка области рисования
-    esp_err_t ret = set_draw_area(x_start, x_end, y_start, y_end);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "LVGL set draw area failed: %s", esp_err_to_name(ret));
-        return; // Не вызывать lv_disp_flush_ready при ошибке
+    LCD_TRACE_EVENT(LCD_TRACE_FLUSH_BEGIN, lv_disp_flush_is_last(disp_drv), (uint16_t)x_start | (uint32_t)y_start << 16,
+                    (uint16_t)x_end | (uint32_t)y_end << 16);
+
+    // Учёт перекрытия: рендеринг этой области начался, когда предыдущая была поставлена в очередь,
+    // и закончился либо при входе сюда, либо при первом вызове lvgl_wait_cb
+    int64_t now = esp_timer_get_time();
+    int64_t render_end = flush_stats.wait_us ? flush_stats.wait_us : now;
+    if (flush_stats.flushes > 0) {
+        int64_t overlap = MIN(render_end, flush_stats.done_us) - flush_stats.submit_us;
+        if (overlap > 0) {
+            flush_stats.overlap_us += overlap;
+        }
+    }
+    flush_stats.wait_us = 0;
+#if LCD_PERF
+    // Ожидание буфера и сам flush не входят во время рендеринга
+    uint32_t perf_start = lcd_perf_cycles();
+    if (lcd_perf.waiting) {
+        lcd_perf.excluded += perf_start - lcd_perf.wait_start;
+        lcd_perf.waiting = false;
     }
+    uint32_t bytes = (uint32_t)(x_end - x_start + 1) * (y_end - y_start + 1) * sizeof(lv_color_t);
+    lcd_perf_hist_add(&lcd_perf.hist[LCD_PERF_BYTES], bytes);
+    lcd_perf.bytes += bytes;
+    lcd_perf.flushes++;
+    if (lv_disp_flush_is_last(disp_drv)) {
+        // Кадр дописывает ISR окончания этой области; следующая последняя область до него не начнётся,
+        // так как LVGL ждёт освобождения буфера перед каждым flush
+        uint32_t render = perf_start - lcd_perf.refr_start - lcd_perf.excluded;
+        lcd_perf.last = (lcd_perf_frame_t){
+            .render_cycles = render,
+            .bytes = lcd_perf.bytes,
+            .flushes = lcd_perf.flushes,
+        };
+        lcd_perf.last_start_us = lcd_perf.refr_start_us;
+        lcd_perf_hist_add(&lcd_perf.hist[LCD_PERF_RENDER], render);
+    }
+#endif
+    bool first_area = flush_stats.frame_start_us == 0;
+    if (first_area) {
+        flush_stats.frame_start_us = now;
+    }
+
+#if LCD_TE_SYNC
+    // Начало записи крупного кадра привязывается к развёртке панели
+    lcd_te_schedule(area, first_area);
+#endif
 
-    // Отрисовка пиксельных данных
-    ret = esp_lcd_panel_draw_bitmap(panel_handle, x_start, y_start, x_end + 1, y_end + 1, color_p);
+    // Установка области рисования и отрисовка пиксельных данных: передача ставится в очередь DMA,
+    // окончание сигнализирует lvgl_flush_done_cb
+    uint32_t tx_before = bus_stats.cmd_tx + bus_stats.color_tx;
+    flush_stats.last_area = lv_disp_flush_is_last(disp_drv);
+    flush_stats.submit_us = esp_timer_get_time();
+    flush_stats.pending = true;
+    flush_stats.flushes++;
+    esp_err_t ret = draw_area(&lcd_panel_main, x_start, x_end, y_start, y_end, color_p);
+    bus_stats.flush_tx += bus_stats.cmd_tx + bus_stats.color_tx - tx_before;
+    LCD_TRACE_EVENT(LCD_TRACE_FLUSH_END, ret != ESP_OK,
+                    (uint32_t)(x_end - x_start + 1) * (y_end - y_start + 1) * sizeof(lv_color_t), 0);
+#if LCD_PERF
+    uint32_t perf_flush = lcd_perf_cycles() - perf_start;
+    lcd_perf_hist_add(&lcd_perf.hist[LCD_PERF_FLUSH], perf_flush);
+    lcd_perf.excluded += perf_flush;
+#endif
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "LVGL draw bitmap failed: %s", esp_err_to_name(ret));
-        return;
+        flush_stats.pending = false;
+        ESP_LOGE(TAG, "LVGL draw area failed: %s", esp_err_to_name(ret));
+        return; // Не вызывать lv_disp_flush_ready при ошибке
     }
 
-    // Завершение передачи данных
-    esp_lcd_panel_io_tx_color(io_handle, -1, NULL, 0);
-
-    // Уведомление LVGL о завершении рендеринга
+#if !LVGL_FLUSH_ASYNC
+    // Синхронный режим: дождаться окончания передачи и сразу уведомить LVGL
+    wait_lcd_transfers(&lcd_panel_main);
     lv_disp_flush_ready(disp_drv);
+#endif
 
     // Пример влияния: если не вызвать lv_disp_flush_ready, LVGL будет считать, что рендеринг не завершён,
     // что приведёт к задержкам или пропуску кадров.
 }
 
 /**
- * Инициализирует библиотеку LVGL и регистрирует дисплейный драйвер.
- * Настраивает буферы рендеринга и фон экрана.
+ * Возвращает название размещения буферов LVGL для логов.
+ * @param placement Размещение
+ * @return Строка с названием
  */
-static void init_lvgl(void) {
-    ESP_LOGI(TAG, "Initializing LVGL...");
-
-    // Инициализация LVGL
-    lv_init();
+static const char *lvgl_buf_placement_name(lvgl_buf_placement_t placement) {
+    switch (placement) {
+        case LVGL_BUF_INTERNAL_DMA: return "internal";
+        case LVGL_BUF_PSRAM:        return "psram";
+        case LVGL_BUF_FULL_FRAME:   return "full-frame";
+        default:                    return "?";
+    }
+}
 
-    // Выделение двух буферов для рендеринга
-    static lv_color_t lvgl_buf1[LVGL_BUFFER_SIZE / sizeof(lv_color_t)];
-    static lv_color_t lvgl_buf2[LVGL_BUFFER_SIZE / sizeof(lv_color_t)];
-    static lv_disp_draw_buf_t disp_buf;
-    lv_disp_draw_buf_init(&disp_buf, lvgl_buf1, lvgl_buf2, LVGL_BUFFER_SIZE / sizeof(lv_color_t));
+/**
+ * Выделяет один буфер рендеринга LVGL в памяти с заданными возможностями.
+ * Буферы в PSRAM выравниваются по LCD_PSRAM_TRANS_ALIGN по адресу и размеру,
+ * иначе DMA i80 не сможет читать их напрямую, а синхронизация кэша затронет соседние данные.
+ * @param bytes Размер буфера в байтах (для PSRAM округляется вверх)
+ * @param caps Возможности памяти (MALLOC_CAP_*)
+ * @return Указатель на буфер или NULL
+ */
+static lv_color_t *lvgl_buffer_alloc(size_t bytes, uint32_t caps) {
+    if (caps & MALLOC_CAP_SPIRAM) {
+        return heap_caps_aligned_alloc(LCD_PSRAM_TRANS_ALIGN, bytes, caps);
+    }
+    return heap_caps_malloc(bytes, caps);
+}
 
-    // Пример влияния: использование одного буфера (lvgl_buf2=NULL) может вызвать мерцание,
-    // так как LVGL будет рендерить новый кадр, пока старый ещё передаётся на дисплей.
+/**
+ * Освобождает буферы рендеринга и поворота и отключает их от LVGL: дисплей остаётся без буферов,
+ * и lvgl_refr_timer_cb не рендерит, пока lvgl_buffers_configure не выделит новые.
+ * Передачи из буферов к этому моменту должны быть завершены.
+ */
+static void lvgl_buffers_release(void) {
+    heap_caps_free(lvgl_buf_layout.buf1);
+    heap_caps_free(lvgl_buf_layout.buf2);
+    heap_caps_free(lvgl_buf_layout.rotate_buf);
+    lvgl_buf_layout.buf1 = NULL;
+    lvgl_buf_layout.buf2 = NULL;
+    lvgl_buf_layout.rotate_buf = NULL;
+    lcd_panel_main.rotate.buf = NULL;
+    lv_disp_draw_buf_init(&lcd_panel_main.draw_buf, NULL, NULL, 0);
+}
+
+/**
+ * Выбирает размер и размещение буферов рендеринга LVGL и (пере)выделяет их.
+ * Может вызываться во время работы: дожидается окончания передачи текущей области, выделяет новые буферы,
+ * подключает их к LVGL, затем освобождает прежние и перерисовывает экран целиком. При ошибке выделения
+ * прежняя раскладка остаётся подключённой. Исключение — буферы на весь экран: два кадра рядом с прежними
+ * буферами не помещаются, поэтому прежние освобождаются заранее, а при ошибке раскладка восстанавливается;
+ * если и это не удалось, LVGL остаётся без буферов (NULL) и не рендерит до следующего успешного вызова.
+ * При программном повороте выделяет ещё и буфер поворота того же размера.
+ * @param placement Размещение буферов (LVGL_BUF_INTERNAL_DMA, LVGL_BUF_PSRAM, LVGL_BUF_FULL_FRAME)
+ * @param lines Высота буфера в строках по LCD_H_RES пикселей (для LVGL_BUF_FULL_FRAME не используется)
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_ARG при неверном числе строк, ESP_ERR_NO_MEM при нехватке памяти
+ */
+static esp_err_t lvgl_buffers_configure(lvgl_buf_placement_t placement, int lines) {
+    if (placement == LVGL_BUF_FULL_FRAME) {
+        lines = LCD_V_RES;
+    }
+    if (lines < 1 || lines > LCD_V_RES) {
+        ESP_LOGE(TAG, "Invalid LVGL buffer lines: %d", lines);
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t pixels = (size_t)LCD_H_RES * lines;
+    size_t bytes = pixels * sizeof(lv_color_t);
+
+    // При программном повороте рядом с буферами рендеринга нужен третий такой же — для повёрнутых пикселей
+    bool rotate = lcd_rotation_mode == LCD_ROTATION_SOFTWARE;
+    int count = rotate ? 3 : 2;
+
+    // Выбор памяти
+    uint32_t caps = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL;
+    if (placement == LVGL_BUF_PSRAM) {
+        caps = MALLOC_CAP_SPIRAM;
+    } else if (placement == LVGL_BUF_FULL_FRAME) {
+        // Прежние буферы тоже будут освобождены, поэтому они учитываются как свободная память
+        int old_count = lvgl_buf_layout.rotate_buf ? 3 : 2;
+        size_t old_bytes = (lvgl_buf_layout.caps & MALLOC_CAP_INTERNAL) ? old_count * lvgl_buf_layout.buf_bytes : 0;
+        size_t internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL) + old_bytes;
+        if (internal_free < count * bytes + LVGL_FULL_FRAME_INTERNAL_HEADROOM) {
+            caps = MALLOC_CAP_SPIRAM;
+        }
+    }
+    if (caps & MALLOC_CAP_SPIRAM) {
+        bytes = (bytes + LCD_PSRAM_TRANS_ALIGN - 1) & ~(size_t)(LCD_PSRAM_TRANS_ALIGN - 1);
+    }
+
+    // Буферы нельзя освобождать или подменять, пока DMA читает область LVGL
+    if (lcd_panel_main.io) {
+        wait_lcd_transfers(&lcd_panel_main);
+    }
+    lvgl_buf_layout_t old_layout = lvgl_buf_layout;
+    bool release_first = placement == LVGL_BUF_FULL_FRAME && old_layout.buf1;
+    if (release_first) {
+        lvgl_buffers_release();
+    }
+
+    lv_color_t *buf1 = lvgl_buffer_alloc(bytes, caps);
+    lv_color_t *buf2 = buf1 ? lvgl_buffer_alloc(bytes, caps) : NULL;
+    lv_color_t *rotate_buf = buf2 && rotate ? lvgl_buffer_alloc(bytes, caps) : NULL;
+    esp_err_t ret = ESP_OK;
+    if (!buf2 || (rotate && !rotate_buf)) {
+        ESP_LOGE(TAG, "Failed to allocate LVGL buffers: %s, %d lines, %d x %u bytes",
+                 lvgl_buf_placement_name(placement), lines, count, (unsigned)bytes);
+        heap_caps_free(buf1);
+        heap_caps_free(buf2);
+        ret = ESP_ERR_NO_MEM;
+        if (!release_first) {
+            return ret; // Прежние буферы не тронуты и подключены к LVGL
+        }
+        // Возврат к прежней раскладке
+        placement = old_layout.placement;
+        lines = old_layout.lines;
+        pixels = old_layout.buf_pixels;
+        bytes = old_layout.buf_bytes;
+        caps = old_layout.caps;
+        count = old_layout.rotate_buf ? 3 : 2;
+        buf1 = lvgl_buffer_alloc(bytes, caps);
+        buf2 = buf1 ? lvgl_buffer_alloc(bytes, caps) : NULL;
+        rotate_buf = buf2 && old_layout.rotate_buf ? lvgl_buffer_alloc(bytes, caps) : NULL;
+        if (!buf2 || (old_layout.rotate_buf && !rotate_buf)) {
+            heap_caps_free(buf1);
+            heap_caps_free(buf2);
+            ESP_LOGE(TAG, "LVGL is left without buffers");
+            return ret;
+        }
+    }
+
+    lvgl_buf_layout.placement = placement;
+    lvgl_buf_layout.lines = lines;
+    lvgl_buf_layout.buf_pixels = pixels;
+    lvgl_buf_layout.buf_bytes = bytes;
+    lvgl_buf_layout.caps = caps;
+    lvgl_buf_layout.buf1 = buf1;
+    lvgl_buf_layout.buf2 = buf2;
+    lvgl_buf_layout.rotate_buf = (uint16_t *)rotate_buf;
+    lcd_panel_main.rotate.buf = lvgl_buf_layout.rotate_buf; // Буфер поворота передаётся драйверу панели
+    lcd_panel_main.rotate.buf_pixels = pixels;
+    lv_disp_draw_buf_init(&lcd_panel_main.draw_buf, buf1, buf2, pixels);
+    if (!release_first) {
+        // LVGL уже рисует в новых буферах, прежние никто не читает
+        heap_caps_free(old_layout.buf1);
+        heap_caps_free(old_layout.buf2);
+        heap_caps_free(old_layout.rotate_buf);
+    }
+
+    // Зарегистрированный дисплей перерисовывается в новых буферах
+    if (lvgl_disp) {
+        lv_obj_invalidate(lv_scr_act());
+    }
+    ESP_LOGI(TAG, "LVGL buffers: %s, %d lines, %d x %u bytes in %s, internal free %u",
+             lvgl_buf_placement_name(placement), lines, count, (unsigned)bytes,
+             (caps & MALLOC_CAP_SPIRAM) ? "PSRAM" : "internal RAM",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    return ret;
+}
+
+/**
+ * Возвращает текущую раскладку буферов рендеринга LVGL.
+ * @return Указатель на раскладку (действителен до следующего lvgl_buffers_configure)
+ */
+static const lvgl_buf_layout_t *lvgl_buffers_get_layout(void) {
+    return &lvgl_buf_layout;
+}
+
+/**
+ * @param mode Способ поворота
+ * @return Название способа для лога
+ */
+static const char *lcd_rotation_mode_name(lcd_rotation_mode_t mode) {
+    return mode == LCD_ROTATION_SOFTWARE ? "software" : "MADCTL";
+}
+
+esp_err_t lcd_set_rotation_mode(lcd_rotation_mode_t mode) {
+    lcd_rotation_mode_t old_mode = lcd_rotation_mode;
+    if (mode == old_mode) {
+        return ESP_OK;
+    }
+    lcd_rotation_mode = mode;
+    if (lvgl_buf_layout.buf1) {
+        esp_err_t ret = lvgl_buffers_configure(lvgl_buf_layout.placement, lvgl_buf_layout.lines);
+        if (ret != ESP_OK) {
+            // Прежняя раскладка осталась (или восстановлена) без нужного буфера поворота, поэтому остаётся прежний
+            // способ; если не удалось и восстановление, LVGL без буферов и не рендерит, а draw_area_rotated отвергает вывод
+            lcd_rotation_mode = old_mode;
+            ESP_LOGE(TAG, "Failed to switch rotation to %s: %s", lcd_rotation_mode_name(mode), esp_err_to_name(ret));
+            return ret;
+        }
+    } else if (mode == LCD_ROTATION_SOFTWARE) {
+        // Буфер поворота выделяется вместе с буферами LVGL
+        lcd_rotation_mode = old_mode;
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = apply_display_orientation(&lcd_panel_main, lcd_panel_main.orientation);
+    if (ret == ESP_OK && lvgl_disp) {
+        lv_obj_invalidate(lv_scr_act());
+    }
+    ESP_LOGI(TAG, "Rotation mode: %s", lcd_rotation_mode_name(mode));
+    return ret;
+}
+
+#if LVGL_BUFFER_BENCHMARK || CONFIG_DISPLAY_BENCHMARK
+// Раскладки буферов LVGL для замеров
+static const struct {
+    lvgl_buf_placement_t placement;
+    int lines;
+} lvgl_buffer_bench_configs[] = {
+    {LVGL_BUF_INTERNAL_DMA, 10},
+    {LVGL_BUF_INTERNAL_DMA, 40},
+    {LVGL_BUF_INTERNAL_DMA, 100},
+    {LVGL_BUF_PSRAM, 40},
+    {LVGL_BUF_PSRAM, 160},
+    {LVGL_BUF_FULL_FRAME, LCD_V_RES},
+};
+#define LVGL_BUFFER_BENCH_CONFIGS (sizeof(lvgl_buffer_bench_configs) / sizeof(lvgl_buffer_bench_configs[0]))
+
+static volatile bool lvgl_benchmark_finished = false; // lv_demo_benchmark закончил все сцены
+
+/**
+ * Callback окончания lv_demo_benchmark.
+ */
+static void lvgl_benchmark_finished_cb(void) {
+    lvgl_benchmark_finished = true;
+}
+#endif
+
+#if LVGL_BUFFER_BENCHMARK
+/**
+ * Прогоняет встроенный lv_demo_benchmark на нескольких раскладках буферов LVGL
+ * и выводит таблицу: FPS (кадры, доведённые до панели, за время прогона) и запас внутренней памяти.
+ * После замера восстанавливается раскладка из Kconfig.
+ */
+static void run_lvgl_buffer_benchmark(void) {
+    struct {
+        lvgl_buf_layout_t layout;   // Фактическая раскладка
+        uint32_t frames;            // Кадров за прогон
+        int64_t elapsed_us;         // Длительность прогона
+        size_t internal_free;       // Свободная внутренняя память во время прогона
+        size_t internal_largest;    // Наибольший свободный блок внутренней DMA-памяти
+        bool ok;                    // Раскладку удалось выделить
+    } results[LVGL_BUFFER_BENCH_CONFIGS] = {0};
+
+    lv_demo_benchmark_set_finished_cb(lvgl_benchmark_finished_cb);
+    lv_demo_benchmark_set_max_speed(true); // Без ожидания периода обновления: FPS ограничен рендерингом и шиной
+    for (size_t i = 0; i < LVGL_BUFFER_BENCH_CONFIGS; i++) {
+        if (lvgl_buffers_configure(lvgl_buffer_bench_configs[i].placement, lvgl_buffer_bench_configs[i].lines) != ESP_OK) {
+            continue;
+        }
+        results[i].layout = *lvgl_buffers_get_layout();
+        results[i].internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        results[i].internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+
+        lv_obj_clean(lv_scr_act());
+        lvgl_benchmark_finished = false;
+        uint32_t frames_start = flush_stats.frames;
+        int64_t start_us = esp_timer_get_time();
+        lv_demo_benchmark();
+        while (!lvgl_benchmark_finished) {
+            lv_task_handler();
+            vTaskDelay(1);
+        }
+        results[i].elapsed_us = esp_timer_get_time() - start_us;
+        results[i].frames = flush_stats.frames - frames_start;
+        results[i].ok = true;
+        lv_obj_clean(lv_scr_act());
+    }
+
+    // Возврат к раскладке из Kconfig
+    lvgl_buffers_configure(LVGL_BUFFER_PLACEMENT, LVGL_BUFFER_LINES);
+
+    ESP_LOGI(TAG, "placement  | lines | buffer bytes | memory   |   FPS | frames | internal free | largest DMA block");
+    for (size_t i = 0; i < LVGL_BUFFER_BENCH_CONFIGS; i++) {
+        if (!results[i].ok) {
+            ESP_LOGI(TAG, "%-10s | %5d | allocation failed", lvgl_buf_placement_name(lvgl_buffer_bench_configs[i].placement),
+                     lvgl_buffer_bench_configs[i].lines);
+            continue;
+        }
+        double fps = results[i].elapsed_us ? results[i].frames * 1e6 / results[i].elapsed_us : 0;
+        ESP_LOGI(TAG, "%-10s | %5d | %12u | %-8s | %5.1f | %6" PRIu32 " | %13u | %17u",
+                 lvgl_buf_placement_name(results[i].layout.placement), results[i].layout.lines,
+                 (unsigned)results[i].layout.buf_bytes,
+                 (results[i].layout.caps & MALLOC_CAP_SPIRAM) ? "PSRAM" : "internal",
+                 fps, results[i].frames,
+                 (unsigned)results[i].internal_free, (unsigned)results[i].internal_largest);
+    }
+}
+#endif
+
+#if CONFIG_DISPLAY_BENCHMARK
+#if !LCD_PERF
+#error "CONFIG_DISPLAY_BENCHMARK takes render and flush times from LCD_PERF"
+#endif
+
+// Накопленные замеры вывода в момент начала или конца сцены
+typedef struct {
+    int64_t us;                 // esp_timer
+    uint32_t frames;            // Выведено кадров
+    uint64_t render_cycles;     // Рисование LVGL
+    uint64_t flush_cycles;      // lvgl_flush_cb
+    uint64_t dma_us;            // Передача областей
+    uint64_t bytes;             // Байт пикселей
+} display_bench_sample_t;
+
+/**
+ * Снимает накопленные замеры вывода (суммы гистограмм lcd_perf).
+ * @param sample Куда записать
+ */
+static void display_bench_sample(display_bench_sample_t *sample) {
+    static lcd_perf_hist_t hist;
+    sample->us = esp_timer_get_time();
+    sample->frames = lcd_perf.frames;
+    lcd_perf_hist_read(&lcd_perf.hist[LCD_PERF_RENDER], &hist);
+    sample->render_cycles = hist.sum;
+    lcd_perf_hist_read(&lcd_perf.hist[LCD_PERF_FLUSH], &hist);
+    sample->flush_cycles = hist.sum;
+    lcd_perf_hist_read(&lcd_perf.hist[LCD_PERF_DMA], &hist);
+    sample->dma_us = hist.sum;
+    lcd_perf_hist_read(&lcd_perf.hist[LCD_PERF_BYTES], &hist);
+    sample->bytes = hist.sum;
+}
+
+/**
+ * Выводит строку результата сцены: "BENCH {json}" без префикса лога, чтобы её можно было выбрать grep
+ * и разобрать как JSON. Времена — средние на кадр.
+ * @param orientation Ориентация
+ * @param scene Название сцены
+ * @param start Замеры в начале сцены
+ * @param end Замеры в конце сцены
+ */
+static void display_bench_report(display_orientation_t orientation, const char *scene, const display_bench_sample_t *start,
+                                 const display_bench_sample_t *end) {
+    uint32_t frames = end->frames - start->frames;
+    int64_t elapsed_us = end->us - start->us;
+    uint32_t per_frame = MAX(frames, 1);
+    const lvgl_buf_layout_t *layout = lvgl_buffers_get_layout();
+    printf("BENCH {\"type\":\"scene\",\"orientation\":%d,\"buffer\":\"%s\",\"lines\":%d,\"scene\":\"%s\","
+           "\"frames\":%" PRIu32 ",\"fps\":%.1f,\"render_ms\":%.3f,\"flush_ms\":%.3f,\"dma_ms\":%.3f,\"bytes_per_frame\":%" PRIu64 "}\n",
+           orientation * 90, lvgl_buf_placement_name(layout->placement), layout->lines, scene, frames,
+           elapsed_us > 0 ? frames * 1e6 / elapsed_us : 0.0,
+           (end->render_cycles - start->render_cycles) / (LCD_PERF_CPU_MHZ * 1000.0) / per_frame,
+           (end->flush_cycles - start->flush_cycles) / (LCD_PERF_CPU_MHZ * 1000.0) / per_frame,
+           (end->dma_us - start->dma_us) / 1000.0 / per_frame, (end->bytes - start->bytes) / per_frame);
+}
+
+/**
+ * Название текущей сцены lv_demo_benchmark: текст первой метки экрана (заголовок демо "N/M: сцена")
+ * без номера.
+ * @return Название или NULL, если заголовка нет
+ */
+static const char *display_bench_scene_title(void) {
+    lv_obj_t *scr = lv_scr_act();
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(scr); i++) {
+        lv_obj_t *child = lv_obj_get_child(scr, i);
+        if (lv_obj_check_type(child, &lv_label_class)) {
+            const char *text = lv_label_get_text(child);
+            const char *name = strstr(text, ": ");
+            return name ? name + 2 : text;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Прогоняет lv_demo_benchmark (по сценам) и lv_demo_stress в одной ориентации на текущей раскладке буферов.
+ * LVGL обслуживается здесь же: задача рендеринга ещё не запущена.
+ * @param orientation Ориентация (уже установлена)
+ */
+static void display_bench_run_scenes(display_orientation_t orientation) {
+    display_bench_sample_t start, now;
+    char scene[48] = "";
+
+    // lv_demo_benchmark: граница сцены — смена заголовка, замер идёт от кадра к кадру без пауз
+    lv_obj_clean(lv_scr_act());
+    lvgl_benchmark_finished = false;
+    lv_demo_benchmark();
+    display_bench_sample(&start);
+    while (!lvgl_benchmark_finished) {
+        lv_timer_handler();
+        const char *title = display_bench_scene_title();
+        if (title && strncmp(title, scene, sizeof(scene) - 1) != 0) {
+            display_bench_sample(&now);
+            if (scene[0]) {
+                display_bench_report(orientation, scene, &start, &now);
+            }
+            snprintf(scene, sizeof(scene), "%s", title);
+            start = now;
+        }
+        vTaskDelay(1);
+    }
+    if (scene[0]) {
+        display_bench_sample(&now);
+        display_bench_report(orientation, scene, &start, &now);
+    }
+    lv_obj_clean(lv_scr_act());
+
+    // lv_demo_stress: одна сцена фиксированной длительности
+    if (CONFIG_DISPLAY_BENCHMARK_STRESS_MS == 0) {
+        return;
+    }
+    lv_demo_stress();
+    display_bench_sample(&start);
+    while (esp_timer_get_time() - start.us < CONFIG_DISPLAY_BENCHMARK_STRESS_MS * 1000LL) {
+        lv_timer_handler();
+        vTaskDelay(1);
+    }
+    display_bench_sample(&now);
+    display_bench_report(orientation, "stress", &start, &now);
+    lv_demo_stress_close();
+    lv_obj_clean(lv_scr_act());
+}
+
+/**
+ * Бенчмарк дисплея (CONFIG_DISPLAY_BENCHMARK, sdkconfig.defaults.benchmark): lv_demo_benchmark по сценам
+ * и lv_demo_stress в каждой ориентации и на каждой раскладке буферов LVGL. Каждая сцена — строка
+ * "BENCH {json}" в консоли; первая строка описывает прошивку, последняя отмечает конец прогона.
+ * После прогона восстанавливаются начальная ориентация и раскладка из Kconfig.
+ */
+static void run_display_benchmark(void) {
+#if CONFIG_DISPLAY_BENCHMARK_ALL_ORIENTATIONS
+    static const display_orientation_t orientations[] = {
+        DISPLAY_ORIENTATION_0, DISPLAY_ORIENTATION_90, DISPLAY_ORIENTATION_180, DISPLAY_ORIENTATION_270
+    };
+#else
+    static const display_orientation_t orientations[] = {DISPLAY_ORIENTATION_90};
+#endif
+#if CONFIG_IDF_TARGET_LINUX
+    const char *version = "host";
+#else
+    const char *version = esp_app_get_description()->version;
+#endif
+    printf("BENCH {\"type\":\"run\",\"version\":\"%s\",\"lvgl\":\"%d.%d.%d\",\"pclk_hz\":%" PRIu32
+           ",\"byte_order\":\"%s\",\"coalesce\":%s,\"te_sync\":%s}\n",
+           version, LVGL_VERSION_MAJOR, LVGL_VERSION_MINOR, LVGL_VERSION_PATCH, lcd_panel_main.pclk_hz,
+           lcd_byte_order_name(lcd_byte_order), LVGL_COALESCE ? "true" : "false", LCD_TE_SYNC ? "true" : "false");
+
+    lv_demo_benchmark_set_finished_cb(lvgl_benchmark_finished_cb);
+    lv_demo_benchmark_set_max_speed(true); // Без ожидания периода обновления: FPS ограничен рендерингом и шиной
+    int64_t start_us = esp_timer_get_time();
+    int runs = 0;
+    for (size_t o = 0; o < sizeof(orientations) / sizeof(orientations[0]); o++) {
+        set_display_orientation(&lcd_panel_main, orientations[o]);
+#if CONFIG_DISPLAY_BENCHMARK_ALL_BUFFERS
+        for (size_t i = 0; i < LVGL_BUFFER_BENCH_CONFIGS; i++) {
+            if (lvgl_buffers_configure(lvgl_buffer_bench_configs[i].placement, lvgl_buffer_bench_configs[i].lines) != ESP_OK) {
+                printf("BENCH {\"type\":\"skip\",\"orientation\":%d,\"buffer\":\"%s\",\"lines\":%d}\n",
+                       orientations[o] * 90, lvgl_buf_placement_name(lvgl_buffer_bench_configs[i].placement),
+                       lvgl_buffer_bench_configs[i].lines);
+                continue;
+            }
+            display_bench_run_scenes(orientations[o]);
+            runs++;
+        }
+#else
+        display_bench_run_scenes(orientations[o]);
+        runs++;
+#endif
+    }
+
+    lvgl_buffers_configure(LVGL_BUFFER_PLACEMENT, LVGL_BUFFER_LINES);
+    set_display_orientation(&lcd_panel_main, DISPLAY_ORIENTATION_90);
+    printf("BENCH {\"type\":\"end\",\"runs\":%d,\"elapsed_s\":%.1f}\n", runs, (esp_timer_get_time() - start_us) / 1e6);
+}
+#endif
+
+/**
+ * Стоимость вывода области в байтах шины по модели объединения.
+ * LVGL рендерит область полосами по размеру буфера, и каждая полоса — отдельный flush со своим окном,
+ * поэтому накладные расходы учитываются на каждую полосу. Шина 8-битная: байт за такт pclk.
+ * @param area Область
+ * @return Стоимость в байтах шины
+ */
+static uint32_t lvgl_area_cost(const lv_area_t *area) {
+    uint32_t w = area->x2 - area->x1 + 1;
+    uint32_t h = area->y2 - area->y1 + 1;
+    uint32_t rows = MAX(lvgl_buf_layout.buf_pixels / w, 1);
+    uint32_t flushes = (h + rows - 1) / rows;
+    uint32_t overhead = LVGL_COALESCE_CMD_BYTES + (uint32_t)((uint64_t)LVGL_COALESCE_FLUSH_OVERHEAD_US * lcd_panel_main.pclk_hz / 1000000);
+    return w * h * sizeof(uint16_t) + flushes * overhead;
+}
+
+/**
+ * Вычитает область a из области b. Результат — до четырёх непересекающихся полос:
+ * над пересечением, под ним, слева и справа от него.
+ * @param b Уменьшаемая область
+ * @param a Вычитаемая область (должна пересекаться с b)
+ * @param out Массив минимум из четырёх областей для результата
+ * @return Количество областей в out
+ */
+static int lvgl_area_subtract(const lv_area_t *b, const lv_area_t *a, lv_area_t *out) {
+    lv_area_t mid = {
+        .x1 = MAX(a->x1, b->x1), .y1 = MAX(a->y1, b->y1),
+        .x2 = MIN(a->x2, b->x2), .y2 = MIN(a->y2, b->y2),
+    };
+    int n = 0;
+    if (b->y1 < mid.y1) {
+        out[n++] = (lv_area_t){b->x1, b->y1, b->x2, mid.y1 - 1};
+    }
+    if (b->y2 > mid.y2) {
+        out[n++] = (lv_area_t){b->x1, mid.y2 + 1, b->x2, b->y2};
+    }
+    if (b->x1 < mid.x1) {
+        out[n++] = (lv_area_t){b->x1, mid.y1, mid.x1 - 1, mid.y2};
+    }
+    if (b->x2 > mid.x2) {
+        out[n++] = (lv_area_t){mid.x2 + 1, mid.y1, b->x2, mid.y2};
+    }
+    return n;
+}
+
+bool lvgl_area_lvgl_join(const lv_area_t *a, const lv_area_t *b, lv_area_t *joined) {
+    if (a->x1 > b->x2 || b->x1 > a->x2 || a->y1 > b->y2 || b->y1 > a->y2) {
+        return false;
+    }
+    *joined = (lv_area_t){
+        .x1 = MIN(a->x1, b->x1), .y1 = MIN(a->y1, b->y1),
+        .x2 = MAX(a->x2, b->x2), .y2 = MAX(a->y2, b->y2),
+    };
+    return lv_area_get_size(joined) < lv_area_get_size(a) + lv_area_get_size(b);
+}
+
+int64_t lvgl_areas_cost_as_is(const lv_area_t *areas, int n) {
+    lv_area_t joined_areas[LV_INV_BUF_SIZE];
+    bool joined[LV_INV_BUF_SIZE] = {0};
+    memcpy(joined_areas, areas, n * sizeof(lv_area_t));
+    for (int in = 0; in < n; in++) {
+        for (int from = 0; from < n && !joined[in]; from++) {
+            lv_area_t area;
+            if (from != in && !joined[from] && lvgl_area_lvgl_join(&joined_areas[in], &joined_areas[from], &area)) {
+                joined_areas[in] = area;
+                joined[from] = true;
+            }
+        }
+    }
+    int64_t cost = 0;
+    for (int i = 0; i < n; i++) {
+        if (!joined[i]) {
+            cost += lvgl_area_cost(&joined_areas[i]);
+        }
+    }
+    return cost;
+}
+
+void lvgl_coalesce_areas(lv_disp_t *disp) {
+    if (!lvgl_coalesce.enabled || !disp || disp->inv_p == 0) {
+        return;
+    }
+
+    lv_area_t areas[LV_INV_BUF_SIZE];
+    uint32_t costs[LV_INV_BUF_SIZE];
+    int n = 0;
+    uint64_t pixel_bytes_in = 0;
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (!disp->inv_area_joined[i]) {
+            areas[n] = disp->inv_areas[i];
+            costs[n] = lvgl_area_cost(&areas[n]);
+            pixel_bytes_in += lv_area_get_size(&areas[n]) * sizeof(uint16_t);
+            n++;
+        }
+    }
+    const int n_in = n;
+    int64_t cost_in = lvgl_areas_cost_as_is(areas, n);
+    lvgl_coalesce.areas_in += n;
+    lvgl_coalesce.pixel_bytes_in += pixel_bytes_in;
+    lvgl_coalesce.frames++;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < n && !changed; i++) {
+            for (int j = i + 1; j < n && !changed; j++) {
+                lv_area_t merged = {
+                    .x1 = MIN(areas[i].x1, areas[j].x1), .y1 = MIN(areas[i].y1, areas[j].y1),
+                    .x2 = MAX(areas[i].x2, areas[j].x2), .y2 = MAX(areas[i].y2, areas[j].y2),
+                };
+                uint32_t keep_cost = costs[i] + costs[j];
+                uint32_t merge_cost = lvgl_area_cost(&merged);
+
+                bool overlap = areas[i].x1 <= areas[j].x2 && areas[j].x1 <= areas[i].x2 &&
+                               areas[i].y1 <= areas[j].y2 && areas[j].y1 <= areas[i].y2;
+                // Деление: из одной области пары вырезается перекрытие с другой (выбирается более дешёвое направление)
+                lv_area_t pieces[4];
+                int piece_count = 0;
+                int cut = -1;           // Индекс разрезаемой области
+                uint32_t split_cost = UINT32_MAX;
+                if (overlap && n - 1 + 4 <= LV_INV_BUF_SIZE) {
+                    const int pair[2] = {i, j};
+                    for (int p = 0; p < 2; p++) {
+                        lv_area_t candidate[4];
+                        int count = lvgl_area_subtract(&areas[pair[p]], &areas[pair[1 - p]], candidate);
+                        uint32_t cost = costs[pair[1 - p]];
+                        for (int k = 0; k < count; k++) {
+                            cost += lvgl_area_cost(&candidate[k]);
+                        }
+                        if (cost < split_cost) {
+                            split_cost = cost;
+                            cut = pair[p];
+                            piece_count = count;
+                            memcpy(pieces, candidate, sizeof(pieces));
+                        }
+                    }
+                }
+
+                if (merge_cost < keep_cost && merge_cost <= split_cost) {
+                    areas[i] = merged;
+                    costs[i] = merge_cost;
+                    areas[j] = areas[n - 1];
+                    costs[j] = costs[n - 1];
+                    n--;
+                    lvgl_coalesce.merges++;
+                    changed = true;
+                } else if (split_cost < keep_cost) {
+                    // Разрезаемая область заменяется частями, не покрытыми другой (если она целиком внутри, частей нет)
+                    areas[cut] = areas[n - 1];
+                    costs[cut] = costs[n - 1];
+                    n--;
+                    for (int k = 0; k < piece_count; k++) {
+                        areas[n] = pieces[k];
+                        costs[n] = lvgl_area_cost(&pieces[k]);
+                        n++;
+                    }
+                    lvgl_coalesce.splits++;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Оставшиеся пересекающиеся пары LVGL объединил бы сам; до неподвижной точки, чтобы его проход ничего не менял
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < n && !changed; i++) {
+            for (int j = i + 1; j < n && !changed; j++) {
+                lv_area_t joined;
+                if (lvgl_area_lvgl_join(&areas[i], &areas[j], &joined)) {
+                    areas[i] = joined;
+                    costs[i] = lvgl_area_cost(&joined);
+                    areas[j] = areas[n - 1];
+                    costs[j] = costs[n - 1];
+                    n--;
+                    lvgl_coalesce.lvgl_joins++;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    int64_t cost_out = 0;
+    for (int i = 0; i < n; i++) {
+        cost_out += costs[i];
+    }
+    // Объединения LVGL могли сделать кадр дороже, чем без объединения: тогда области остаются как были
+    if (cost_out > cost_in) {
+        lvgl_coalesce.areas_out += n_in;
+        lvgl_coalesce.pixel_bytes_out += pixel_bytes_in;
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        disp->inv_areas[i] = areas[i];
+        disp->inv_area_joined[i] = 0;
+        lvgl_coalesce.pixel_bytes_out += lv_area_get_size(&areas[i]) * sizeof(uint16_t);
+    }
+    disp->inv_p = n;
+    lvgl_coalesce.areas_out += n;
+    lvgl_coalesce.bytes_saved += cost_in - cost_out;
+}
+
+/**
+ * При частичном показе обрезает области кадра LVGL по видимой полосе: то, что панель не показывает,
+ * не рендерится и не передаётся. Области целиком вне полосы удаляются.
+ * @param disp Дисплей LVGL
+ */
+static void lvgl_clip_to_active_area(lv_disp_t *disp) {
+    if (!lcd_power.partial || !disp) {
+        return;
+    }
+    lv_area_t active;
+    lcd_power_active_area(&lcd_power, &active);
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (disp->inv_area_joined[i]) {
+            continue;
+        }
+        lv_area_t clipped;
+        uint32_t size = lv_area_get_size(&disp->inv_areas[i]);
+        if (_lv_area_intersect(&clipped, &disp->inv_areas[i], &active)) {
+            disp->inv_areas[n] = clipped;
+            disp->inv_area_joined[n] = 0;
+            n++;
+            size -= lv_area_get_size(&clipped);
+        }
+        lcd_power_clipped_bytes += size * sizeof(uint16_t);
+    }
+    disp->inv_p = n;
+}
+
+/**
+ * Таймер обновления дисплея LVGL: перед штатным _lv_disp_refr_timer объединяет области кадра.
+ * Повторный пересчёт разметки в _lv_disp_refr_timer ничего не помечает, а его lv_refr_join_area
+ * не находит пар: lvgl_coalesce_areas уже выполнила его объединения (проверяется в run_coalesce_join_check).
+ * Устанавливается вместо обработчика refr_timer в init_lvgl.
+ * @param timer Таймер обновления дисплея
+ */
+static void lvgl_refr_timer_cb(lv_timer_t *timer) {
+    // Без буферов (lvgl_buffers_configure не смог выделить их) рендерить некуда: помеченные области
+    // остаются и выводятся после успешного lvgl_buffers_configure
+    if (!lvgl_buf_layout.buf1) {
+        return;
+    }
+#if LCD_PERF
+    // Начало кадра для замеров: рендеринг считается вместе с разметкой и объединением областей
+    lcd_perf.refr_start = lcd_perf_cycles();
+    lcd_perf.refr_start_us = esp_timer_get_time();
+    lcd_perf.period_us = timer->period * 1000;
+    lcd_perf.excluded = 0;
+    lcd_perf.waiting = false;
+    lcd_perf.bytes = 0;
+    lcd_perf.flushes = 0;
+#endif
+    LCD_TRACE_EVENT(LCD_TRACE_REFR_BEGIN, 0, 0, 0);
+    // Разметка пересчитывается заранее (как в начале _lv_disp_refr_timer): перемещение объектов
+    // тоже помечает области, и они должны попасть в объединение
+    lv_obj_update_layout(lvgl_disp->act_scr);
+    if (lvgl_disp->prev_scr) {
+        lv_obj_update_layout(lvgl_disp->prev_scr);
+    }
+    lv_obj_update_layout(lvgl_disp->top_layer);
+    lv_obj_update_layout(lvgl_disp->sys_layer);
+    lvgl_clip_to_active_area(lvgl_disp);
+    lvgl_coalesce_areas(lvgl_disp);
+#if LCD_TRACE
+    uint16_t areas = lvgl_disp->inv_p;
+#endif
+    _lv_disp_refr_timer(timer);
+    LCD_TRACE_EVENT(LCD_TRACE_REFR_END, 0, areas, 0);
+}
+
+void lvgl_refr_now(void) {
+    lv_anim_refr_now();
+    lvgl_refr_timer_cb(lvgl_disp->refr_timer);
+}
+
+/**
+ * Инициализирует библиотеку LVGL и регистрирует дисплейный драйвер.
+ * Настраивает буферы рендеринга и фон экрана.
+ */
+static void init_lvgl(void) {
+    ESP_LOGI(TAG, "Initializing LVGL...");
+
+    // Инициализация LVGL
+    lv_init();
+
+    // Блокировка LVGL, очередь обновлений и семафор окончания DMA для задачи рендеринга
+    lvgl_render.mutex = xSemaphoreCreateRecursiveMutex();
+    lvgl_render.queue = xQueueCreate(LVGL_UI_QUEUE_LEN, sizeof(lvgl_ui_msg_t));
+    lvgl_render.flush_sem = xSemaphoreCreateBinary();
+    if (!lvgl_render.mutex || !lvgl_render.queue || !lvgl_render.flush_sem) {
+        ESP_LOGE(TAG, "Failed to create LVGL render service objects");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+
+    // Выделение двух буферов для рендеринга (размещение и размер из Kconfig)
+    if (lvgl_buffers_configure(LVGL_BUFFER_PLACEMENT, LVGL_BUFFER_LINES) != ESP_OK) {
+        ESP_LOGW(TAG, "Falling back to internal LVGL buffers, %d lines", LVGL_BUFFER_LINES);
+        ESP_ERROR_CHECK(lvgl_buffers_configure(LVGL_BUF_INTERNAL_DMA, LVGL_BUFFER_LINES));
+    }
+
+    // Пример влияния: использование одного буфера (buf2=NULL в lv_disp_draw_buf_init) может вызвать мерцание,
+    // так как LVGL будет рендерить новый кадр, пока старый ещё передаётся на дисплей.
 
     // Настройка драйвера дисплея LVGL
-    static lv_disp_drv_t disp_drv;
-    lv_disp_drv_init(&disp_drv);
-    disp_drv.hor_res = LCD_V_RES; // Изначально 320 (будет обновлено в set_display_orientation)
-    disp_drv.ver_res = LCD_H_RES; // Изначально 170
-    disp_drv.flush_cb = lvgl_flush_cb; // Callback для рендеринга
-    disp_drv.draw_buf = &disp_buf;     // Буфер рендеринга
-    disp_drv.full_refresh = 0;         // Отключение полного обновления для оптимизации
-    lvgl_disp = lv_disp_drv_register(&disp_drv);
+    lv_disp_drv_t *disp_drv = &lcd_panel_main.disp_drv;
+    lv_disp_drv_init(disp_drv);
+    disp_drv->hor_res = LCD_V_RES; // Изначально 320 (будет обновлено в set_display_orientation)
+    disp_drv->ver_res = LCD_H_RES; // Изначально 170
+    disp_drv->flush_cb = lvgl_flush_cb; // Callback для рендеринга
+    disp_drv->wait_cb = lvgl_wait_cb;   // Callback ожидания освобождения буфера (для статистики перекрытия)
+    disp_drv->draw_buf = &lcd_panel_main.draw_buf; // Буфер рендеринга
+    disp_drv->full_refresh = 0;         // Отключение полного обновления для оптимизации
+    disp_drv->user_data = &lcd_panel_main;
+    lvgl_disp = lv_disp_drv_register(disp_drv);
+    lcd_panel_main.disp = lvgl_disp;
+
+    // Области кадра проходят через объединение до того, как LVGL начнёт их рендерить
+    lv_timer_set_cb(lvgl_disp->refr_timer, lvgl_refr_timer_cb);
 
     // Установка чёрного фона для активного экрана
     lv_obj_set_style_bg_color(lv_scr_act(), lv_color_black(), 0);
     lv_obj_set_style_bg_opa(lv_scr_act(), LV_OPA_COVER, 0);
 
+    // Способ поворота из Kconfig включается вместе с буферами: заставка до этого выводилась через MADCTL
+    if (LCD_ROTATION_MODE != LCD_ROTATION_MADCTL && lcd_set_rotation_mode(LCD_ROTATION_MODE) != ESP_OK) {
+        ESP_LOGW(TAG, "Keeping MADCTL rotation");
+    }
+
     ESP_LOGI(TAG, "LVGL initialized, display registered with black background");
 
     // Пример влияния: установка белого фона (lv_color_white()) сделает текст "Hello World" невидимым,
@@ -492,11 +1727,96 @@ static void init_lvgl(void) {
 }
 
 /**
- * Создаёт и настраивает виджет с текстом "Hello World" через LVGL.
- * Позиционирует метку в центре с указанным размером шрифта.
- * @param font_size Размер шрифта (16 или 28 для Montserrat)
+ * Callback рендеринга LVGL дополнительной панели: область выводится на панель драйвера (user_data).
+ * Окончание DMA отмечается по lvgl_pending панели,
+ * поэтому области разных панелей одновременно стоят в очередях своих интерфейсов и не ждут друг друга.
+ * @param disp_drv Драйвер дисплея LVGL панели
+ * @param area Область для рендеринга
+ * @param color_p Буфер с данными цвета (RGB565)
  */
-static void create_hello_world_label(int font_size) {
+static void lvgl_panel_flush_cb(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
+    lcd_panel_t *panel = disp_drv->user_data;
+    panel->lvgl_last_area = lv_disp_flush_is_last(disp_drv);
+    panel->lvgl_pending = true;
+    esp_err_t ret = draw_area(panel, area->x1, area->x2, area->y1, area->y2, color_p);
+#if !LVGL_FLUSH_ASYNC
+    if (ret == ESP_OK) {
+        ret = wait_lcd_transfers(panel);
+    }
+#endif
+    if (ret != ESP_OK) {
+        panel->lvgl_pending = false;
+        ESP_LOGE(TAG, "LVGL draw area on CS %d failed: %s", panel->cs_gpio, esp_err_to_name(ret));
+        return;
+    }
+#if !LVGL_FLUSH_ASYNC
+    lv_disp_flush_ready(disp_drv);
+#endif
+}
+
+/**
+ * Callback ожидания LVGL дополнительной панели: сон до окончания DMA, без учёта перекрытия (его ведёт основная панель).
+ * @param disp_drv Драйвер дисплея LVGL
+ */
+static void lvgl_panel_wait_cb(lv_disp_drv_t *disp_drv) {
+    lcd_dma_wait_step();
+    xSemaphoreTake(lvgl_render.flush_sem, pdMS_TO_TICKS(LVGL_FLUSH_WAIT_MS));
+}
+
+esp_err_t lvgl_panel_register(lcd_panel_t *panel, int lines) {
+    if (!panel->io || panel->disp) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    size_t pixels = (size_t)LCD_V_RES * lines;
+    for (int i = 0; i < 2; i++) {
+        panel->lvgl_buf[i] = heap_caps_malloc(pixels * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    }
+    if (!panel->lvgl_buf[0] || !panel->lvgl_buf[1]) {
+        ESP_LOGE(TAG, "Failed to allocate LVGL buffers for panel on CS %d", panel->cs_gpio);
+        heap_caps_free(panel->lvgl_buf[0]);
+        heap_caps_free(panel->lvgl_buf[1]);
+        panel->lvgl_buf[0] = panel->lvgl_buf[1] = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    lv_disp_draw_buf_init(&panel->draw_buf, panel->lvgl_buf[0], panel->lvgl_buf[1], pixels);
+
+    lv_disp_drv_t *disp_drv = &panel->disp_drv;
+    lv_disp_drv_init(disp_drv);
+    disp_drv->hor_res = panel->orient->hor_res;
+    disp_drv->ver_res = panel->orient->ver_res;
+    disp_drv->flush_cb = lvgl_panel_flush_cb;
+    disp_drv->wait_cb = lvgl_panel_wait_cb;
+    disp_drv->draw_buf = &panel->draw_buf;
+    disp_drv->user_data = panel;
+    panel->disp = lv_disp_drv_register(disp_drv);
+    panel->on_trans_done = lvgl_flush_done_cb; // Окончание передачи освобождает буфер LVGL этой панели
+
+    // Первый зарегистрированный дисплей остаётся дисплеем по умолчанию: lv_scr_act() — экран основной панели
+    lv_obj_t *scr = lv_disp_get_scr_act(panel->disp);
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
+    ESP_LOGI(TAG, "LVGL display for panel on CS %d: %dx%d, 2 x %d lines", panel->cs_gpio, disp_drv->hor_res,
+             disp_drv->ver_res, lines);
+    return ESP_OK;
+}
+
+void lvgl_panel_unregister(lcd_panel_t *panel) {
+    if (panel->disp) {
+        lv_disp_remove(panel->disp);
+        panel->disp = NULL;
+    }
+    if (panel->io) {
+        esp_lcd_panel_io_tx_param(panel->io, -1, NULL, 0); // Буферы нельзя освобождать, пока их читает DMA
+    }
+    panel->lvgl_pending = false;
+    panel->on_trans_done = NULL;
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(panel->lvgl_buf[i]);
+        panel->lvgl_buf[i] = NULL;
+    }
+}
+
+void create_hello_world_label(int font_size) {
     ESP_LOGI(TAG, "Creating Hello World label with font size %d...", font_size);
 
     // Очистка текущего экрана от предыдущих объектов
@@ -545,15 +1865,536 @@ static void create_hello_world_label(int font_size) {
     // текст сместится в верхний левый угол, что может быть нежелательно при смене ориентации.
 }
 
+void console_render_line(uint16_t *buf, int width, const char *text) {
+    const lv_font_t *font = CONSOLE_FONT;
+    const uint16_t fg = CONSOLE_FG_COLOR;
+    rgb565_fill(buf, CONSOLE_BG_COLOR, (size_t)width * CONSOLE_LINE_HEIGHT);
+
+    int pen_x = 2; // Отступ от левого края
+    for (const char *p = text; *p && pen_x < width; p++) {
+        uint32_t letter = (uint8_t)*p < 0x80 ? (uint8_t)*p : '?';
+        uint32_t next = (uint8_t)p[1] < 0x80 ? (uint8_t)p[1] : '?';
+        lv_font_glyph_dsc_t dsc;
+        if (!lv_font_get_glyph_dsc(font, &dsc, letter, next)) {
+            continue;
+        }
+        const uint8_t *bitmap = dsc.box_w && dsc.box_h ? lv_font_get_glyph_bitmap(font, letter) : NULL;
+        if (bitmap && dsc.bpp >= 1 && dsc.bpp <= 8) {
+            // Глиф LVGL 8 — непрерывный поток бит по bpp на пиксель, старшие биты первыми
+            const int max_value = (1 << dsc.bpp) - 1;
+            const int top = (font->line_height - font->base_line) - dsc.box_h - dsc.ofs_y;
+            for (int gy = 0; gy < dsc.box_h; gy++) {
+                int y = top + gy;
+                if (y < 0 || y >= CONSOLE_LINE_HEIGHT) {
+                    continue;
+                }
+                for (int gx = 0; gx < dsc.box_w; gx++) {
+                    int x = pen_x + dsc.ofs_x + gx;
+                    if (x < 0 || x >= width) {
+                        continue;
+                    }
+                    uint32_t bit = (uint32_t)(gy * dsc.box_w + gx) * dsc.bpp;
+                    int value = (bitmap[bit >> 3] >> (8 - dsc.bpp - (bit & 7))) & max_value;
+                    if (value) {
+                        rgb565_blend(&buf[y * width + x], &fg, (uint8_t)(value * 255 / max_value), 1);
+                    }
+                }
+            }
+        }
+        pen_x += dsc.adv_w;
+    }
+}
+
+/**
+ * Выводит строку консоли в полосу экрана.
+ * @param band Номер полосы сверху (логические строки band * CONSOLE_LINE_HEIGHT и далее)
+ * @param text Текст строки
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t console_draw_band(int band, const char *text) {
+    // Буфер один: предыдущая полоса могла ещё передаваться через DMA
+    esp_err_t ret = wait_lcd_transfers(&lcd_panel_main);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    size_t pixels = (size_t)console.hor_res * CONSOLE_LINE_HEIGHT;
+    console_render_line(console.line_buf, console.hor_res, text);
+    if (lcd_byte_order == LCD_BYTE_ORDER_RENDERER) {
+        rgb565_copy_swap(console.line_buf, console.line_buf, pixels);
+    }
+    int y = band * CONSOLE_LINE_HEIGHT;
+    console.pixel_bytes += pixels * sizeof(uint16_t);
+    return draw_area(&lcd_panel_main, 0, console.hor_res - 1, y, y + CONSOLE_LINE_HEIGHT - 1, console.line_buf);
+}
+
+/**
+ * Отправляет VSCSAD: строку памяти, которая показывается у верхнего края области прокрутки.
+ * @param line Строка памяти (0..LCD_V_RES-1)
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t console_set_scroll(uint16_t line) {
+    uint8_t vscsad[2] = {line >> 8, line & 0xFF};
+    esp_err_t ret = lcd_tx_param(&lcd_panel_main, 0x37, vscsad, sizeof(vscsad));
+    if (ret == ESP_OK) {
+        console.scroll = line;
+    }
+    return ret;
+}
+
+esp_err_t console_start(void) {
+    if (console.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    console.hw_scroll = !lcd_panel_main.orient->landscape;
+    console.hor_res = lcd_panel_main.orient->hor_res;
+    console.rows = lcd_panel_main.orient->ver_res / CONSOLE_LINE_HEIGHT;
+    console.lines = 0;
+    console.scroll = 0;
+    console.pixel_bytes = 0;
+    console.redraws = 0;
+    console.line_buf = heap_caps_malloc((size_t)console.hor_res * CONSOLE_LINE_HEIGHT * sizeof(uint16_t), MALLOC_CAP_DMA);
+    if (!console.line_buf) {
+        ESP_LOGE(TAG, "Failed to allocate console line buffer");
+        return ESP_ERR_NO_MEM;
+    }
+    if (CONSOLE_FONT->line_height > CONSOLE_LINE_HEIGHT) {
+        ESP_LOGW(TAG, "Console font line height %d exceeds %d, glyphs are clipped", CONSOLE_FONT->line_height, CONSOLE_LINE_HEIGHT);
+    }
+
+    esp_err_t ret = clear_screen(&lcd_panel_main, CONSOLE_BG_COLOR);
+    if (ret == ESP_OK && console.hw_scroll) {
+        // Неподвижных строк нет: прокручивается вся память, 320 строк замыкаются в кольцо
+        uint8_t vscrdef[6] = {0, 0, LCD_V_RES >> 8, LCD_V_RES & 0xFF, 0, 0};
+        ret = lcd_tx_param(&lcd_panel_main, 0x33, vscrdef, sizeof(vscrdef));
+        if (ret == ESP_OK) {
+            ret = console_set_scroll(0);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Console start failed: %s", esp_err_to_name(ret));
+        free(console.line_buf);
+        console.line_buf = NULL;
+        return ret;
+    }
+    console.active = true;
+    ESP_LOGI(TAG, "Console started: %d rows x %d px, %s", console.rows, console.hor_res,
+             console.hw_scroll ? "hardware scroll" : "redraw on scroll");
+    return ESP_OK;
+}
+
+esp_err_t console_print(const char *text) {
+    if (!console.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const int slot = console.lines % console.rows;
+    strncpy(console.text[slot], text, CONSOLE_MAX_COLS);
+    console.text[slot][CONSOLE_MAX_COLS] = '\0';
+
+    esp_err_t ret = ESP_OK;
+    if (console.lines < (uint32_t)console.rows) {
+        // Экран ещё не заполнен: строка занимает следующую полосу
+        ret = console_draw_band(slot, console.text[slot]);
+    } else if (console.hw_scroll) {
+        // Сверху должна оказаться строка после новой по кольцу полос. В 180° (MY) логическая строка y
+        // лежит в строке памяти LCD_V_RES-1-y, поэтому сдвиг идёт в обратную сторону
+        uint16_t top = ((console.lines + 1) % console.rows) * CONSOLE_LINE_HEIGHT;
+        if (lcd_panel_main.orient->mirror_rows) {
+            top = (LCD_V_RES - top) % LCD_V_RES;
+        }
+        // Сначала полоса, потом сдвиг: иначе на открывшемся внизу месте до окончания записи видна самая старая строка
+        ret = console_draw_band(slot, console.text[slot]);
+        if (ret == ESP_OK) {
+            ret = wait_lcd_transfers(&lcd_panel_main);
+        }
+#if LCD_TE_SYNC
+        if (ret == ESP_OK) {
+            lcd_te_wait(); // Сдвиг в начале гашения, а не посреди развёртки; без импульса — сразу
+        }
+#endif
+        if (ret == ESP_OK) {
+            ret = console_set_scroll(top);
+        }
+    } else {
+        // Старые строки сдвигаются вверх перерисовкой: от самой старой до новой
+        for (int band = 0; band < console.rows && ret == ESP_OK; band++) {
+            ret = console_draw_band(band, console.text[(console.lines + 1 + band) % console.rows]);
+        }
+        console.redraws++;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Console print failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    console.lines++;
+    return ESP_OK;
+}
+
+esp_err_t console_stop(void) {
+    if (!console.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = wait_lcd_transfers(&lcd_panel_main);
+    if (ret == ESP_OK && console.hw_scroll) {
+        ret = console_set_scroll(0);
+        if (ret == ESP_OK) {
+            // NORON вышел бы и из частичного показа, а lcd_power.partial остался бы true
+            ret = lcd_tx_param(&lcd_panel_main, lcd_power.partial ? 0x12 : 0x13, NULL, 0); // PTLON/NORON
+        }
+    }
+    ESP_LOGI(TAG, "Console stopped: %" PRIu32 " lines, %" PRIu64 " pixel bytes, %" PRIu32 " full redraws",
+             console.lines, console.pixel_bytes, console.redraws);
+    free(console.line_buf);
+    console.line_buf = NULL;
+    console.active = false;
+    lv_obj_invalidate(lv_scr_act());
+    return ret;
+}
+
+#if CONSOLE_DEMO || CONFIG_IDF_TARGET_LINUX
+void console_demo_text(char *buf, size_t size, uint32_t n) {
+    snprintf(buf, size, "[%04" PRIu32 "] log %.*s", n, (int)(n % 13), "abcdefghijklm");
+}
+#endif
+
+#if CONSOLE_DEMO
+/**
+ * Демонстрация консоли: в каждой ориентации выводится CONSOLE_DEMO_LINES строк лога.
+ * Вызывается под lvgl_lock.
+ */
+static void run_console_demo(void) {
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    char text[CONSOLE_MAX_COLS + 1];
+    for (int o = DISPLAY_ORIENTATION_0; o <= DISPLAY_ORIENTATION_270; o++) {
+        if (set_display_orientation(&lcd_panel_main, (display_orientation_t)o) != ESP_OK || console_start() != ESP_OK) {
+            continue;
+        }
+        int64_t start_us = esp_timer_get_time();
+        for (uint32_t n = 0; n < CONSOLE_DEMO_LINES; n++) {
+            console_demo_text(text, sizeof(text), n);
+            console_print(text);
+            vTaskDelay(pdMS_TO_TICKS(50 / DEMO_PAUSE_DIV));
+        }
+        wait_lcd_transfers(&lcd_panel_main);
+        ESP_LOGI(TAG, "Console demo %d deg: %d lines in %" PRId64 " ms", o * 90, CONSOLE_DEMO_LINES,
+                 (esp_timer_get_time() - start_us) / 1000);
+        console_stop();
+    }
+    set_display_orientation(&lcd_panel_main, saved_orientation);
+}
+#endif
+
+#if LCD_PCLK_SWEEP || CONFIG_IDF_TARGET_LINUX
+
+/**
+ * CRC32 сплошного кадра одного цвета, как его передаёт fill_area (для сверки без чтения из панели).
+ * @param crc Начальное значение CRC (продолжение предыдущих данных)
+ * @param color Цвет в формате RGB565 в том порядке байт, который нужно просуммировать
+ * @param pixels Количество пикселей
+ * @return CRC32 после добавления кадра
+ */
+static uint32_t solid_frame_crc(uint32_t crc, uint16_t color, size_t pixels) {
+    uint16_t chunk[64];
+    rgb565_fill(chunk, color, sizeof(chunk) / sizeof(chunk[0]));
+    while (pixels > 0) {
+        size_t n = MIN(pixels, sizeof(chunk) / sizeof(chunk[0]));
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)chunk, n * sizeof(uint16_t));
+        pixels -= n;
+    }
+    return crc;
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * CRC32 кадра в порядке байт CPU — так её считает эмулятор по принятым пикселям (data_crc).
+ * При LCD_BYTE_ORDER_RENDERER кадр хранится в порядке шины и переставляется по кускам.
+ * @param crc Начальное значение CRC
+ * @param frame Кадр в порядке байт буфера
+ * @param pixels Количество пикселей
+ * @return CRC32 после добавления кадра
+ */
+static uint32_t frame_pixel_crc(uint32_t crc, const uint16_t *frame, size_t pixels) {
+    if (lcd_byte_order != LCD_BYTE_ORDER_RENDERER) {
+        return esp_rom_crc32_le(crc, (const uint8_t *)frame, pixels * sizeof(uint16_t));
+    }
+    uint16_t chunk[64];
+    while (pixels > 0) {
+        size_t n = MIN(pixels, sizeof(chunk) / sizeof(chunk[0]));
+        rgb565_copy_swap(chunk, frame, n);
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)chunk, n * sizeof(uint16_t));
+        frame += n;
+        pixels -= n;
+    }
+    return crc;
+}
+#endif
+
+/**
+ * Передаёт полнокадровую последовательность test_fill_screen без пауз и логов:
+ * пять заливок цветом и кадр с полосами по краям, затем дожидается окончания DMA.
+ * @param strips Заранее подготовленный кадр с полосами (fill_edge_strips)
+ * @param hor_res Ширина кадра в текущей ориентации
+ * @param ver_res Высота кадра в текущей ориентации
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t push_fill_test(const uint16_t *strips, int hor_res, int ver_res) {
+    static const uint16_t colors[] = {0xF800, 0x001F, 0x07E0, 0x0000, 0xFFFF}; // Как в test_fill_screen
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < sizeof(colors) / sizeof(colors[0]) && ret == ESP_OK; i++) {
+        ret = fill_area(&lcd_panel_main, 0, hor_res - 1, 0, ver_res - 1, colors[i]);
+    }
+    if (ret == ESP_OK) {
+        ret = draw_area(&lcd_panel_main, 0, hor_res - 1, 0, ver_res - 1, strips);
+    }
+    wait_lcd_transfers(&lcd_panel_main);
+    return ret;
+}
+
+/**
+ * Замер пропускной способности на разных частотах пиксельного тактирования.
+ * Для каждой частоты из LCD_PCLK_SWEEP_HZ интерфейс i80 пересоздаётся, затем замеряется
+ * время полнокадровой заливки и последовательности test_fill_screen (пять заливок и кадр с полосами).
+ * CRC32 поставленных в очередь данных (push CRC) сравнивается с эталонной, посчитанной напрямую по цветам и кадру.
+ * Она подтверждает только то, что отправлено: драйвер i80 esp_lcd умеет только писать, и на устройстве
+ * искажения на высокой частоте этой проверкой не видны, устойчивость частоты оценивается по изображению.
+ * На хосте панель читается: CRC пикселей, принятых эмулятором, и CRC памяти стекла после последнего кадра
+ * сверяются с эталонами, построенными независимо от пути передачи. В конце выводится таблица
+ * и восстанавливается LCD_PIXEL_CLOCK_HZ.
+ * @return Количество частот, на которых передача или сверка не прошли, плюс ошибки восстановления
+ */
+static int run_pclk_sweep(void) {
+    static const uint32_t pclk_list[] = LCD_PCLK_SWEEP_HZ;
+    const size_t steps = sizeof(pclk_list) / sizeof(pclk_list[0]);
+    const int hor_res = lcd_panel_main.orient->hor_res;
+    const int ver_res = lcd_panel_main.orient->ver_res;
+    const size_t frame_pixels = (size_t)hor_res * ver_res;
+    const size_t frame_bytes = frame_pixels * sizeof(uint16_t);
+    static const uint16_t clear_colors[] = {0x0000, 0xFFFF}; // Заливки чередуются, как при перерисовке экрана
+
+    // Результаты одной частоты
+    struct {
+        int64_t clear_us;       // Среднее время полнокадровой заливки
+        int64_t fill_test_us;   // Среднее время последовательности test_fill_screen
+        int64_t model_us;       // Время шины по модели эмулятора (только хост)
+        uint32_t crc;           // CRC поставленных в очередь данных (push CRC)
+        bool ok;                // Передача без ошибок, push CRC (и на хосте прочитанное из эмулятора) совпали с эталоном
+    } results[sizeof(pclk_list) / sizeof(pclk_list[0])] = {0};
+
+    uint16_t *strips = heap_caps_malloc(frame_bytes, MALLOC_CAP_DMA);
+    if (!strips) {
+        ESP_LOGE(TAG, "Failed to allocate buffer for pixel clock sweep");
+        return 1;
+    }
+    fill_edge_strips(strips, hor_res, ver_res);
+
+    // Эталонная CRC последовательности считается напрямую, минуя путь передачи
+    static const uint16_t test_colors[] = {0xF800, 0x001F, 0x07E0, 0x0000, 0xFFFF};
+    uint32_t expected_crc = 0;
+    for (size_t i = 0; i < sizeof(test_colors) / sizeof(test_colors[0]); i++) {
+        expected_crc = solid_frame_crc(expected_crc, lcd_buffer_color(test_colors[i]), frame_pixels);
+    }
+    expected_crc = esp_rom_crc32_le(expected_crc, (const uint8_t *)strips, frame_bytes);
+#if CONFIG_IDF_TARGET_LINUX
+    // Эмулятор считает CRC по декодированным пикселям, то есть в порядке CPU при любой политике
+    uint32_t expected_pixel_crc = 0;
+    for (size_t i = 0; i < sizeof(test_colors) / sizeof(test_colors[0]); i++) {
+        expected_pixel_crc = solid_frame_crc(expected_pixel_crc, test_colors[i], frame_pixels);
+    }
+    expected_pixel_crc = frame_pixel_crc(expected_pixel_crc, strips, frame_pixels);
+
+    // Память стекла после последнего кадра: кадр с полосами, разложенный по стеклу через таблицу ориентации
+    uint16_t *glass = heap_caps_malloc(frame_bytes, MALLOC_CAP_DEFAULT);
+    if (!glass) {
+        free(strips);
+        return 1;
+    }
+    for (int ly = 0; ly < ver_res; ly++) {
+        for (int lx = 0; lx < hor_res; lx++) {
+            int gx, gy;
+            lcd_orientation_to_glass(lcd_panel_main.orient, lx, ly, &gx, &gy);
+            glass[gy * LCD_H_RES + gx] = lcd_buffer_color(strips[ly * hor_res + lx]);
+        }
+    }
+    uint32_t expected_glass_crc = esp_rom_crc32_le(0, (const uint8_t *)glass, frame_bytes);
+    free(glass);
+#endif
+
+    ESP_LOGI(TAG, "Pixel clock sweep: %d steps, %d frames each, reference CRC 0x%08" PRIX32,
+             (int)steps, LCD_PCLK_SWEEP_FRAMES, expected_crc);
+    for (size_t i = 0; i < steps; i++) {
+        esp_err_t ret = set_pixel_clock(pclk_list[i]);
+        if (ret != ESP_OK) {
+            continue;
+        }
+
+        // Полнокадровая заливка
+        int64_t start_us = esp_timer_get_time();
+        for (int f = 0; f < LCD_PCLK_SWEEP_FRAMES && ret == ESP_OK; f++) {
+            ret = fill_area(&lcd_panel_main, 0, hor_res - 1, 0, ver_res - 1, clear_colors[f % 2]);
+        }
+        wait_lcd_transfers(&lcd_panel_main);
+        results[i].clear_us = (esp_timer_get_time() - start_us) / LCD_PCLK_SWEEP_FRAMES;
+
+        // Последовательность test_fill_screen
+        start_us = esp_timer_get_time();
+        for (int f = 0; f < LCD_PCLK_SWEEP_FRAMES && ret == ESP_OK; f++) {
+            ret = push_fill_test(strips, hor_res, ver_res);
+        }
+        results[i].fill_test_us = (esp_timer_get_time() - start_us) / LCD_PCLK_SWEEP_FRAMES;
+
+        // Проверочный проход с подсчётом CRC (отдельно, чтобы не влиять на замер времени)
+#if CONFIG_IDF_TARGET_LINUX
+        st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+        st7789_emu_reset_stats(emu);
+#endif
+        push_crc = 0;
+        push_crc_enabled = true;
+        if (ret == ESP_OK) {
+            ret = push_fill_test(strips, hor_res, ver_res);
+        }
+        push_crc_enabled = false;
+        results[i].crc = push_crc;
+        results[i].ok = ret == ESP_OK && push_crc == expected_crc;
+#if CONFIG_IDF_TARGET_LINUX
+        st7789_emu_stats_t emu_stats;
+        st7789_emu_get_stats(emu, &emu_stats);
+        results[i].model_us = emu_stats.bus_time_ns / 1000;
+        if (emu_stats.data_crc != expected_pixel_crc) {
+            ESP_LOGE(TAG, "Emulator received CRC 0x%08" PRIX32 " at %" PRIu32 " Hz, expected 0x%08" PRIX32,
+                     emu_stats.data_crc, pclk_list[i], expected_pixel_crc);
+            results[i].ok = false;
+        }
+        uint32_t glass_crc = esp_rom_crc32_le(0, (const uint8_t *)st7789_emu_framebuffer(emu), frame_bytes);
+        if (glass_crc != expected_glass_crc) {
+            ESP_LOGE(TAG, "Panel memory CRC 0x%08" PRIX32 " at %" PRIu32 " Hz, expected 0x%08" PRIX32,
+                     glass_crc, pclk_list[i], expected_glass_crc);
+            results[i].ok = false;
+        }
+#endif
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Sweep step %" PRIu32 " Hz failed: %s", pclk_list[i], esp_err_to_name(ret));
+        }
+    }
+
+    int failures = 0;
+    if (set_pixel_clock(LCD_PIXEL_CLOCK_HZ) != ESP_OK) {
+        failures++;
+    }
+    free(strips);
+#if CONFIG_IDF_TARGET_LINUX
+    // Дескриптор панели пересоздан вместе с интерфейсом: прежний под AddressSanitizer здесь бы упал
+    if (esp_lcd_panel_disp_on_off(lcd_panel_main.panel, true) != ESP_OK) {
+        ESP_LOGE(TAG, "Panel handle is unusable after the pixel clock change");
+        failures++;
+    }
+#endif
+
+    // Таблица: MB/s = байт / мкс; эффективность — доля теоретической скорости 8-битной шины (1 байт за такт)
+    ESP_LOGI(TAG, "pclk MHz | clear us | clear MB/s | bus eff %% | fill test us | fill test MB/s | model us | push CRC");
+    for (size_t i = 0; i < steps; i++) {
+        double pclk_mhz = pclk_list[i] / 1e6;
+        double clear_mbps = results[i].clear_us ? (double)frame_bytes / results[i].clear_us : 0;
+        double fill_test_mbps = results[i].fill_test_us ? 6.0 * frame_bytes / results[i].fill_test_us : 0;
+        ESP_LOGI(TAG, "%8.2f | %8" PRId64 " | %10.2f | %9.1f | %12" PRId64 " | %14.2f | %8" PRId64 " | 0x%08" PRIX32 " %s",
+                 pclk_mhz, results[i].clear_us, clear_mbps, 100.0 * clear_mbps / pclk_mhz,
+                 results[i].fill_test_us, fill_test_mbps, results[i].model_us, results[i].crc,
+                 results[i].ok ? "OK" : "FAIL");
+        if (!results[i].ok) {
+            failures++;
+        }
+    }
+    ESP_LOGI(TAG, "Pixel clock sweep: %d failure(s)", failures);
+    return failures;
+}
+#endif
+
+#if RGB565_BENCHMARK || CONFIG_IDF_TARGET_LINUX
+/**
+ * Замер времени CPU, которое стоила бы программная перестановка байтов кадра 320x170 в flush_cb
+ * (попиксельно и ядром rgb565_copy_swap). При политиках DMA и panel это время не тратится совсем,
+ * при LVGL перестановка встроена в рендеринг, а сырые заливки переставляют один цвет.
+ */
+static void run_byte_order_benchmark(void) {
+    const size_t pixels = (size_t)LCD_H_RES * LCD_V_RES;
+    const int rounds = 10;
+    uint16_t *frame = heap_caps_malloc(pixels * sizeof(uint16_t), MALLOC_CAP_DMA);
+    if (!frame) {
+        ESP_LOGE(TAG, "Failed to allocate byte-order benchmark frame");
+        return;
+    }
+    rgb565_fill(frame, 0x1234, pixels);
+
+    // Попиксельная перестановка, как в flush_cb без аппаратной поддержки
+    int64_t start_us = esp_timer_get_time();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < pixels; i++) {
+            frame[i] = (uint16_t)((frame[i] << 8) | (frame[i] >> 8));
+        }
+    }
+    int64_t per_pixel_us = (esp_timer_get_time() - start_us) / rounds;
+
+    start_us = esp_timer_get_time();
+    for (int r = 0; r < rounds; r++) {
+        rgb565_copy_swap(frame, frame, pixels);
+    }
+    int64_t kernel_us = (esp_timer_get_time() - start_us) / rounds;
+    free(frame);
+
+#ifdef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+    ESP_LOGI(TAG, "Software swap of a %dx%d frame: %" PRId64 " us (%" PRId64 " cycles) per-pixel, %" PRId64 " us (%" PRId64
+             " cycles) rgb565_copy_swap", LCD_V_RES, LCD_H_RES, per_pixel_us, per_pixel_us * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+             kernel_us, kernel_us * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#else
+    ESP_LOGI(TAG, "Software swap of a %dx%d frame: %" PRId64 " us per-pixel, %" PRId64 " us rgb565_copy_swap",
+             LCD_V_RES, LCD_H_RES, per_pixel_us, kernel_us);
+#endif
+    ESP_LOGI(TAG, "Byte order %s: %s", lcd_byte_order_name(lcd_byte_order),
+             lcd_byte_order == LCD_BYTE_ORDER_RENDERER ? "swap is part of LVGL rendering, raw fills swap once per color"
+                                                       : "no CPU time spent on swapping");
+}
+#endif
+
+/**
+ * Включает изображение: Display On и подсветку. При LCD_FAST_BOOT вызывается, когда первый кадр
+ * уже в памяти панели; если с Sleep Out прошло меньше LCD_SLEEP_OUT_MS, дожидается остатка.
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t lcd_display_on(void) {
+    if (lcd_boot.display_on) {
+        return ESP_OK;
+    }
+    esp_err_t ret = wait_lcd_transfers(&lcd_panel_main); // Кадр должен полностью попасть в память панели
+    int64_t remaining_us = lcd_boot.sleep_out_us + LCD_SLEEP_OUT_MS * 1000 - esp_timer_get_time();
+    if (remaining_us > 0) {
+        vTaskDelay(pdMS_TO_TICKS((remaining_us + 999) / 1000) + 1);
+    }
+    if (ret == ESP_OK) {
+        // Через lcd_tx_param, как остальные команды, чтобы Display On попала в счётчики шины
+        ret = lcd_tx_param(&lcd_panel_main, 0x29, NULL, 0); // Display On
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_set_level(LCD_PIN_BK_LIGHT, LCD_BK_LIGHT_ON_LEVEL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to turn display on: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    lcd_boot.display_on = true;
+    lcd_boot.display_on_us = esp_timer_get_time();
+    LCD_BOOT_LOGI("Display on, Sleep Out wait left %" PRId64 " us", MAX(remaining_us, 0));
+    return ESP_OK;
+}
+
 /**
  * Инициализирует дисплей ST7789 с использованием шины i80.
  * Настраивает пины, шину, интерфейс и отправляет команды инициализации.
+ * При LCD_FAST_BOOT подсветка остаётся выключенной, после Sleep Out выдерживается только LCD_SLEEP_OUT_CMD_MS,
+ * Display On и экран откладываются до первого кадра (lcd_display_on), начальная ориентация задаётся без очистки.
  */
 static void init_display(void) {
-    ESP_LOGI(TAG, "Setting up parallel interface...");
+    LCD_BOOT_LOGI("Setting up parallel interface...");
 
     // Конфигурация пина RD (чтение, не используется, но должен быть в высоком состоянии)
-    ESP_LOGI(TAG, "Configuring RD pin...");
+    LCD_BOOT_LOGI("Configuring RD pin...");
     gpio_config_t rd_gpio_config = {
         .pin_bit_mask = 1ULL << LCD_PIN_RD,
         .mode = GPIO_MODE_OUTPUT,
@@ -565,7 +2406,7 @@ static void init_display(void) {
     ESP_ERROR_CHECK(gpio_set_level(LCD_PIN_RD, 1));
 
     // Конфигурация пина подсветки
-    ESP_LOGI(TAG, "Configuring backlight...");
+    LCD_BOOT_LOGI("Configuring backlight...");
     gpio_config_t bk_gpio_config = {
         .pin_bit_mask = 1ULL << LCD_PIN_BK_LIGHT,
         .mode = GPIO_MODE_OUTPUT,
@@ -574,173 +2415,990 @@ static void init_display(void) {
         .intr_type = GPIO_INTR_DISABLE,
     };
     ESP_ERROR_CHECK(gpio_config(&bk_gpio_config));
+#if LCD_FAST_BOOT
+    // Подсветка включается в lcd_display_on, когда в памяти панели уже первый кадр
+    ESP_ERROR_CHECK(gpio_set_level(LCD_PIN_BK_LIGHT, !LCD_BK_LIGHT_ON_LEVEL));
+#else
     ESP_ERROR_CHECK(gpio_set_level(LCD_PIN_BK_LIGHT, LCD_BK_LIGHT_ON_LEVEL));
     vTaskDelay(pdMS_TO_TICKS(100)); // Задержка для стабилизации подсветки
     ESP_LOGI(TAG, "Backlight set to %d", LCD_BK_LIGHT_ON_LEVEL);
+#endif
 
     // Пример влияния: если не включить подсветку (LCD_BK_LIGHT_ON_LEVEL=0),
     // экран останется тёмным, и ничего не будет видно.
 
-    // Инициализация шины i80
-    ESP_LOGI(TAG, "Initializing i80 bus...");
-    esp_lcd_i80_bus_handle_t i80_bus = NULL;
-    esp_lcd_i80_bus_config_t bus_config = {
-        .clk_src = LCD_CLK_SRC_DEFAULT, // Источник тактирования (по умолчанию PLL)
-        .dc_gpio_num = LCD_PIN_DC,      // Пин для Data/Command
-        .wr_gpio_num = LCD_PIN_WR,      // Пин для записи
-        .data_gpio_nums = {
-            LCD_PIN_DATA0, LCD_PIN_DATA1, LCD_PIN_DATA2, LCD_PIN_DATA3,
-            LCD_PIN_DATA4, LCD_PIN_DATA5, LCD_PIN_DATA6, LCD_PIN_DATA7,
-        },
-        .bus_width = 8, // 8-битная шина
-        .max_transfer_bytes = LCD_H_RES * LCD_V_RES * sizeof(uint16_t), // Максимальный размер передачи
-        .psram_trans_align = 64, // Выравнивание для PSRAM
-        .sram_trans_align = 4,   // Выравнивание для SRAM
-    };
-    ESP_ERROR_CHECK(esp_lcd_new_i80_bus(&bus_config, &i80_bus));
-
-    // Инициализация интерфейса i80
-    ESP_LOGI(TAG, "Initializing i80 interface...");
-    esp_lcd_panel_io_i80_config_t io_config = {
-        .cs_gpio_num = LCD_PIN_CS, // Пин Chip Select
-        .pclk_hz = LCD_PIXEL_CLOCK_HZ, // Частота тактирования
-        .trans_queue_depth = 10, // Глубина очереди передачи
-        .dc_levels = {
-            .dc_idle_level = 0,
-            .dc_cmd_level = 0,  // Уровень для команд
-            .dc_dummy_level = 0,
-            .dc_data_level = 1, // Уровень для данных
-        },
-        .flags = {
-            .cs_active_high = 0, // CS активен на низком уровне
-            .reverse_color_bits = 0, // Без инверсии порядка бит
-            .swap_color_bytes = 1,   // Смена байтов для RGB565 (Big Endian)
-            .pclk_active_neg = 0,    // Тактирование на положительном фронте
-        },
-        .lcd_cmd_bits = LCD_CMD_BITS,   // 8 бит для команд
-        .lcd_param_bits = LCD_PARAM_BITS // 8 бит для параметров
-    };
-    ESP_LOGI(TAG, "i80 config: swap_color_bytes=%d, reverse_color_bits=%d", io_config.flags.swap_color_bytes, io_config.flags.reverse_color_bits);
-    ESP_ERROR_CHECK(esp_lcd_new_panel_io_i80(i80_bus, &io_config, &io_handle));
-
-    // Пример влияния: если установить swap_color_bytes=0, цвета будут искажены
-    // (например, красный станет синим из-за неправильного порядка байтов).
-
-    // Инициализация панели ST7789
-    ESP_LOGI(TAG, "Initializing ST7789 panel...");
-    esp_lcd_panel_dev_config_t panel_config = {
-        .reset_gpio_num = LCD_PIN_RST, // Пин сброса
-        .color_space = ESP_LCD_COLOR_SPACE_RGB, // Цветовое пространство RGB
-        .bits_per_pixel = 16, // 16 бит на пиксель (RGB565)
-    };
-    ESP_ERROR_CHECK(esp_lcd_new_panel_st7789(io_handle, &panel_config, &panel_handle));
-
-    // Сброс панели
-    ESP_LOGI(TAG, "Resetting panel...");
-    ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
+    // Шина i80, интерфейс, буфер заливки и сброс панели
+    LCD_BOOT_LOGI("Initializing i80 bus and ST7789 panel...");
+    ESP_ERROR_CHECK(lcd_panel_init(&lcd_panel_main, LCD_PIN_CS, LCD_PIN_RST, LCD_PIXEL_CLOCK_HZ));
+#if !LCD_FAST_BOOT
     vTaskDelay(pdMS_TO_TICKS(100));
+#endif
+
+    // Пример влияния: если байты не переставит ни одно звено (или переставят два), цвета будут искажены:
+    // красный 0xF800 станет 0x00F8 (синим). Чёрный и белый при этом не меняются, поэтому ошибка не видна на заливках 0x0000/0xFFFF.
 
     // Отправка инициализационных команд
-    ESP_LOGI(TAG, "Sending ST7789 init commands...");
-    for (uint8_t i = 0; lcd_st7789v[i].addr != 0 || lcd_st7789v[i].len != 0xff; i++) {
-        ESP_LOGI(TAG, "Sending cmd 0x%02X, len=%d", lcd_st7789v[i].addr, lcd_st7789v[i].len & 0x7f);
-        esp_err_t ret = esp_lcd_panel_io_tx_param(io_handle, lcd_st7789v[i].addr,
-                                                  lcd_st7789v[i].param,
-                                                  lcd_st7789v[i].len & 0x7f);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Cmd 0x%02X failed: %s", lcd_st7789v[i].addr, esp_err_to_name(ret));
-        }
-        if (lcd_st7789v[i].len & 0x80) {
-            vTaskDelay(pdMS_TO_TICKS(120)); // Задержка для команд, требующих времени
-        }
-    }
+    LCD_BOOT_LOGI("Sending ST7789 init commands...");
+    lcd_boot.sleep_out_us = lcd_send_init_commands(&lcd_panel_main, LCD_FAST_BOOT);
+
+    // Порядок байт пикселя на стороне панели (RAMCTRL), согласованный с swap_color_bytes интерфейса
+    LCD_BOOT_LOGI("Byte order: %s", lcd_byte_order_name(lcd_byte_order));
+    ESP_ERROR_CHECK(lcd_send_ramctrl(&lcd_panel_main));
 
+#if !LCD_FAST_BOOT
     // Включение дисплея
     ESP_LOGI(TAG, "Configuring panel...");
-    ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
+    ESP_ERROR_CHECK(lcd_display_on());
+#endif
+
+#if LCD_TE_SYNC
+    // Источник импульсов TE (панель выдаёт их после TEON из lcd_st7789v)
+    ESP_ERROR_CHECK(init_te());
+#endif
 
-    // Установка начальной ориентации
-    ESP_LOGI(TAG, "Setting initial orientation");
-    esp_err_t ret = set_display_orientation(DISPLAY_ORIENTATION_90);
+    // Установка начальной ориентации; при быстром старте без очистки: подсветка выключена,
+    // а первый кадр LVGL перекрывает весь экран
+    LCD_BOOT_LOGI("Setting initial orientation");
+    esp_err_t ret = LCD_FAST_BOOT ? apply_display_orientation(&lcd_panel_main, DISPLAY_ORIENTATION_90)
+                                  : set_display_orientation(&lcd_panel_main, DISPLAY_ORIENTATION_90);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set initial orientation: %s", esp_err_to_name(ret));
     }
+
+#if SPLASH_ENABLE && !CONFIG_IDF_TARGET_LINUX
+    // Заставка из flash; при быстром старте это первый кадр, и изображение включается сразу после неё.
+    // Если образа нет или он повреждён, подсветка ждёт первого кадра LVGL.
+    if (splash_show() == ESP_OK && LCD_FAST_BOOT) {
+        ESP_ERROR_CHECK(lcd_display_on());
+    }
+#endif
+}
+
+esp_err_t lcd_panel_start(lcd_panel_t *panel, int cs_gpio, display_orientation_t orientation) {
+    esp_err_t ret = lcd_panel_init(panel, cs_gpio, -1, lcd_panel_main.pclk_hz);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    int64_t sleep_out_us = lcd_send_init_commands(panel, LCD_FAST_BOOT);
+    ret = lcd_send_ramctrl(panel);
+    if (ret == ESP_OK) {
+        ret = set_display_orientation(panel, orientation);
+    }
+    if (ret == ESP_OK) {
+        // Очистка уже в очереди; Display On — не раньше LCD_SLEEP_OUT_MS после Sleep Out
+        int64_t remaining_us = sleep_out_us + LCD_SLEEP_OUT_MS * 1000 - esp_timer_get_time();
+        if (remaining_us > 0) {
+            vTaskDelay(pdMS_TO_TICKS((remaining_us + 999) / 1000) + 1);
+        }
+        ret = lcd_tx_param(panel, 0x29, NULL, 0); // Display On
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start panel on CS %d: %s", cs_gpio, esp_err_to_name(ret));
+        lcd_panel_deinit(panel);
+        return ret;
+    }
+    ESP_LOGI(TAG, "Panel on CS %d started: %d deg, queue share %d of %d, %d panel(s) on the bus", cs_gpio,
+             orientation * 90, lcd_bus_share(), LCD_TRANS_QUEUE_DEPTH, lcd_bus.users);
+    return ESP_OK;
+}
+
+bool lvgl_lock(int timeout_ms) {
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTakeRecursive(lvgl_render.mutex, ticks) == pdTRUE;
+}
+
+void lvgl_unlock(void) {
+    xSemaphoreGiveRecursive(lvgl_render.mutex);
+}
+
+void lcd_power_estimate(const lcd_power_mode_t *mode, lcd_power_estimate_t *estimate) {
+    uint32_t rtna = mode->frctrl2 & 0x1F;
+    estimate->frame_mhz = (uint32_t)(LCD_PANEL_OSC_HZ * 1000ULL / ((LCD_V_RES + LCD_PORCH_LINES) * (250 + rtna * 16)));
+    estimate->active_lines = mode->partial ? mode->partial_end - mode->partial_start + 1 : LCD_V_RES;
+    estimate->update_bytes = (uint32_t)estimate->active_lines * LCD_H_RES * sizeof(uint16_t);
+    estimate->update_us = (uint32_t)((uint64_t)estimate->update_bytes * 1000000 / lcd_panel_main.pclk_hz); // 8-битная шина: байт за такт
+
+    // Развёртка пропорциональна частоте кадров и числу строк; в 8 цветах выходы источников работают как ключи
+    uint64_t scan_uw = (uint64_t)LCD_POWER_SCAN_UW * estimate->frame_mhz * estimate->active_lines / (60000ULL * LCD_V_RES);
+    if (mode->idle) {
+        scan_uw = scan_uw * LCD_POWER_IDLE_PERCENT / 100;
+    }
+    estimate->panel_uw = LCD_POWER_LOGIC_UW + (uint32_t)scan_uw;
+    estimate->bus_uw = (uint32_t)((uint64_t)LCD_POWER_BUS_UW_PER_MBPS * estimate->update_bytes * LCD_POWER_CHECK_UPDATES_HZ / 1000000);
+}
+
+esp_err_t lcd_set_power_mode(const lcd_power_mode_t *mode) {
+    if (mode->partial && (mode->partial_start < 0 || mode->partial_end >= LCD_V_RES || mode->partial_start > mode->partial_end)) {
+        ESP_LOGE(TAG, "Invalid partial area %d-%d", mode->partial_start, mode->partial_end);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Панель и состояние LVGL меняются между кадрами: задача рендеринга стоит на блокировке
+    lvgl_lock(-1);
+    const lcd_power_mode_t prev = lcd_power;
+    esp_err_t ret = wait_lcd_transfers(&lcd_panel_main);
+    if (ret == ESP_OK && mode->frctrl2 != prev.frctrl2) {
+        ret = lcd_tx_param(&lcd_panel_main, 0xC6, &mode->frctrl2, 1); // FRCTRL2
+    }
+    if (ret == ESP_OK && mode->partial) {
+        lcd_power.partial_start = mode->partial_start;
+        lcd_power.partial_end = mode->partial_end;
+        ret = lcd_send_ptlar(&lcd_panel_main);
+        if (ret == ESP_OK && !prev.partial) {
+            ret = lcd_tx_param(&lcd_panel_main, 0x12, NULL, 0); // PTLON
+        }
+    } else if (ret == ESP_OK && prev.partial) {
+        ret = lcd_tx_param(&lcd_panel_main, 0x13, NULL, 0); // NORON
+    }
+    if (ret == ESP_OK && mode->idle != prev.idle) {
+        ret = lcd_tx_param(&lcd_panel_main, mode->idle ? 0x39 : 0x38, NULL, 0); // IDMON/IDMOFF
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set power mode: %s", esp_err_to_name(ret));
+        lvgl_unlock();
+        return ret;
+    }
+    lcd_power = *mode;
+
+    // Скрытые строки не перерисовывались: после выхода из частичного показа или смены полосы нужен полный кадр
+    if (lvgl_disp && prev.partial &&
+        (!mode->partial || mode->partial_start != prev.partial_start || mode->partial_end != prev.partial_end)) {
+        lv_obj_invalidate(lv_scr_act());
+    }
+
+    lcd_power_estimate_t estimate;
+    lcd_power_estimate(mode, &estimate);
+#if LCD_TE_SYNC
+    if (mode->frctrl2 != prev.frctrl2) {
+        lcd_te_set_period(1000000000LL / estimate.frame_mhz);
+    }
+#endif
+    lvgl_unlock();
+    ESP_LOGI(TAG, "Power mode: partial=%d (%d-%d), idle=%d, FRCTRL2=0x%02X: %" PRIu32 ".%03" PRIu32 " Hz, %d lines, "
+             "update %" PRIu32 " bytes / %" PRIu32 " us, panel ~%" PRIu32 " uW, bus ~%" PRIu32 " uW",
+             mode->partial, mode->partial_start, mode->partial_end, mode->idle, mode->frctrl2,
+             estimate.frame_mhz / 1000, estimate.frame_mhz % 1000, estimate.active_lines,
+             estimate.update_bytes, estimate.update_us, estimate.panel_uw, estimate.bus_uw);
+    return ESP_OK;
+}
+
+/**
+ * Передаёт обновление интерфейса задаче рендеринга. fn выполняется в задаче рендеринга
+ * под блокировкой LVGL, после чего кадр выводится сразу, не дожидаясь периода обновления LVGL.
+ * Можно вызывать из любой задачи.
+ * @param fn Функция обновления интерфейса
+ * @param arg Аргумент fn
+ * @return ESP_OK при успехе, ESP_ERR_TIMEOUT если очередь заполнена
+ */
+static esp_err_t lvgl_post(lvgl_ui_fn_t fn, void *arg) {
+    lvgl_ui_msg_t msg = {
+        .fn = fn,
+        .arg = arg,
+        .post_us = esp_timer_get_time(),
+    };
+    if (xQueueSend(lvgl_render.queue, &msg, pdMS_TO_TICKS(LVGL_FLUSH_WAIT_MS)) != pdTRUE) {
+        lvgl_render.posts_dropped++;
+        ESP_LOGW(TAG, "LVGL update queue full, update dropped");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+#if LCD_POWER_DEMO || CONFIG_IDF_TARGET_LINUX
+const lcd_power_preset_t lcd_power_presets[LCD_POWER_PRESETS] = {
+    {"normal", DISPLAY_ORIENTATION_0, {.frctrl2 = LCD_FRCTRL2_DEFAULT}},
+    {"low rate", DISPLAY_ORIENTATION_0, {.frctrl2 = LCD_FRCTRL2_MIN_RATE}},
+    {"status bar", DISPLAY_ORIENTATION_0, {.partial = true, .partial_start = 0, .partial_end = 39, .idle = true, .frctrl2 = LCD_FRCTRL2_MIN_RATE}},
+    {"status bar", DISPLAY_ORIENTATION_180, {.partial = true, .partial_start = 0, .partial_end = 39, .idle = true, .frctrl2 = LCD_FRCTRL2_MIN_RATE}},
+    {"band", DISPLAY_ORIENTATION_90, {.partial = true, .partial_start = 100, .partial_end = 219, .frctrl2 = LCD_FRCTRL2_DEFAULT}},
+    {"idle band", DISPLAY_ORIENTATION_270, {.partial = true, .partial_start = 100, .partial_end = 219, .idle = true, .frctrl2 = LCD_FRCTRL2_DEFAULT}},
+};
+#endif
+
+#if LCD_ROTATION_BENCHMARK || CONFIG_IDF_TARGET_LINUX
+/**
+ * Сравнивает способы поворота в 90° на нескольких высотах буфера LVGL (внутренняя память):
+ * для каждого способа экран перерисовывается целиком LCD_ROTATION_BENCH_FRAMES раз, в лог выводятся
+ * время кадра до последнего пикселя, время DMA и CPU на поворот за кадр и байты пикселей за кадр.
+ * Раскладки, для которых не хватило памяти, пропускаются.
+ * Вызывается до запуска задачи рендеринга; затем восстанавливаются раскладка буферов, способ поворота и ориентация.
+ */
+static void run_rotation_benchmark(void) {
+    static const int bench_lines[] = LCD_ROTATION_BENCH_LINES;
+    const lvgl_buf_placement_t saved_placement = lvgl_buffers_get_layout()->placement;
+    const int saved_lines = lvgl_buffers_get_layout()->lines;
+    const lcd_rotation_mode_t saved_mode = lcd_rotation_mode;
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    int64_t latency_us;
+    uint64_t bytes;
+
+    ESP_LOGI(TAG, "Rotation benchmark at 90 deg, %d frames per run", LCD_ROTATION_BENCH_FRAMES);
+    ESP_LOGI(TAG, "lines | mode     | frame us | DMA us | rotate us | bytes/frame");
+    for (size_t i = 0; i < sizeof(bench_lines) / sizeof(bench_lines[0]); i++) {
+        for (int m = LCD_ROTATION_MADCTL; m <= LCD_ROTATION_SOFTWARE; m++) {
+            const lcd_rotation_mode_t mode = (lcd_rotation_mode_t)m;
+            if (lcd_set_rotation_mode(mode) != ESP_OK ||
+                lvgl_buffers_configure(LVGL_BUF_INTERNAL_DMA, bench_lines[i]) != ESP_OK ||
+                rotate_display_measured(DISPLAY_ORIENTATION_90, &latency_us, &bytes) != ESP_OK) {
+                ESP_LOGW(TAG, "%5d | %-8s | skipped (no memory)", bench_lines[i], lcd_rotation_mode_name(mode));
+                continue;
+            }
+
+            uint64_t rotate_cycles = lcd_panel_main.rotate.cycles;
+            int64_t xfer_us = flush_stats.xfer_us;
+            uint64_t color_bytes = bus_stats.color_bytes;
+            int64_t start_us = esp_timer_get_time();
+            for (int f = 0; f < LCD_ROTATION_BENCH_FRAMES; f++) {
+                lv_obj_invalidate(lv_scr_act());
+                lvgl_refr_now();
+                wait_lcd_transfers(&lcd_panel_main);
+            }
+            int64_t frame_us = (esp_timer_get_time() - start_us) / LCD_ROTATION_BENCH_FRAMES;
+            ESP_LOGI(TAG, "%5d | %-8s | %8" PRId64 " | %6" PRId64 " | %9" PRIu64 " | %" PRIu64,
+                     bench_lines[i], lcd_rotation_mode_name(mode), frame_us,
+                     (flush_stats.xfer_us - xfer_us) / LCD_ROTATION_BENCH_FRAMES,
+                     (lcd_panel_main.rotate.cycles - rotate_cycles) / LCD_PERF_CPU_MHZ / LCD_ROTATION_BENCH_FRAMES,
+                     (bus_stats.color_bytes - color_bytes) / LCD_ROTATION_BENCH_FRAMES);
+        }
+    }
+
+    if (lcd_set_rotation_mode(saved_mode) != ESP_OK || lvgl_buffers_configure(saved_placement, saved_lines) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to restore rotation mode and LVGL buffers");
+    }
+    rotate_display_measured(saved_orientation, &latency_us, &bytes);
+}
+#endif
+
+#if LCD_POWER_DEMO
+/**
+ * Демонстрация режимов пониженного потребления: каждый режим из lcd_power_presets показывается
+ * LCD_POWER_DEMO_MS поверх текущего экрана LVGL, затем панель возвращается в обычный режим.
+ */
+static void run_power_mode_demo(void) {
+    const display_orientation_t saved_orientation = lcd_panel_main.orientation;
+    for (size_t p = 0; p < sizeof(lcd_power_presets) / sizeof(lcd_power_presets[0]); p++) {
+        ESP_LOGI(TAG, "Power mode demo: %s", lcd_power_presets[p].name);
+        lvgl_lock(-1);
+        esp_err_t ret = set_display_orientation(&lcd_panel_main, lcd_power_presets[p].orientation);
+        lvgl_unlock();
+        if (ret != ESP_OK || lcd_set_power_mode(&lcd_power_presets[p].mode) != ESP_OK) {
+            continue;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LCD_POWER_DEMO_MS / DEMO_PAUSE_DIV));
+    }
+    const lcd_power_mode_t normal = {.frctrl2 = LCD_FRCTRL2_DEFAULT};
+    lcd_set_power_mode(&normal);
+    lvgl_lock(-1);
+    set_display_orientation(&lcd_panel_main, saved_orientation);
+    lvgl_unlock();
+}
+#endif
+
+/**
+ * Задача рендеринга LVGL. Спит ровно столько, сколько вернул lv_timer_handler
+ * (до ближайшего таймера LVGL), либо до прихода обновления через lvgl_post.
+ * Обновления из очереди выполняются пачкой, затем кадр выводится немедленно (lvgl_refr_now).
+ * @param arg Не используется
+ */
+static void lvgl_render_task(void *arg) {
+    TickType_t sleep_ticks = 0;
+    while (1) {
+        lvgl_ui_msg_t msg;
+        bool posted = xQueueReceive(lvgl_render.queue, &msg, sleep_ticks) == pdTRUE;
+
+        lvgl_lock(-1);
+        if (posted) {
+            lvgl_render.wakeups_post++;
+            int64_t oldest_post_us = msg.post_us;
+            do {
+                msg.fn(msg.arg);
+                lvgl_render.posts++;
+            } while (xQueueReceive(lvgl_render.queue, &msg, 0) == pdTRUE);
+
+            // Кадр с обновлением выводится сразу; задержка считается до постановки последней области в очередь DMA
+            lvgl_refr_now();
+            int64_t latency = esp_timer_get_time() - oldest_post_us;
+            lvgl_render.post_latency_sum_us += latency;
+            if (latency > lvgl_render.post_latency_max_us) {
+                lvgl_render.post_latency_max_us = latency;
+            }
+        } else {
+            lvgl_render.wakeups_timer++;
+        }
+        LCD_TRACE_EVENT(LCD_TRACE_TIMER_BEGIN, 0, 0, 0);
+        uint32_t sleep_ms = lv_timer_handler();
+        LCD_TRACE_EVENT(LCD_TRACE_TIMER_END, 0, sleep_ms, 0);
+        lvgl_unlock();
+
+        // Не меньше одного тика, чтобы задача не занимала ядро целиком, если таймер LVGL уже готов
+        sleep_ms = MIN(sleep_ms, LVGL_TASK_MAX_SLEEP_MS);
+        sleep_ticks = MAX(pdMS_TO_TICKS(sleep_ms), 1);
+        lvgl_render.sleep_ms += sleep_ticks * portTICK_PERIOD_MS;
+        ESP_LOGD(TAG, "LVGL timer handler: next in %" PRIu32 " ms, free heap: %" PRIu32, sleep_ms, esp_get_free_heap_size());
+    }
+}
+
+/**
+ * Запускает задачу рендеринга LVGL на ядре LVGL_TASK_CORE.
+ * После запуска LVGL вызывается только из этой задачи или под lvgl_lock.
+ * @return ESP_OK при успехе, ESP_ERR_NO_MEM если задачу не удалось создать
+ */
+static esp_err_t start_lvgl_render_task(void) {
+    if (xTaskCreatePinnedToCore(lvgl_render_task, "lvgl_render", LVGL_TASK_STACK, NULL, LVGL_TASK_PRIORITY,
+                                &lvgl_render.task, LVGL_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create LVGL render task");
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "LVGL render task started on core %d, priority %d", LVGL_TASK_CORE, LVGL_TASK_PRIORITY);
+    return ESP_OK;
+}
+
+#if LCD_TRACE
+/**
+ * Отправляет пакет трассы: на устройстве в USB-Serial-JTAG, на хосте в файл LCD_TRACE_FILE.
+ * Если приёмник не успевает, пакет теряется (пропуск номера виден декодеру), а вывод не ждёт.
+ * @param packet Пакет
+ * @param size Размер пакета в байтах
+ */
+static void lcd_trace_write(const uint8_t *packet, size_t size) {
+#if CONFIG_IDF_TARGET_LINUX
+    fwrite(packet, 1, size, lcd_trace_file);
+    fflush(lcd_trace_file);
+#else
+    usb_serial_jtag_write_bytes(packet, size, pdMS_TO_TICKS(LCD_TRACE_PERIOD_MS));
+#endif
+}
+
+/**
+ * Задача выгрузки трассы: раз в LCD_TRACE_PERIOD_MS собирает из кольца пакеты по LCD_TRACE_PACKET_EVENTS
+ * событий и отправляет их, раз в LCD_TRACE_HEAP_MS добавляет событие кучи.
+ * @param arg Не используется
+ */
+static void lcd_trace_task(void *arg) {
+    static uint8_t packet[LCD_TRACE_PACKET_BYTES];
+    uint32_t seq = 0;
+    int64_t heap_us = 0;
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        if (now - heap_us >= LCD_TRACE_HEAP_MS * 1000) {
+            heap_us = now;
+            LCD_TRACE_EVENT(LCD_TRACE_HEAP, 0, esp_get_free_heap_size(), esp_get_minimum_free_heap_size());
+        }
+        size_t size;
+        while ((size = lcd_trace_pack(&lcd_trace_ring, seq, packet, LCD_TRACE_PACKET_EVENTS)) > 0) {
+            lcd_trace_write(packet, size);
+            seq++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LCD_TRACE_PERIOD_MS));
+    }
+}
+
+/**
+ * Запускает выгрузку трассы. На устройстве устанавливает драйвер USB-Serial-JTAG и переводит на него консоль:
+ * лог и пакеты идут через одну очередь, и запись одного вызова не разрывается чужой.
+ * @return ESP_OK при успехе, иначе код ошибки
+ */
+static esp_err_t start_lcd_trace(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    lcd_trace_file = fopen(LCD_TRACE_FILE, "wb");
+    if (!lcd_trace_file) {
+        ESP_LOGE(TAG, "Failed to open trace file %s", LCD_TRACE_FILE);
+        return ESP_FAIL;
+    }
+#else
+    usb_serial_jtag_driver_config_t config = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    config.tx_buffer_size = LCD_TRACE_TX_BUFFER;
+    esp_err_t ret = usb_serial_jtag_driver_install(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "USB-Serial-JTAG driver install failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    usb_serial_jtag_vfs_use_driver();
+#endif
+    if (xTaskCreatePinnedToCore(lcd_trace_task, "lcd_trace", LCD_TRACE_TASK_STACK, NULL, LCD_TRACE_TASK_PRIORITY,
+                                NULL, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trace task");
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Display trace started: %u-event packets every %d ms (tools/trace2perfetto.py)",
+             LCD_TRACE_PACKET_EVENTS, LCD_TRACE_PERIOD_MS);
+    return ESP_OK;
+}
+#endif
+
+/**
+ * Обновление интерфейса для lvgl_post: метка "Hello World".
+ * @param arg Размер шрифта (16 или 28), переданный как указатель
+ */
+static void lvgl_ui_hello_world(void *arg) {
+    create_hello_world_label((int)(intptr_t)arg);
+}
+
+#if LVGL_TICK_TEST || CONFIG_IDF_TARGET_LINUX
+// Состояние замера точности тика LVGL (анимацию обслуживает задача рендеринга)
+static struct {
+    TaskHandle_t waiter;        // Задача, ожидающая окончания анимации
+    int64_t start_us;           // Запуск анимации по esp_timer
+    int64_t end_us;             // Окончание анимации (ready_cb) по esp_timer
+    uint32_t start_tick;        // Запуск анимации по тику LVGL
+    uint32_t end_tick;          // Окончание анимации по тику LVGL
+    int32_t max_error_ms;       // Наибольшее отклонение значения анимации от прошедшего времени
+    uint32_t steps;             // Вызовов exec_cb
+    volatile uint32_t legacy_ms; // Время, насчитанное прежней задачей тиков
+} tick_test;
+
+/**
+ * exec_cb тестовой анимации. Анимация линейная от 0 до LVGL_TICK_TEST_ANIM_MS за столько же мс,
+ * поэтому значение должно совпадать с временем, прошедшим с запуска по esp_timer.
+ * @param var Не используется
+ * @param value Текущее значение анимации
+ */
+static void tick_test_anim_exec(void *var, int32_t value) {
+    int32_t elapsed_ms = (int32_t)((esp_timer_get_time() - tick_test.start_us) / 1000);
+    int32_t error = abs(value - MIN(elapsed_ms, LVGL_TICK_TEST_ANIM_MS));
+    tick_test.max_error_ms = MAX(tick_test.max_error_ms, error);
+    tick_test.steps++;
+}
+
+/**
+ * ready_cb тестовой анимации: фиксирует время окончания и будит ожидающую задачу.
+ * @param anim Анимация
+ */
+static void tick_test_anim_ready(lv_anim_t *anim) {
+    tick_test.end_us = esp_timer_get_time();
+    tick_test.end_tick = lv_tick_get();
+    xTaskNotifyGive(tick_test.waiter);
 }
 
 /**
- * Задача для периодического вызова lv_tick_inc().
- * Обеспечивает корректное отсчёты времени для LVGL.
+ * Воспроизводит удалённую задачу тиков: просыпается каждые LVGL_LEGACY_TICK_MS
+ * и считает время так же, как считал lv_tick_inc. Нужна только для сравнения в run_lvgl_tick_test.
+ * @param arg Не используется
  */
-static void lvgl_tick_task(void *arg) {
+static void legacy_tick_task(void *arg) {
     while (1) {
-        lv_tick_inc(10); // Увеличение счётчика времени LVGL на 10 мс
-        vTaskDelay(pdMS_TO_TICKS(10));
+        tick_test.legacy_ms += LVGL_LEGACY_TICK_MS;
+        vTaskDelay(pdMS_TO_TICKS(LVGL_LEGACY_TICK_MS));
+    }
+}
+
+/**
+ * Время простоя всех ядер по счётчикам времени выполнения задач IDLE (в мкс при статистике от esp_timer).
+ * Счётчики 32-битные, поэтому разность двух значений верна при окне меньше 71 минуты.
+ * @return Суммарное время простоя
+ */
+static uint32_t idle_time_us(void) {
+    uint32_t total = 0;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    for (BaseType_t core = 0; core < portNUM_PROCESSORS; core++) {
+        total += ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+    }
+#endif
+    return total;
+}
+
+/**
+ * Замер точности времени LVGL от esp_timer и простоя, освобождённого без задачи тиков.
+ * 1. Линейная анимация длительностью LVGL_TICK_TEST_ANIM_MS: на каждом шаге значение сравнивается
+ *    с временем по esp_timer, в конце сравниваются прошедший тик LVGL и время esp_timer.
+ * 2. Два окна по LVGL_TICK_TEST_WINDOW_MS: без задачи тиков и с воспроизведённой прежней задачей.
+ *    Разница времени простоя — время, которое задача тиков отнимала у остальных задач;
+ *    насчитанное ею время показывает, насколько её отсчёт отставал от esp_timer.
+ * Должна вызываться после start_lvgl_render_task.
+ * @return true, если отклонения анимации и тика в пределах LVGL_TICK_TEST_MAX_ERROR_MS
+ */
+static bool run_lvgl_tick_test(void) {
+    memset(&tick_test, 0, sizeof(tick_test));
+    tick_test.waiter = xTaskGetCurrentTaskHandle();
+
+    lv_anim_t anim;
+    lv_anim_init(&anim);
+    lv_anim_set_var(&anim, &tick_test);
+    lv_anim_set_values(&anim, 0, LVGL_TICK_TEST_ANIM_MS);
+    lv_anim_set_time(&anim, LVGL_TICK_TEST_ANIM_MS);
+    lv_anim_set_exec_cb(&anim, tick_test_anim_exec);
+    lv_anim_set_ready_cb(&anim, tick_test_anim_ready);
+
+    lvgl_lock(-1);
+    tick_test.start_us = esp_timer_get_time();
+    tick_test.start_tick = lv_tick_get();
+    lv_anim_start(&anim);
+    lvgl_unlock();
+
+    bool ok = true;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LVGL_TICK_TEST_ANIM_MS * 2)) == 0) {
+        lvgl_lock(-1);
+        lv_anim_del(&tick_test, tick_test_anim_exec);
+        lvgl_unlock();
+        ESP_LOGE(TAG, "Tick test: animation did not finish in %d ms", LVGL_TICK_TEST_ANIM_MS * 2);
+        ok = false;
+    } else {
+        int32_t anim_ms = (int32_t)((tick_test.end_us - tick_test.start_us) / 1000);
+        int32_t tick_drift_ms = (int32_t)(tick_test.end_tick - tick_test.start_tick) - anim_ms;
+        ok = tick_test.max_error_ms <= LVGL_TICK_TEST_MAX_ERROR_MS && abs(tick_drift_ms) <= LVGL_TICK_TEST_MAX_ERROR_MS;
+        // Длительность в критерий не входит: окончание запаздывает до периода таймера анимаций LVGL
+        ESP_LOGI(TAG, "Tick test: %d ms animation took %" PRId32 " ms, max value error %" PRId32 " ms over %" PRIu32
+                 " steps, LVGL tick drift %+" PRId32 " ms: %s",
+                 LVGL_TICK_TEST_ANIM_MS, anim_ms, tick_test.max_error_ms, tick_test.steps, tick_drift_ms, ok ? "OK" : "FAIL");
+    }
+
+    // Окно без задачи тиков
+    const TickType_t window = pdMS_TO_TICKS(LVGL_TICK_TEST_WINDOW_MS / DEMO_PAUSE_DIV);
+    uint32_t idle_start = idle_time_us();
+    int64_t start_us = esp_timer_get_time();
+    vTaskDelay(window);
+    uint32_t idle_without = idle_time_us() - idle_start;
+    int64_t without_us = esp_timer_get_time() - start_us;
+
+    // Окно с прежней задачей тиков (те же параметры, что были у lvgl_tick_task)
+    TaskHandle_t legacy = NULL;
+    idle_start = idle_time_us();
+    start_us = esp_timer_get_time();
+    if (xTaskCreate(legacy_tick_task, "lvgl_tick", 2048, NULL, 2, &legacy) != pdPASS) {
+        ESP_LOGE(TAG, "Tick test: failed to create legacy tick task");
+        return false;
+    }
+    vTaskDelay(window);
+    uint32_t legacy_ms = tick_test.legacy_ms;
+    uint32_t idle_with = idle_time_us() - idle_start;
+    int64_t with_us = esp_timer_get_time() - start_us;
+    vTaskDelete(legacy);
+
+    double idle_without_pct = without_us ? 100.0 * idle_without / (without_us * portNUM_PROCESSORS) : 0;
+    double idle_with_pct = with_us ? 100.0 * idle_with / (with_us * portNUM_PROCESSORS) : 0;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    ESP_LOGI(TAG, "Tick test: idle %.2f%% without tick task, %.2f%% with it, recovered %.0f us of CPU per second",
+             idle_without_pct, idle_with_pct, (idle_without_pct - idle_with_pct) * portNUM_PROCESSORS * 10000.0);
+#else
+    (void)idle_without_pct;
+    (void)idle_with_pct;
+    ESP_LOGI(TAG, "Tick test: idle time unavailable, enable CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS");
+#endif
+    ESP_LOGI(TAG, "Tick test: legacy tick task counted %" PRIu32 " ms of %" PRId64 " ms (%d wakeups per second)",
+             legacy_ms, with_us / 1000, 1000 / LVGL_LEGACY_TICK_MS);
+    return ok;
+}
+#endif
+
+#if LVGL_STRESS_CHECK || CONFIG_IDF_TARGET_LINUX
+/**
+ * Обновление интерфейса для lvgl_post: lv_demo_stress на очищенном экране.
+ * @param arg Не используется
+ */
+static void lvgl_ui_stress_demo(void *arg) {
+    lv_obj_clean(lv_scr_act());
+    lv_demo_stress();
+}
+
+/**
+ * Выводит помеченные области текущего кадра дважды — без объединения и с ним — и сравнивает оба вывода.
+ * Перед каждым выводом сбрасывается кэш окна, чтобы CASET/RASET обоих режимов считались одинаково.
+ * На хосте оба вывода начинаются с одного и того же стекла, и после них стекло должно совпасть попиксельно:
+ * лишние пиксели охватывающих областей рисуются тем же содержимым, а потерянные остались бы от прошлого кадра.
+ * Вызывается под lvgl_lock.
+ * @param cost Стоимость вывода по bus_stats для каждого режима в байтах шины: пиксели, команды
+ *             и накладные расходы каждого flush (LVGL_COALESCE_FLUSH_OVERHEAD_US)
+ * @return Количество пикселей стекла, различающихся между режимами
+ */
+static int lvgl_stress_frame_pair(int64_t cost[2]) {
+    lv_area_t areas[LV_INV_BUF_SIZE];
+    uint8_t joined[LV_INV_BUF_SIZE];
+    const uint16_t inv_p = lvgl_disp->inv_p;
+    const int64_t flush_overhead = (int64_t)LVGL_COALESCE_FLUSH_OVERHEAD_US * lcd_panel_main.pclk_hz / 1000000;
+    memcpy(areas, lvgl_disp->inv_areas, sizeof(areas));
+    memcpy(joined, lvgl_disp->inv_area_joined, sizeof(joined));
+    int mismatches = 0;
+#if CONFIG_IDF_TARGET_LINUX
+    const size_t glass_bytes = (size_t)ST7789_EMU_GLASS_W * ST7789_EMU_GLASS_H * sizeof(uint16_t);
+    st7789_emu_t *emu = esp_lcd_mock_get_emu(lcd_panel_main.io);
+    uint16_t *before = malloc(glass_bytes);
+    uint16_t *as_is = malloc(glass_bytes);
+    if (!before || !as_is) {
+        ESP_LOGE(TAG, "Stress: no memory for glass snapshots");
+        free(before);
+        free(as_is);
+        return 1;
+    }
+    wait_lcd_transfers(&lcd_panel_main);
+    memcpy(before, st7789_emu_framebuffer(emu), glass_bytes);
+#endif
+
+    for (int mode = 0; mode < 2; mode++) {
+        memcpy(lvgl_disp->inv_areas, areas, sizeof(areas));
+        memcpy(lvgl_disp->inv_area_joined, joined, sizeof(joined));
+        lvgl_disp->inv_p = inv_p;
+        lvgl_coalesce.enabled = mode;
+        wait_lcd_transfers(&lcd_panel_main);
+        lcd_panel_main.window.col_valid = false;
+        lcd_panel_main.window.row_valid = false;
+#if CONFIG_IDF_TARGET_LINUX
+        st7789_emu_set_glass(emu, before);
+#endif
+        uint32_t flushes = flush_stats.flushes;
+        uint64_t bytes = bus_stats.color_bytes + bus_stats.cmd_bytes;
+        lvgl_refr_timer_cb(lvgl_disp->refr_timer);
+        wait_lcd_transfers(&lcd_panel_main);
+        cost[mode] = (int64_t)(bus_stats.color_bytes + bus_stats.cmd_bytes - bytes) +
+                     (int64_t)(flush_stats.flushes - flushes) * flush_overhead;
+#if CONFIG_IDF_TARGET_LINUX
+        const uint16_t *glass = st7789_emu_framebuffer(emu);
+        if (mode == 0) {
+            memcpy(as_is, glass, glass_bytes);
+            continue;
+        }
+        for (size_t i = 0; i < glass_bytes / sizeof(uint16_t); i++) {
+            mismatches += glass[i] != as_is[i];
+        }
+#endif
+    }
+
+#if CONFIG_IDF_TARGET_LINUX
+    free(before);
+    free(as_is);
+#endif
+    return mismatches;
+}
+
+/**
+ * Проверка объединения областей на lv_demo_stress: демо непрерывно создаёт, двигает и удаляет
+ * мелкие объекты, поэтому в кадре много областей. Режимы без объединения и с ним чередуются окнами
+ * по LVGL_STRESS_WINDOW_MS (так обе фазы демо попадают в оба режима), для каждого режима суммируются
+ * кадры, flush, командные транзакции и байты шины. В конце каждого окна один и тот же кадр выводится
+ * в обоих режимах (lvgl_stress_frame_pair): выигрыш считается по байтам, которые реально ушли на шину,
+ * а не по модели. Нарушения: областей после объединения больше, чем до него; кадры с объединением
+ * в среднем дороже тех же кадров без него; стекло после кадров различается. В конце восстанавливается LVGL_COALESCE.
+ * Должна вызываться после start_lvgl_render_task; демо остаётся на экране.
+ * @return Количество нарушений
+ */
+static int run_lvgl_stress_check(void) {
+    struct {
+        uint32_t frames;
+        uint32_t flushes;
+        uint32_t cmd_tx;
+        uint64_t cmd_bytes;
+        uint64_t color_bytes;
+        int64_t us;
+    } totals[2] = {0};          // [0] — без объединения, [1] — с объединением
+    int64_t pair_cost[2] = {0}; // Стоимость одних и тех же кадров в обоих режимах (байт шины)
+    int pairs = 0;
+    int mismatches = 0;
+    int failures = 0;
+
+    lvgl_post(lvgl_ui_stress_demo, NULL);
+    lvgl_coalesce_t before = lvgl_coalesce;
+    for (int round = 0; round < LVGL_STRESS_ROUNDS * 2; round++) {
+        int mode = round % 2;
+
+        // Режим переключается между кадрами: под блокировкой задача рендеринга не выводит
+        lvgl_lock(-1);
+        lvgl_coalesce.enabled = mode;
+        uint32_t frames = flush_stats.frames;
+        uint32_t flushes = flush_stats.flushes;
+        uint32_t cmd_tx = bus_stats.cmd_tx;
+        uint64_t cmd_bytes = bus_stats.cmd_bytes;
+        uint64_t color_bytes = bus_stats.color_bytes;
+        int64_t start_us = esp_timer_get_time();
+        lvgl_unlock();
+
+        vTaskDelay(pdMS_TO_TICKS(LVGL_STRESS_WINDOW_MS / DEMO_PAUSE_DIV));
+
+        lvgl_lock(-1);
+        totals[mode].frames += flush_stats.frames - frames;
+        totals[mode].flushes += flush_stats.flushes - flushes;
+        totals[mode].cmd_tx += bus_stats.cmd_tx - cmd_tx;
+        totals[mode].cmd_bytes += bus_stats.cmd_bytes - cmd_bytes;
+        totals[mode].color_bytes += bus_stats.color_bytes - color_bytes;
+        totals[mode].us += esp_timer_get_time() - start_us;
+
+        // Анимации демо продвигаются до текущего момента и помечают области следующего кадра
+        lv_anim_refr_now();
+        if (lvgl_disp->inv_p > 0) {
+            int64_t cost[2];
+            mismatches += lvgl_stress_frame_pair(cost);
+            pair_cost[0] += cost[0];
+            pair_cost[1] += cost[1];
+            pairs++;
+        }
+        lvgl_unlock();
+    }
+    lvgl_coalesce.enabled = LVGL_COALESCE;
+
+    for (int mode = 0; mode < 2; mode++) {
+        uint32_t frames = MAX(totals[mode].frames, 1);
+        ESP_LOGI(TAG, "Stress %-11s: frames=%" PRIu32 " (%.1f fps), flushes/frame=%.2f, cmd tx/frame=%.1f, cmd bytes/frame=%" PRIu64
+                 ", pixel bytes/frame=%" PRIu64,
+                 mode ? "coalesced" : "as-is", totals[mode].frames,
+                 totals[mode].us ? totals[mode].frames * 1e6 / totals[mode].us : 0.0,
+                 (double)totals[mode].flushes / frames, (double)totals[mode].cmd_tx / frames,
+                 totals[mode].cmd_bytes / frames, totals[mode].color_bytes / frames);
+    }
+
+    uint32_t areas_in = lvgl_coalesce.areas_in - before.areas_in;
+    uint32_t areas_out = lvgl_coalesce.areas_out - before.areas_out;
+    if (areas_out > areas_in) {
+        ESP_LOGE(TAG, "Stress: coalescing produced more areas (%" PRIu32 ") than LVGL marked (%" PRIu32 ")", areas_out, areas_in);
+        failures++;
+    }
+    if (pairs == 0 || pair_cost[1] > pair_cost[0]) {
+        ESP_LOGE(TAG, "Stress: coalesced frames cost %" PRId64 " bus bytes, as-is %" PRId64 " over %d frame(s)",
+                 pair_cost[1], pair_cost[0], pairs);
+        failures++;
+    }
+    if (mismatches != 0) {
+        ESP_LOGE(TAG, "Stress: coalesced frames differ from as-is frames in %d px", mismatches);
+        failures++;
+    }
+    ESP_LOGI(TAG, "Stress coalesce: areas in=%" PRIu32 ", out=%" PRIu32 ", merges=%" PRIu32 ", splits=%" PRIu32
+             ", LVGL joins=%" PRIu32 ", saved on the bus=%" PRId64 " bytes per frame (%d frames flushed in both modes)"
+             ", model estimate for all frames=%" PRId64 " bytes",
+             areas_in, areas_out, lvgl_coalesce.merges - before.merges, lvgl_coalesce.splits - before.splits,
+             lvgl_coalesce.lvgl_joins - before.lvgl_joins, pairs ? (pair_cost[0] - pair_cost[1]) / pairs : (int64_t)0, pairs,
+             lvgl_coalesce.bytes_saved - before.bytes_saved);
+    ESP_LOGI(TAG, "Stress check: %d failure(s)", failures);
+    return failures;
+}
+#endif
+
+#if LCD_PANEL2_ENABLE
+/**
+ * Запускает вторую панель и её дисплей LVGL с подписью линии CS. Вызывается после init_lvgl,
+ * до запуска задачи рендеринга; первый кадр выводит задача рендеринга.
+ * @return ESP_OK при успехе, иначе код ошибки (вторая панель не используется)
+ */
+static esp_err_t init_second_panel(void) {
+    esp_err_t ret = lcd_panel_start(&lcd_panel2, LCD_PANEL2_PIN_CS, LCD_PANEL2_ORIENTATION);
+    if (ret != ESP_OK) {
+        return ret;
     }
+    ret = lvgl_panel_register(&lcd_panel2, LVGL_PANEL2_BUFFER_LINES);
+    if (ret != ESP_OK) {
+        lcd_panel_deinit(&lcd_panel2);
+        return ret;
+    }
+    lv_obj_t *label = lv_label_create(lv_disp_get_scr_act(lcd_panel2.disp));
+    lv_label_set_text_fmt(label, "Panel 2\nCS %d", LCD_PANEL2_PIN_CS);
+    lv_obj_set_style_text_color(label, lv_color_white(), 0);
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+    return ESP_OK;
 }
+#endif
 
 /**
  * Главная функция приложения.
  * Инициализирует дисплей, LVGL, выводит текст и тестирует ориентации.
  */
 void app_main(void) {
+    lcd_boot.app_start_us = esp_timer_get_time();
     ESP_LOGI(TAG, "Starting application...");
+#if LCD_TRACE
+    // Трасса запускается первой, чтобы в неё попали инициализация и первые кадры
+    ESP_ERROR_CHECK(start_lcd_trace());
+#endif
     ESP_LOGI(TAG, "Stack watermark: %u", uxTaskGetStackHighWaterMark(NULL));
+#if CONFIG_IDF_TARGET_LINUX
+    host_checks_init();
+#endif
 
     // Инициализация дисплея
     init_display();
 
+#if RGB565_BENCHMARK || CONFIG_IDF_TARGET_LINUX
+    // Ядра заливки и перестановки байтов: сверка с попиксельным эталоном, затем замер ядер и C на одних данных
+    if (rgb565_self_test() != 0) {
+        ESP_LOGE(TAG, "RGB565 kernels differ from reference");
+#if CONFIG_IDF_TARGET_LINUX
+        exit(1);
+#endif
+    }
+    if (rgb565_benchmark() != 0) {
+        ESP_LOGE(TAG, "RGB565 kernels differ from the C implementation");
+#if CONFIG_IDF_TARGET_LINUX
+        exit(1);
+#endif
+    }
+    run_byte_order_benchmark();
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+    // Хост: панель, ориентации, эталонные кадры, заставка и трасса (host_checks.c)
+    if (run_host_panel_checks() != 0) {
+        exit(1);
+    }
+#endif
+
+#if LCD_PCLK_SWEEP || CONFIG_IDF_TARGET_LINUX
+    // Замер пропускной способности на разных частотах pclk; на хосте ещё и сверка с эмулятором
+#if CONFIG_IDF_TARGET_LINUX
+    if (run_pclk_sweep() != 0) {
+        exit(1);
+    }
+#else
+    run_pclk_sweep();
+#endif
+#endif
+
     // Инициализация LVGL
     init_lvgl();
 
-    // Запуск задачи для LVGL tick
-    xTaskCreate(lvgl_tick_task, "lvgl_tick", 2048, NULL, 2, NULL);
+#if LCD_PANEL2_ENABLE
+    // Вторая панель на той же шине: своя линия CS, ориентация и дисплей LVGL, равная доля очереди шины
+    if (init_second_panel() != ESP_OK) {
+        ESP_LOGW(TAG, "Continuing without the second panel");
+    }
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+    // Хост: порядок байт, режимы питания, поворот в обоих способах и вторая панель (host_checks.c)
+    if (run_host_lvgl_checks() != 0) {
+        exit(1);
+    }
+#endif
+
+#if LCD_ROTATION_BENCHMARK || CONFIG_IDF_TARGET_LINUX
+    // Поворот через MADCTL и на CPU: время кадра и цена поворота на разных высотах буфера
+    run_rotation_benchmark();
+#endif
+
+#if LVGL_BUFFER_BENCHMARK
+    // Замер FPS и запаса памяти для разных раскладок буферов LVGL
+    run_lvgl_buffer_benchmark();
+#endif
+
+#if CONFIG_DISPLAY_BENCHMARK
+    // Сборка бенчмарка: сцены LVGL во всех ориентациях и раскладках буферов, результаты строками BENCH.
+    // Сцены смотрят и на экране, поэтому панель включается, не дожидаясь первого кадра быстрого старта
+    ESP_ERROR_CHECK(lcd_display_on());
+    run_display_benchmark();
+#endif
 
+#if LCD_FAST_BOOT
+    // Первый кадр — начальная метка "Hello World" с шрифтом 28 — рендерится целиком до запуска задачи рендеринга,
+    // и только когда он в памяти панели, включаются Display On и подсветка
+    esp_err_t ret = ESP_OK;
+    lvgl_ui_hello_world((void *)(intptr_t)28);
+    lv_obj_invalidate(lv_scr_act());
+    lvgl_refr_now();
+    ESP_ERROR_CHECK(lcd_display_on());
+#else
     // Очистка экрана перед рендерингом LVGL
     ESP_LOGI(TAG, "Clearing screen before LVGL rendering...");
-    esp_err_t ret = clear_screen(0x0000);
+    esp_err_t ret = clear_screen(&lcd_panel_main, 0x0000);
     ESP_LOGI(TAG, "Pre-LVGL clear returned: %s", esp_err_to_name(ret));
+#endif
+    int64_t first_frame_us = esp_timer_get_time();
+    int64_t first_pixel_us = lcd_boot.display_on && LCD_FAST_BOOT ? lcd_boot.display_on_us : first_frame_us;
+    ESP_LOGI(TAG, "Time to first pixel: %" PRId64 " us from app_main (%" PRId64 " us since boot), first LVGL frame at %" PRId64 " us",
+             first_pixel_us - lcd_boot.app_start_us, first_pixel_us, first_frame_us - lcd_boot.app_start_us);
+
+    // Запуск задачи рендеринга: дальше LVGL вызывается только из неё или под lvgl_lock
+    ESP_ERROR_CHECK(start_lvgl_render_task());
 
+#if !LCD_FAST_BOOT
     // Создание начальной метки "Hello World" с шрифтом 28
-    create_hello_world_label(28);
-    for (int i = 0; i < 500; i++) { // 5 секунд (500 * 10 мс)
-        lv_task_handler(); // Обработка и рендеринг LVGL
-        vTaskDelay(pdMS_TO_TICKS(10));
+    lvgl_post(lvgl_ui_hello_world, (void *)(intptr_t)28);
+#endif
+    vTaskDelay(pdMS_TO_TICKS(5000 / DEMO_PAUSE_DIV));
+
+#if LVGL_TICK_TEST || CONFIG_IDF_TARGET_LINUX
+    // Точность времени LVGL от esp_timer и простой, освобождённый без задачи тиков
+#if CONFIG_IDF_TARGET_LINUX
+    if (!run_lvgl_tick_test()) {
+        exit(1);
     }
+#else
+    run_lvgl_tick_test();
+#endif
+#endif
 
-    // Тест смены ориентаций
     display_orientation_t orientations[] = {
         DISPLAY_ORIENTATION_0, DISPLAY_ORIENTATION_90, DISPLAY_ORIENTATION_180, DISPLAY_ORIENTATION_270
     };
+#if LCD_FILL_TEST_DEMO
+    // Тест заливки и полос во всех ориентациях выводит на панель напрямую, поэтому на всё время теста
+    // задача рендеринга останавливается блокировкой
+    lvgl_lock(-1);
     for (int i = 0; i < 4; i++) {
-        // Установка ориентации
-        ret = set_display_orientation(orientations[i]);
+        ret = set_display_orientation(&lcd_panel_main, orientations[i]);
         ESP_LOGI(TAG, "Set orientation %d returned: %s", orientations[i], esp_err_to_name(ret));
-
-        // Выполнение теста заливки и полос
         test_fill_screen();
+    }
+    lvgl_unlock();
+#endif
 
-        // Очистка экрана перед созданием метки
-        ret = clear_screen(0x0000);
-        ESP_LOGI(TAG, "Cleared screen before label, returned: %s", esp_err_to_name(ret));
+    // Метка "Hello World" с шрифтом 16 создаётся один раз: при поворотах объекты LVGL не пересоздаются
+    lvgl_lock(-1);
+    create_hello_world_label(16);
+    lvgl_unlock();
 
-        // Создание метки "Hello World" с шрифтом 16
-        create_hello_world_label(16);
+    // Тест смены ориентаций: MADCTL и перерисовка экрана LVGL одним кадром, без очистки
+    for (int i = 0; i < 4; i++) {
+        int64_t latency_us;
+        uint64_t bytes;
+        lvgl_lock(-1);
+        ret = rotate_display_measured(orientations[i], &latency_us, &bytes);
+        lvgl_unlock();
+        ESP_LOGI(TAG, "Rotated to %d deg: %s, %" PRId64 " us to the last pixel, %" PRIu64 " bytes",
+                 orientations[i] * 90, esp_err_to_name(ret), latency_us, bytes);
+
+        // Метка остаётся на экране 5 секунд
+        vTaskDelay(pdMS_TO_TICKS(5000 / DEMO_PAUSE_DIV));
+        log_flush_stats();
+    }
 
-        // Цикл для рендеринга метки в течение 5 секунд
-        for (int j = 0; j < 500; j++) { // 5 секунд (500 * 10 мс)
-            lv_task_handler();
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
+#if CONFIG_IDF_TARGET_LINUX
+    // Хост: консоль и объединение областей при работающей задаче рендеринга (host_checks.c)
+    if (run_host_render_checks() != 0) {
+        exit(1);
+    }
+#endif
+
+#if CONSOLE_DEMO
+    // Консоль с аппаратной прокруткой выводит на панель напрямую, поэтому задача рендеринга стоит на блокировке
+    lvgl_lock(-1);
+    run_console_demo();
+    lvgl_unlock();
+#endif
+
+#if LCD_POWER_DEMO
+    // Частичный показ, 8 цветов и пониженная частота кадров поверх экрана LVGL
+    run_power_mode_demo();
+#endif
+
+#if LVGL_STRESS_CHECK || CONFIG_IDF_TARGET_LINUX
+    // Вывод lv_demo_stress с объединением областей и без
+#if CONFIG_IDF_TARGET_LINUX
+    if (run_lvgl_stress_check() != 0) {
+        exit(1);
     }
+#else
+    run_lvgl_stress_check();
+#endif
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+    // Хост: замеры этапов вывода после всех кадров прогона (host_checks.c)
+    if (run_host_perf_checks() != 0) {
+        exit(1);
+    }
+#endif
 
     ESP_LOGI(TAG, "Entering main loop");
+#if CONFIG_IDF_TARGET_LINUX
+    int host_iterations = 0;
+#endif
     while (1) {
-        // Обновление LVGL
-        lv_task_handler();
-        ESP_LOGD(TAG, "LVGL task handler called, free heap: %" PRIu32, esp_get_free_heap_size());
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // LVGL обслуживает задача рендеринга; здесь только периодическая статистика
+        vTaskDelay(pdMS_TO_TICKS(LVGL_STATS_PERIOD_MS / DEMO_PAUSE_DIV));
+        log_flush_stats();
+#if CONFIG_IDF_TARGET_LINUX
+        // На хосте цикл ограничен, чтобы прогон завершался в CI
+        if (++host_iterations >= HOST_MAIN_LOOP_ITERATIONS) {
+            log_emu_stats();
+            exit(0);
+        }
+#endif
     }
 
-    // Пример влияния: если не вызывать lv_task_handler в цикле ориентаций,
+    // Пример влияния: если не запустить задачу рендеринга (или держать lvgl_lock),
     // метки не будут рендериться, и текст "Hello World" не появится.
 }
\ No newline at end of file
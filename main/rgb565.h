@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Ядра обработки пикселей RGB565: заливка, копирование с перестановкой байтов и смешивание.
+ * На ESP32-S3 основной объём обрабатывается 128-битными векторными инструкциями PIE
+ * (по 8 пикселей за инструкцию), начало до выравнивания на 16 байт и хвост — на C.
+ * На остальных таргетах (в том числе linux) работает переносимая реализация на C
+ * с теми же результатами бит в бит.
+ */
+
+#define RGB565_ROTATE_TILE  16                // Сторона плитки rgb565_rotate90: 16 строк по 32 байта источника
+
+/**
+ * Заполняет массив пикселей одним цветом.
+ * @param dst Массив пикселей
+ * @param color Цвет в формате RGB565
+ * @param count Количество пикселей
+ */
+void rgb565_fill(uint16_t *dst, uint16_t color, size_t count);
+
+/**
+ * Заполняет прямоугольник в кадре одним цветом.
+ * @param dst Начало кадра
+ * @param stride Ширина строки кадра в пикселях
+ * @param x Левый столбец прямоугольника
+ * @param y Верхняя строка прямоугольника
+ * @param w Ширина прямоугольника
+ * @param h Высота прямоугольника
+ * @param color Цвет в формате RGB565
+ */
+void rgb565_fill_rect(uint16_t *dst, int stride, int x, int y, int w, int h, uint16_t color);
+
+/**
+ * Копирует пиксели, меняя местами байты каждого (порядок байт шины ST7789 и памяти CPU).
+ * dst и src могут совпадать (перестановка на месте), другие перекрытия не допускаются.
+ * @param dst Куда копировать
+ * @param src Откуда копировать
+ * @param count Количество пикселей
+ */
+void rgb565_copy_swap(uint16_t *dst, const uint16_t *src, size_t count);
+
+/**
+ * Смешивает src поверх dst с общей прозрачностью: для каждого канала
+ * dst = dst + ((src - dst) * a) >> 8, где a = alpha + alpha / 128 (0..256, 255 даёт ровно src).
+ * @param dst Фон и результат
+ * @param src Накладываемые пиксели
+ * @param alpha Непрозрачность src (0 — dst без изменений, 255 — src)
+ * @param count Количество пикселей
+ */
+void rgb565_blend(uint16_t *dst, const uint16_t *src, uint8_t alpha, size_t count);
+
+/**
+ * Поворачивает прямоугольник пикселей на 90°: строки результата — столбцы источника.
+ * По часовой стрелке dst[r * h + j] = src[(h - 1 - j) * stride + r], против — dst[r * h + j] = src[j * stride + (w - 1 - r)].
+ * Обход плитками RGB565_ROTATE_TILE x RGB565_ROTATE_TILE: строки источника в плитке остаются в кэше,
+ * пока из них собираются строки результата. Реализация на C на всех таргетах.
+ * @param dst Результат: w строк по h пикселей (не перекрывается с src)
+ * @param src Левый верхний пиксель источника
+ * @param stride Ширина строки источника в пикселях
+ * @param w Ширина источника (строк результата)
+ * @param h Высота источника (пикселей в строке результата)
+ * @param clockwise true — по часовой стрелке, false — против
+ */
+void rgb565_rotate90(uint16_t *dst, const uint16_t *src, int stride, int w, int h, bool clockwise);
+
+/**
+ * Сверяет ядра с попиксельной эталонной реализацией на разных длинах и выравниваниях.
+ * @return Количество найденных расхождений (0 — ядра верны)
+ */
+int rgb565_self_test(void);
+
+/**
+ * Микробенчмарк: ядра (PIE на ESP32-S3) и переносимая реализация на C обрабатывают одни и те же данные
+ * на полосе размером с буфер LVGL; результаты сверяются, время обеих выводится в лог.
+ * @return Количество ядер, результат которых разошёлся с реализацией на C (0 — совпали)
+ */
+int rgb565_benchmark(void);
+
+/**
+ * @return true, если ядра используют векторные инструкции PIE
+ */
+bool rgb565_simd_enabled(void);
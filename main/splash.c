@@ -0,0 +1,140 @@
+#include <string.h>
+#include <inttypes.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "rgb565.h"
+#include "splash.h"
+
+#define SPLASH_RLE_MIN_RUN  3                 // Серии короче кодируются литералами: серия из 2 пикселей
+                                              // не короче литерала, но разрывает пакет литералов
+
+static const char *TAG = "splash";
+
+/**
+ * Читает 16-битное слово little-endian (данные во flash не выровнены).
+ */
+static inline uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool splash_open(const void *image, size_t size, splash_header_t *header, splash_decoder_t *decoder) {
+    if (size < sizeof(*header)) {
+        return false;
+    }
+    memcpy(header, image, sizeof(*header));
+    if (header->magic != SPLASH_MAGIC) {
+        ESP_LOGW(TAG, "No splash image (magic 0x%08" PRIX32 ")", header->magic);
+        return false;
+    }
+    if (header->width == 0 || header->height == 0 || header->data_size > size - sizeof(*header) ||
+        (header->encoding != SPLASH_ENCODING_RAW && header->encoding != SPLASH_ENCODING_RLE) ||
+        (header->encoding == SPLASH_ENCODING_RAW &&
+         header->data_size != (uint32_t)header->width * header->height * sizeof(uint16_t))) {
+        ESP_LOGE(TAG, "Invalid splash header: %ux%u, encoding %u, %" PRIu32 " bytes", header->width, header->height,
+                 header->encoding, header->data_size);
+        return false;
+    }
+    const uint8_t *data = (const uint8_t *)image + sizeof(*header);
+    uint32_t crc = esp_rom_crc32_le(0, data, header->data_size);
+    if (crc != header->crc32) {
+        ESP_LOGE(TAG, "Splash CRC mismatch: 0x%08" PRIX32 " != 0x%08" PRIX32, crc, header->crc32);
+        return false;
+    }
+    *decoder = (splash_decoder_t){
+        .src = data,
+        .end = data + header->data_size,
+        .encoding = header->encoding,
+    };
+    return true;
+}
+
+size_t splash_decode(splash_decoder_t *decoder, uint16_t *dst, size_t count) {
+    size_t done = 0;
+    if (decoder->encoding == SPLASH_ENCODING_RAW) {
+        done = MIN(count, (size_t)(decoder->end - decoder->src) / sizeof(uint16_t));
+        memcpy(dst, decoder->src, done * sizeof(uint16_t));
+        decoder->src += done * sizeof(uint16_t);
+        return done;
+    }
+
+    while (done < count) {
+        if (decoder->packet_left == 0) {
+            if (decoder->end - decoder->src < 2) {
+                break;
+            }
+            uint16_t ctrl = read_u16(decoder->src);
+            decoder->src += 2;
+            decoder->run = ctrl & SPLASH_RLE_RUN;
+            decoder->packet_left = (ctrl & ~SPLASH_RLE_RUN) + 1;
+            if (decoder->run) {
+                if (decoder->end - decoder->src < 2) {
+                    break;
+                }
+                decoder->run_color = read_u16(decoder->src);
+                decoder->src += 2;
+            }
+        }
+        size_t n = MIN(count - done, decoder->packet_left);
+        if (decoder->run) {
+            rgb565_fill(dst + done, decoder->run_color, n);
+        } else {
+            // Литералы копируются прямо из отображённого flash
+            n = MIN(n, (size_t)(decoder->end - decoder->src) / sizeof(uint16_t));
+            if (n == 0) {
+                break;
+            }
+            memcpy(dst + done, decoder->src, n * sizeof(uint16_t));
+            decoder->src += n * sizeof(uint16_t);
+        }
+        decoder->packet_left -= n;
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * Длина серии одинаковых пикселей, начиная с pixels[i], не больше limit.
+ */
+static size_t run_length(const uint16_t *pixels, size_t i, size_t count, size_t limit) {
+    size_t r = 1;
+    while (i + r < count && r < limit && pixels[i + r] == pixels[i]) {
+        r++;
+    }
+    return r;
+}
+
+/**
+ * Записывает слово little-endian, если есть куда.
+ */
+static size_t put_u16(uint8_t *out, size_t pos, uint16_t v) {
+    if (out) {
+        out[pos] = v & 0xFF;
+        out[pos + 1] = v >> 8;
+    }
+    return pos + 2;
+}
+
+size_t splash_encode_rle(const uint16_t *pixels, size_t count, uint8_t *out) {
+    size_t pos = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t r = run_length(pixels, i, count, SPLASH_RLE_MAX);
+        if (r >= SPLASH_RLE_MIN_RUN) {
+            pos = put_u16(out, pos, SPLASH_RLE_RUN | (uint16_t)(r - 1));
+            pos = put_u16(out, pos, pixels[i]);
+            i += r;
+            continue;
+        }
+        // Литералы до начала следующей серии или до наибольшей длины пакета
+        size_t j = i;
+        while (j < count && j - i < SPLASH_RLE_MAX && run_length(pixels, j, count, SPLASH_RLE_MIN_RUN) < SPLASH_RLE_MIN_RUN) {
+            j++;
+        }
+        pos = put_u16(out, pos, (uint16_t)(j - i - 1));
+        for (; i < j; i++) {
+            pos = put_u16(out, pos, pixels[i]);
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Образ заставки: заголовок splash_header_t и пиксели RGB565 (порядок CPU, младший байт первым),
+ * построчно, без сжатия или в RLE. Образ готовит tools/png2splash.py, на устройстве он лежит
+ * в разделе "splash" и читается через отображение flash в адресное пространство, без копии в куче.
+ *
+ * RLE: последовательность пакетов, каждый начинается с 16-битного слова управления (little-endian).
+ * Бит 15 = 1 — серия: (ctrl & 0x7FFF) + 1 пикселей одного цвета, за словом следует этот пиксель.
+ * Бит 15 = 0 — литералы: (ctrl & 0x7FFF) + 1 пикселей, за словом следуют сами пиксели.
+ */
+
+#define SPLASH_MAGIC            0x314C5053    // "SPL1"
+#define SPLASH_ENCODING_RAW     0             // Пиксели без сжатия
+#define SPLASH_ENCODING_RLE     1             // Пакеты RLE (см. выше)
+#define SPLASH_RLE_RUN          0x8000        // Бит серии в слове управления
+#define SPLASH_RLE_MAX          0x8000        // Наибольшая длина пакета в пикселях
+
+// Заголовок образа (20 байт, little-endian)
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // SPLASH_MAGIC
+    uint16_t width;             // Ширина изображения
+    uint16_t height;            // Высота изображения
+    uint8_t encoding;           // SPLASH_ENCODING_*
+    uint8_t reserved;           // 0
+    uint16_t background;        // Цвет полей вокруг изображения меньше экрана (RGB565)
+    uint32_t data_size;         // Байт данных после заголовка
+    uint32_t crc32;             // CRC32 данных (esp_rom_crc32_le с начальным значением 0, как zlib.crc32)
+} splash_header_t;
+
+// Состояние потокового декодера: пиксели выдаются полосами, без буфера на весь кадр
+typedef struct {
+    const uint8_t *src;         // Следующий байт данных
+    const uint8_t *end;         // Конец данных
+    uint8_t encoding;           // SPLASH_ENCODING_*
+    uint32_t packet_left;       // Пикселей, оставшихся в текущем пакете RLE
+    bool run;                   // Текущий пакет — серия
+    uint16_t run_color;         // Цвет серии
+} splash_decoder_t;
+
+/**
+ * Проверяет заголовок и CRC образа и готовит декодер.
+ * @param image Образ (заголовок и данные)
+ * @param size Размер образа в байтах (может быть больше образа, например размер раздела)
+ * @param header Копия заголовка
+ * @param decoder Декодер, установленный на начало данных
+ * @return true, если образ цел
+ */
+bool splash_open(const void *image, size_t size, splash_header_t *header, splash_decoder_t *decoder);
+
+/**
+ * Декодирует следующие пиксели образа.
+ * @param decoder Декодер
+ * @param dst Куда записать пиксели (порядок CPU)
+ * @param count Сколько пикселей нужно
+ * @return Записано пикселей: меньше count, только если данные кончились или повреждены
+ */
+size_t splash_decode(splash_decoder_t *decoder, uint16_t *dst, size_t count);
+
+/**
+ * Кодирует пиксели в RLE (тем же алгоритмом, что tools/png2splash.py).
+ * @param pixels Пиксели (порядок CPU)
+ * @param count Количество пикселей
+ * @param out Выходной буфер или NULL, чтобы узнать размер
+ * @return Размер данных RLE в байтах
+ */
+size_t splash_encode_rle(const uint16_t *pixels, size_t count, uint8_t *out);
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Конвертирует PNG в образ заставки для раздела "splash" (формат описан в main/splash.h).
+
+Пиксели переводятся в RGB565 (старшие биты каналов, как lv_color_make), прозрачность смешивается
+с цветом фона. Образ записывается без сжатия или в RLE; по умолчанию выбирается то, что короче.
+Заставка выводится в начальной ориентации init_display (90°), то есть изображение должно быть
+не больше 320x170; меньшее изображение выводится по центру, поля заливаются цветом фона.
+
+    python tools/png2splash.py logo.png -o splash.bin --background 000000
+    idf.py flash    # splash.bin в корне проекта записывается в раздел splash
+
+Требуется Pillow (pip install pillow).
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+from PIL import Image
+
+SPLASH_MAGIC = 0x314C5053  # "SPL1"
+SPLASH_ENCODING_RAW = 0
+SPLASH_ENCODING_RLE = 1
+SPLASH_RLE_RUN = 0x8000
+SPLASH_RLE_MAX = 0x8000
+SPLASH_RLE_MIN_RUN = 3
+HEADER = struct.Struct("<IHHBBHII")  # splash_header_t
+SCREEN_W, SCREEN_H = 320, 170  # Логическое разрешение в начальной ориентации (90°)
+PARTITION_SIZE = 128 * 1024  # Размер раздела splash в partitions.csv
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def parse_color(text):
+    """Цвет фона: RRGGBB или 0xNNNN (уже RGB565)."""
+    if text.lower().startswith("0x"):
+        return int(text, 16) & 0xFFFF
+    value = int(text.lstrip("#"), 16)
+    return rgb565((value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF)
+
+
+def to_pixels(image, background):
+    """Пиксели RGB565 построчно; прозрачные пиксели смешиваются с фоном."""
+    bg_r = ((background >> 11) & 0x1F) << 3
+    bg_g = ((background >> 5) & 0x3F) << 2
+    bg_b = (background & 0x1F) << 3
+    base = Image.new("RGBA", image.size, (bg_r, bg_g, bg_b, 255))
+    rgb = Image.alpha_composite(base, image.convert("RGBA")).convert("RGB")
+    return [rgb565(r, g, b) for r, g, b in rgb.getdata()]
+
+
+def run_length(pixels, i, limit):
+    r = 1
+    while i + r < len(pixels) and r < limit and pixels[i + r] == pixels[i]:
+        r += 1
+    return r
+
+
+def encode_rle(pixels):
+    """RLE тем же алгоритмом, что splash_encode_rle в main/splash.c."""
+    out = bytearray()
+    i = 0
+    while i < len(pixels):
+        r = run_length(pixels, i, SPLASH_RLE_MAX)
+        if r >= SPLASH_RLE_MIN_RUN:
+            out += struct.pack("<HH", SPLASH_RLE_RUN | (r - 1), pixels[i])
+            i += r
+            continue
+        j = i
+        while j < len(pixels) and j - i < SPLASH_RLE_MAX and run_length(pixels, j, SPLASH_RLE_MIN_RUN) < SPLASH_RLE_MIN_RUN:
+            j += 1
+        out += struct.pack("<H", j - i - 1)
+        out += struct.pack("<%dH" % (j - i), *pixels[i:j])
+        i = j
+    return bytes(out)
+
+
+def decode(image):
+    """Разбирает образ так же, как splash_open/splash_decode; возвращает (ширина, высота, пиксели)."""
+    magic, width, height, encoding, _, _, data_size, crc = HEADER.unpack_from(image)
+    if magic != SPLASH_MAGIC:
+        raise ValueError("bad magic")
+    data = image[HEADER.size:HEADER.size + data_size]
+    if len(data) != data_size or zlib.crc32(data) != crc:
+        raise ValueError("bad CRC")
+    if encoding == SPLASH_ENCODING_RAW:
+        return width, height, list(struct.unpack("<%dH" % (data_size // 2), data))
+    pixels = []
+    pos = 0
+    while pos + 2 <= len(data):
+        (ctrl,) = struct.unpack_from("<H", data, pos)
+        pos += 2
+        count = (ctrl & ~SPLASH_RLE_RUN) + 1
+        if ctrl & SPLASH_RLE_RUN:
+            (color,) = struct.unpack_from("<H", data, pos)
+            pos += 2
+            pixels += [color] * count
+        else:
+            pixels += struct.unpack_from("<%dH" % count, data, pos)
+            pos += 2 * count
+    return width, height, pixels
+
+
+def build(pixels, width, height, encoding, background):
+    raw = struct.pack("<%dH" % len(pixels), *pixels)
+    if encoding == "auto":
+        rle = encode_rle(pixels)
+        encoding = "rle" if len(rle) < len(raw) else "raw"
+    data = encode_rle(pixels) if encoding == "rle" else raw
+    code = SPLASH_ENCODING_RLE if encoding == "rle" else SPLASH_ENCODING_RAW
+    return HEADER.pack(SPLASH_MAGIC, width, height, code, 0, background, len(data), zlib.crc32(data)) + data, encoding
+
+
+def main():
+    parser = argparse.ArgumentParser(description="PNG -> splash partition image (main/splash.h)")
+    parser.add_argument("png", help="Source image")
+    parser.add_argument("-o", "--output", default="splash.bin", help="Output image (default: splash.bin)")
+    parser.add_argument("--encoding", choices=["auto", "rle", "raw"], default="auto",
+                        help="Pixel encoding; auto picks the smaller one")
+    parser.add_argument("--background", default="000000",
+                        help="Margin and transparency colour: RRGGBB or 0xNNNN (RGB565)")
+    args = parser.parse_args()
+
+    source = Image.open(args.png)
+    width, height = source.size
+    if width > SCREEN_W or height > SCREEN_H:
+        sys.exit("%s is %dx%d, the splash must fit %dx%d" % (args.png, width, height, SCREEN_W, SCREEN_H))
+    background = parse_color(args.background)
+    pixels = to_pixels(source, background)
+    image, encoding = build(pixels, width, height, args.encoding, background)
+    if len(image) > PARTITION_SIZE:
+        sys.exit("Image is %d bytes, the splash partition holds %d" % (len(image), PARTITION_SIZE))
+
+    # Обратная проверка: образ разбирается так же, как на устройстве
+    if decode(image) != (width, height, pixels):
+        sys.exit("Round-trip check failed")
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: %dx%d, %s, %d bytes (%d%% of raw)" % (args.output, width, height, encoding.upper(), len(image),
+                                                    len(image) * 100 // (width * height * 2)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Переводит двоичную трассу вывода (LCD_TRACE 1, формат описан в main/lcd_trace.h) в JSON
+Chrome trace event, который открывают ui.perfetto.dev и chrome://tracing.
+
+Трасса читается из файла (на хосте её пишет lcd_trace.bin) или прямо с порта USB-Serial-JTAG.
+Текст лога между пакетами пропускается (или сохраняется в --text); пакеты с неверной CRC отбрасываются.
+
+    python tools/trace2perfetto.py lcd_trace.bin -o trace.json
+    python tools/trace2perfetto.py --port /dev/ttyACM0 --seconds 10 -o trace.json --text log.txt
+
+Для чтения порта нужен pyserial (pip install pyserial).
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+import zlib
+
+LCD_TRACE_MAGIC = b"LTRC"
+LCD_TRACE_VERSION = 1
+HEADER = struct.Struct("<4sBBHII")  # lcd_trace_header_t
+EVENT = struct.Struct("<IBBHII")  # lcd_trace_event_t
+CRC = struct.Struct("<I")
+
+# lcd_trace_type_t
+TIMER_BEGIN, TIMER_END, REFR_BEGIN, REFR_END, FLUSH_BEGIN, FLUSH_END, DMA_DONE, TE, HEAP = range(1, 10)
+
+PID = 1
+TID_LVGL, TID_DMA, TID_TE = 1, 2, 3
+TRACKS = {TID_LVGL: "LVGL render", TID_DMA: "i80 DMA", TID_TE: "TE"}
+
+
+def read_port(port, seconds):
+    import serial  # pyserial
+
+    data = bytearray()
+    with serial.Serial(port, 115200, timeout=0.1) as ser:
+        end = time.monotonic() + seconds
+        while time.monotonic() < end:
+            data += ser.read(4096)
+    return bytes(data)
+
+
+def parse_stream(data):
+    """Пакеты по порядку; возвращает (список (заголовок, события), байты текста вне пакетов, отвергнутые пакеты)."""
+    packets = []
+    text = bytearray()
+    rejected = 0
+    pos = 0
+    while True:
+        found = data.find(LCD_TRACE_MAGIC, pos)
+        if found < 0:
+            text += data[pos:]
+            break
+        text += data[pos:found]
+        if found + HEADER.size > len(data):
+            break
+        magic, version, _, count, seq, dropped = HEADER.unpack_from(data, found)
+        size = HEADER.size + count * EVENT.size + CRC.size
+        body = data[found:found + size - CRC.size]
+        if version != LCD_TRACE_VERSION or found + size > len(data) or \
+                zlib.crc32(body) != CRC.unpack_from(data, found + size - CRC.size)[0]:
+            # Сигнатура в тексте или испорченный пакет: поиск продолжается со следующего байта
+            rejected += 1
+            text += data[found:found + 1]
+            pos = found + 1
+            continue
+        events = [EVENT.unpack_from(data, found + HEADER.size + i * EVENT.size) for i in range(count)]
+        packets.append(((seq, dropped), events))
+        pos = found + size
+    return packets, bytes(text), rejected
+
+
+def unwrap(events):
+    """Продолжает 32-битное время в мкс через переполнение (каждые 71 минуту)."""
+    base = 0
+    last = None
+    for time_us, etype, core, arg, a, b in events:
+        if last is not None and time_us + base < last - (1 << 31):
+            base += 1 << 32
+        last = time_us + base
+        yield last, etype, core, arg, a, b
+
+
+def to_chrome(packets):
+    out = [{"ph": "M", "pid": PID, "name": "process_name", "args": {"name": "Display pipeline"}}]
+    for tid, name in TRACKS.items():
+        out.append({"ph": "M", "pid": PID, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    events = [e for _, packet in packets for e in packet]
+    stats = {"events": len(events), "gaps": 0, "dropped": packets[-1][0][1] if packets else 0, "frames": 0}
+    prev_seq = None
+    for (seq, dropped), _ in packets:
+        if prev_seq is not None and seq != prev_seq + 1:
+            stats["gaps"] += 1
+        prev_seq = seq
+
+    submits = []  # Области в очереди DMA: (момент постановки, байт)
+    dma_free_us = 0
+    for ts, etype, core, arg, a, b in unwrap(events):
+        common = {"pid": PID, "ts": ts}
+        if etype == TIMER_BEGIN:
+            out.append(dict(common, ph="B", tid=TID_LVGL, name="lv_timer_handler", args={"core": core}))
+        elif etype == TIMER_END:
+            out.append(dict(common, ph="E", tid=TID_LVGL, args={"sleep_ms": a}))
+        elif etype == REFR_BEGIN:
+            out.append(dict(common, ph="B", tid=TID_LVGL, name="refresh"))
+        elif etype == REFR_END:
+            out.append(dict(common, ph="E", tid=TID_LVGL, args={"areas": a}))
+        elif etype == FLUSH_BEGIN:
+            area = "%d,%d-%d,%d" % (a & 0xFFFF, a >> 16, b & 0xFFFF, b >> 16)
+            out.append(dict(common, ph="B", tid=TID_LVGL, name="flush " + area, args={"last": bool(arg)}))
+        elif etype == FLUSH_END:
+            out.append(dict(common, ph="E", tid=TID_LVGL, args={"bytes": a, "error": bool(arg)}))
+            if not arg:
+                submits.append((ts, a))
+        elif etype == DMA_DONE:
+            if not submits:
+                continue  # Постановка в очередь потерялась вместе с отброшенными событиями
+            submit_us, size = submits.pop(0)
+            # Передача начинается, когда освободилась шина: очередь DMA выполняется по порядку
+            start = max(submit_us, dma_free_us)
+            out.append({"pid": PID, "tid": TID_DMA, "ph": "X", "ts": start, "dur": max(ts - start, 0),
+                        "name": "DMA %d B" % size, "args": {"bytes": size, "queued_us": start - submit_us}})
+            dma_free_us = ts
+            if arg:
+                stats["frames"] += 1
+                out.append(dict(common, ph="i", s="t", tid=TID_DMA, name="frame done"))
+        elif etype == TE:
+            out.append(dict(common, ph="i", s="t", tid=TID_TE, name="TE"))
+        elif etype == HEAP:
+            out.append(dict(common, ph="C", name="heap", args={"free": a, "min_free": b}))
+    return {"traceEvents": out, "displayTimeUnit": "ms"}, stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Display pipeline trace (main/lcd_trace.h) -> Chrome/Perfetto JSON")
+    parser.add_argument("input", nargs="?", help="Trace file (lcd_trace.bin or a raw serial capture)")
+    parser.add_argument("--port", help="Read from a USB-Serial-JTAG port instead of a file")
+    parser.add_argument("--seconds", type=float, default=10, help="Capture time with --port (default: 10)")
+    parser.add_argument("-o", "--output", default="trace.json", help="Output JSON (default: trace.json)")
+    parser.add_argument("--text", help="Save the log text found between packets to this file")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.seconds)
+    elif args.input:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("either a trace file or --port is required")
+
+    packets, text, rejected = parse_stream(data)
+    if not packets:
+        sys.exit("No trace packets in %d bytes (is LCD_TRACE 1?)" % len(data))
+    trace, stats = to_chrome(packets)
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+    if args.text:
+        with open(args.text, "wb") as f:
+            f.write(text)
+    print("%s: %d packets, %d events, %d frames; %d packet gaps, %d events dropped on device, %d bad packets, "
+          "%d bytes of log text" % (args.output, len(packets), stats["events"], stats["frames"], stats["gaps"],
+                                    stats["dropped"], rejected, len(text)))
+
+
+if __name__ == "__main__":
+    main()